@@ -0,0 +1,296 @@
+/*
+ *  MMM"""AMV       db      `7MM"""Yp,
+ *  M'   AMV       ;MM:       MM    Yb
+ *  '   AMV       ,V^MM.      MM    dP
+ *     AMV       ,M  `MM      MM"""bg.
+ *    AMV   ,    AbmmmqMA     MM    `Y
+ *   AMV   ,M   A'     VML    MM    ,9
+ *  AMVmmmmMM .AMA.   .AMMA..JMMmmmd9
+ *
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021 Donald-Rupin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ *  @file bench-buffered_reader.cpp
+ *
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "harness.hpp"
+#include "zab/buffered_reader.hpp"
+
+/**
+ * Splits a buffer of lines on their delimiter the way `buffered_reader::read_until` does, with
+ * the vector scan it uses and with a naive byte at a time scan, to show what the vector scan
+ * is worth at different line lengths. No io is involved.
+ */
+namespace zab::bench {
+
+    enum class mode {
+        kNaive,
+        kVector
+    };
+
+    struct scan_options {
+
+            std::vector<std::size_t>      lengths_    = {16, 80, 1024};
+            std::vector<std::string_view> delimiters_ = {"\n", "\r\n"};
+            std::vector<mode>             modes_      = {mode::kNaive, mode::kVector};
+    };
+
+    std::string_view
+    name(mode _mode) noexcept
+    {
+        return _mode == mode::kNaive ? "naive" : "vector";
+    }
+
+    std::string_view
+    name(std::string_view _delimiter) noexcept
+    {
+        return _delimiter == "\n" ? "lf" : "crlf";
+    }
+
+    bool
+    parse_list(std::string_view _value, std::vector<std::size_t>& _out)
+    {
+        _out.clear();
+        while (_value.size())
+        {
+            auto        comma = _value.find(',');
+            std::size_t value = 0;
+            if (!details::parse_size(_value.substr(0, comma), value) || !value) { return false; }
+
+            _out.push_back(value);
+            _value = comma == std::string_view::npos ? "" : _value.substr(comma + 1);
+        }
+
+        return _out.size();
+    }
+
+    bool
+    parse_delimiters(std::string_view _value, std::vector<std::string_view>& _out)
+    {
+        _out.clear();
+        while (_value.size())
+        {
+            auto comma = _value.find(',');
+            auto token = _value.substr(0, comma);
+
+            if (token == "lf") { _out.push_back("\n"); }
+            else if (token == "crlf")
+            {
+                _out.push_back("\r\n");
+            }
+            else
+            {
+                return false;
+            }
+
+            _value = comma == std::string_view::npos ? "" : _value.substr(comma + 1);
+        }
+
+        return _out.size();
+    }
+
+    bool
+    parse_modes(std::string_view _value, std::vector<mode>& _out)
+    {
+        _out.clear();
+        while (_value.size())
+        {
+            auto comma = _value.find(',');
+            auto token = _value.substr(0, comma);
+
+            if (token == "naive") { _out.push_back(mode::kNaive); }
+            else if (token == "vector")
+            {
+                _out.push_back(mode::kVector);
+            }
+            else
+            {
+                return false;
+            }
+
+            _value = comma == std::string_view::npos ? "" : _value.substr(comma + 1);
+        }
+
+        return _out.size();
+    }
+
+    /**
+     * @brief `_lines` lines of `_length` bytes each, including the delimiter.
+     */
+    std::string
+    make_lines(std::size_t _lines, std::size_t _length, std::string_view _delimiter)
+    {
+        std::string data;
+        data.reserve(_lines * _length);
+
+        auto body = _length > _delimiter.size() ? _length - _delimiter.size() : 0;
+        for (std::size_t i = 0; i < _lines; ++i)
+        {
+            for (std::size_t j = 0; j < body; ++j)
+            {
+                /* Printable, and with a stray '\r' now and then to trip up a crlf scan. */
+                data.push_back(j % 61 == 60 ? '\r' : (char) ('a' + (i + j) % 26));
+            }
+
+            data += _delimiter;
+        }
+
+        return data;
+    }
+
+    /**
+     * @brief Split `_data` into lines, returning how many were found.
+     */
+    std::size_t
+    split(mode _mode, std::span<const std::byte> _data, std::span<const std::byte> _delimiter)
+    {
+        std::size_t lines = 0;
+        while (_data.size())
+        {
+            auto found = _mode == mode::kNaive
+                             ? zab::details::find_delimiter_scalar(_data, _delimiter)
+                             : zab::details::find_delimiter(_data, _delimiter);
+
+            if (found == _data.size()) { break; }
+
+            ++lines;
+            _data = _data.subspan(found + _delimiter.size());
+        }
+
+        return lines;
+    }
+
+    bool
+    run(const options& _options, const scan_options& _scan, std::vector<result>& _results)
+    {
+        for (auto delimiter : _scan.delimiters_)
+        {
+            auto needle = std::as_bytes(std::span(delimiter));
+            for (auto length : _scan.lengths_)
+            {
+                auto data  = make_lines(_options.iterations_, length, delimiter);
+                auto bytes = std::as_bytes(std::span(data));
+
+                for (auto m : _scan.modes_)
+                {
+                    result r;
+                    r.name_    = "scan";
+                    r.threads_ = 1;
+                    r.params_  = {
+                        {"mode", std::string(name(m))},
+                        {"delimiter", std::string(name(delimiter))},
+                        {"length", std::to_string(length)}};
+
+                    for (std::size_t i = 0; i < _options.warmup_ + _options.repetitions_; ++i)
+                    {
+                        auto start = now_ns();
+                        auto lines = split(m, bytes, needle);
+                        auto took  = now_ns() - start;
+
+                        if (lines != _options.iterations_)
+                        {
+                            std::cerr << name(m) << " found " << lines << " lines\n";
+                            return false;
+                        }
+
+                        if (i >= _options.warmup_)
+                        {
+                            r.ns_per_op_.push_back((double) took / _options.iterations_);
+                            r.operations_ += lines;
+                        }
+                    }
+
+                    auto sorted = r.ns_per_op_;
+                    std::sort(sorted.begin(), sorted.end());
+                    r.metrics_.emplace_back("GB/s", length / sorted[sorted.size() / 2]);
+
+                    _results.push_back(std::move(r));
+                }
+            }
+        }
+
+        return true;
+    }
+
+}   // namespace zab::bench
+
+int
+main(int _argc, char** _argv)
+{
+    using namespace zab::bench;
+
+    options                                          opts;
+    scan_options                                     scan_opts;
+    std::vector<std::pair<std::string, std::string>> rest;
+
+    opts.iterations_ = 100'000;
+
+    bool ok = parse_options(_argc, _argv, opts, &rest);
+    for (const auto& [key, value] : rest)
+    {
+        if (!ok) { break; }
+
+        if (key == "lengths") { ok = parse_list(value, scan_opts.lengths_); }
+        else if (key == "delimiters")
+        {
+            ok = parse_delimiters(value, scan_opts.delimiters_);
+        }
+        else if (key == "modes")
+        {
+            ok = parse_modes(value, scan_opts.modes_);
+        }
+        else
+        {
+            ok = false;
+        }
+    }
+
+    if (!ok)
+    {
+        print_usage(
+            _argv[0],
+            "  --lengths=N,..      line lengths in bytes to sweep (default 16,80,1024)\n"
+            "  --delimiters=D,..   any of lf,crlf (default both)\n"
+            "  --modes=M,..        any of naive,vector (default both)\n"
+            "  --iterations is the number of lines per run (default 100000). --threads is\n"
+            "  ignored, the scan runs on the calling thread.\n");
+        return 1;
+    }
+
+    std::cout << "vector scan: " << zab::details::delimiter_scan_name() << "\n";
+
+    std::vector<result> results;
+    if (!run(opts, scan_opts, results)) { return 1; }
+
+    return report(opts, results);
+}
@@ -0,0 +1,501 @@
+/*
+ *  MMM"""AMV       db      `7MM"""Yp,
+ *  M'   AMV       ;MM:       MM    Yb
+ *  '   AMV       ,V^MM.      MM    dP
+ *     AMV       ,M  `MM      MM"""bg.
+ *    AMV   ,    AbmmmqMA     MM    `Y
+ *   AMV   ,M   A'     VML    MM    ,9
+ *  AMVmmmmMM .AMA.   .AMMA..JMMmmmd9
+ *
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021 Donald-Rupin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ *  @file bench-file_io.cpp
+ *
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <fcntl.h>
+#include <iostream>
+#include <memory>
+#include <span>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include "harness.hpp"
+#include "zab/async_file.hpp"
+#include "zab/async_function.hpp"
+#include "zab/async_latch.hpp"
+#include "zab/engine.hpp"
+#include "zab/engine_enabled.hpp"
+#include "zab/simple_future.hpp"
+
+/**
+ * Sequential and random reads and writes through `async_file` on one event loop, in the spirit
+ * of a single fio job. `--depths` coroutines keep that many operations in flight at once. Each
+ * configuration runs buffered and with O_DIRECT; O_DIRECT is skipped where the file system does
+ * not support it (tmpfs).
+ */
+namespace zab::bench {
+
+    enum class pattern {
+        kSequentialRead,
+        kRandomRead,
+        kSequentialWrite,
+        kRandomWrite
+    };
+
+    struct file_options {
+
+            std::string              path_      = "zab-bench-file_io.tmp";
+            std::size_t              file_size_ = 64 * 1024 * 1024;
+            std::vector<std::size_t> blocks_    = {4096, 65536};
+            std::vector<std::size_t> depths_    = {1, 8, 32};
+            std::vector<pattern>     patterns_  = {
+                pattern::kSequentialRead,
+                pattern::kRandomRead,
+                pattern::kSequentialWrite,
+                pattern::kRandomWrite};
+            std::vector<std::size_t> direct_ = {0, 1};
+    };
+
+    inline constexpr std::size_t kAlignment = 4096;
+
+    std::string_view
+    name(pattern _pattern) noexcept
+    {
+        switch (_pattern)
+        {
+            case pattern::kSequentialRead:
+                return "seqread";
+            case pattern::kRandomRead:
+                return "randread";
+            case pattern::kSequentialWrite:
+                return "seqwrite";
+            case pattern::kRandomWrite:
+                return "randwrite";
+        }
+
+        return "";
+    }
+
+    bool
+    is_read(pattern _pattern) noexcept
+    {
+        return _pattern == pattern::kSequentialRead || _pattern == pattern::kRandomRead;
+    }
+
+    bool
+    is_random(pattern _pattern) noexcept
+    {
+        return _pattern == pattern::kRandomRead || _pattern == pattern::kRandomWrite;
+    }
+
+    bool
+    parse_list(std::string_view _value, std::vector<std::size_t>& _out, bool _allow_zero = false)
+    {
+        _out.clear();
+        while (_value.size())
+        {
+            auto        comma = _value.find(',');
+            std::size_t value = 0;
+            if (!details::parse_size(_value.substr(0, comma), value) || (!value && !_allow_zero))
+            {
+                return false;
+            }
+
+            _out.push_back(value);
+            _value = comma == std::string_view::npos ? "" : _value.substr(comma + 1);
+        }
+
+        return _out.size();
+    }
+
+    bool
+    parse_patterns(std::string_view _value, std::vector<pattern>& _out)
+    {
+        _out.clear();
+        while (_value.size())
+        {
+            auto comma = _value.find(',');
+            auto token = _value.substr(0, comma);
+
+            bool found = false;
+            for (auto p :
+                 {pattern::kSequentialRead,
+                  pattern::kRandomRead,
+                  pattern::kSequentialWrite,
+                  pattern::kRandomWrite})
+            {
+                if (token == name(p))
+                {
+                    _out.push_back(p);
+                    found = true;
+                }
+            }
+
+            if (!found) { return false; }
+
+            _value = comma == std::string_view::npos ? "" : _value.substr(comma + 1);
+        }
+
+        return _out.size();
+    }
+
+    struct aligned_free {
+
+            void
+            operator()(std::byte* _ptr) const noexcept
+            {
+                std::free(_ptr);
+            }
+    };
+
+    using aligned_buffer = std::unique_ptr<std::byte[], aligned_free>;
+
+    aligned_buffer
+    make_buffer(std::size_t _size)
+    {
+        auto size = (_size + kAlignment - 1) / kAlignment * kAlignment;
+        auto ptr  = static_cast<std::byte*>(std::aligned_alloc(kAlignment, size));
+        std::fill(ptr, ptr + size, std::byte{'z'});
+        return aligned_buffer(ptr);
+    }
+
+    class file_io : public engine_enabled<file_io> {
+
+        public:
+
+            static constexpr auto kDefaultThread = 0;
+
+            file_io(const options& _options, const file_options& _file)
+                : options_(_options), file_(_file)
+            { }
+
+            void
+            initialise() noexcept
+            {
+                run();
+            }
+
+            const std::vector<result>&
+            results() const noexcept
+            {
+                return results_;
+            }
+
+            bool
+            failed() const noexcept
+            {
+                return failed_;
+            }
+
+        private:
+
+            struct job {
+
+                    async_file<std::byte>* file_;
+                    pattern                pattern_;
+                    std::size_t            block_;
+                    std::size_t            blocks_in_file_;
+                    std::size_t            operations_;
+                    std::size_t            issued_ = 0;
+                    context*               ctx_;
+            };
+
+            async_function<>
+            run() noexcept
+            {
+                if (co_await prepare())
+                {
+                    for (auto direct : file_.direct_)
+                    {
+                        for (auto p : file_.patterns_)
+                        {
+                            for (auto block : file_.blocks_)
+                            {
+                                for (auto depth : file_.depths_)
+                                {
+                                    if (failed_) { break; }
+                                    co_await run_config(p, block, depth, direct);
+                                }
+                            }
+                        }
+                    }
+                }
+
+                ::unlink(file_.path_.c_str());
+                engine_->stop();
+            }
+
+            /**
+             * Lay the file out in full so that reads hit real blocks.
+             */
+            guaranteed_future<bool>
+            prepare() noexcept
+            {
+                static constexpr std::size_t kChunk = 1024 * 1024;
+
+                async_file<std::byte> file(engine_);
+                if (!co_await file.open(file_.path_, O_CREAT | O_RDWR | O_TRUNC, 0600))
+                {
+                    std::cerr << "Failed to create " << file_.path_ << "\n";
+                    failed_ = true;
+                    co_return false;
+                }
+
+                auto buffer = make_buffer(kChunk);
+                for (std::size_t offset = 0; offset < file_.file_size_; offset += kChunk)
+                {
+                    auto amount  = std::min(kChunk, file_.file_size_ - offset);
+                    auto written = co_await file.write_at({buffer.get(), amount}, offset);
+                    if (!written || *written != amount)
+                    {
+                        std::cerr << "Failed to lay out " << file_.path_ << "\n";
+                        failed_ = true;
+                        break;
+                    }
+                }
+
+                co_await file.close();
+
+                co_return !failed_;
+            }
+
+            simple_future<>
+            run_config(pattern _pattern, std::size_t _block, std::size_t _depth, bool _direct) noexcept
+            {
+                if (_direct && _block % kAlignment)
+                {
+                    std::cerr << "Skipping O_DIRECT for unaligned block size " << _block << "\n";
+                    co_return;
+                }
+
+                async_file<std::byte> file(engine_);
+                int flags = (is_read(_pattern) ? O_RDONLY : O_WRONLY) | (_direct ? O_DIRECT : 0);
+                if (!co_await file.open(file_.path_, flags, 0))
+                {
+                    std::cerr << "Skipping " << name(_pattern) << (_direct ? " O_DIRECT" : "")
+                              << ": open failed\n";
+                    co_return;
+                }
+
+                result r;
+                r.name_    = "async_file";
+                r.threads_ = 1;
+                r.params_  = {
+                    {"pattern", std::string(name(_pattern))},
+                    {"block", std::to_string(_block)},
+                    {"depth", std::to_string(_depth)},
+                    {"direct", _direct ? "1" : "0"}};
+
+                job j{
+                    .file_           = &file,
+                    .pattern_        = _pattern,
+                    .block_          = _block,
+                    .blocks_in_file_ = std::max<std::size_t>(1, file_.file_size_ / _block),
+                    .operations_     = options_.iterations_,
+                    .ctx_            = nullptr};
+
+                for (std::size_t i = 0; i < options_.warmup_; ++i)
+                {
+                    co_await run_once(j, _depth);
+                }
+
+                context       ctx(engine_, options_.iterations_);
+                std::uint64_t elapsed = 0;
+                j.ctx_                = &ctx;
+                for (std::size_t i = 0; i < options_.repetitions_ && !failed_; ++i)
+                {
+                    auto took = co_await run_once(j, _depth);
+                    elapsed += took;
+
+                    r.operations_ = j.operations_;
+                    r.ns_per_op_.push_back((double) took / j.operations_);
+                }
+
+                double iops = (double) options_.repetitions_ * j.operations_ * 1e9 /
+                              std::max<std::uint64_t>(1, elapsed);
+
+                r.metrics_ = {{"iops", iops}, {"MBps", iops * _block / 1e6}};
+                r.latency_ = co_await ctx.latency();
+
+                co_await file.close();
+
+                results_.push_back(std::move(r));
+            }
+
+            guaranteed_future<std::uint64_t>
+            run_once(job& _job, std::size_t _depth) noexcept
+            {
+                _job.issued_ = 0;
+
+                async_latch done(engine_, _depth + 1);
+
+                auto start = now_ns();
+                for (std::size_t i = 0; i < _depth; ++i)
+                {
+                    worker(_job, i, done);
+                }
+
+                co_await done.arrive_and_wait();
+
+                co_return now_ns() - start;
+            }
+
+            async_function<>
+            worker(job& _job, std::size_t _seed, async_latch& _done) noexcept
+            {
+                auto          buffer = make_buffer(_job.block_);
+                std::uint64_t state  = 0x9E3779B97F4A7C15ull * (_seed + 1);
+
+                /* Every worker takes the next operation, so the depth stays full until the end. */
+                while (_job.issued_ < _job.operations_ && !failed_)
+                {
+                    auto index = _job.issued_++;
+
+                    std::size_t block;
+                    if (is_random(_job.pattern_))
+                    {
+                        state ^= state << 13;
+                        state ^= state >> 7;
+                        state ^= state << 17;
+                        block = state % _job.blocks_in_file_;
+                    }
+                    else
+                    {
+                        block = index % _job.blocks_in_file_;
+                    }
+
+                    off_t offset = (off_t) (block * _job.block_);
+
+                    auto                       start = now_ns();
+                    std::optional<std::size_t> amount;
+                    if (is_read(_job.pattern_))
+                    {
+                        amount = co_await _job.file_->read_at({buffer.get(), _job.block_}, offset);
+                    }
+                    else
+                    {
+                        amount = co_await _job.file_->write_at({buffer.get(), _job.block_}, offset);
+                    }
+
+                    if (!amount || *amount != _job.block_)
+                    {
+                        std::cerr << name(_job.pattern_) << " failed at offset " << offset << "\n";
+                        failed_ = true;
+                        break;
+                    }
+
+                    if (_job.ctx_) { _job.ctx_->record(now_ns() - start); }
+                }
+
+                _done.count_down();
+            }
+
+            const options&      options_;
+            const file_options& file_;
+            std::vector<result> results_;
+            bool                failed_ = false;
+    };
+
+}   // namespace zab::bench
+
+int
+main(int _argc, char** _argv)
+{
+    using namespace zab::bench;
+
+    options                                          opts;
+    file_options                                     file_opts;
+    std::vector<std::pair<std::string, std::string>> rest;
+
+    opts.iterations_  = 20'000;
+    opts.repetitions_ = 3;
+
+    bool ok = parse_options(_argc, _argv, opts, &rest);
+    for (const auto& [key, value] : rest)
+    {
+        if (!ok) { break; }
+
+        if (key == "file") { file_opts.path_ = value; }
+        else if (key == "size")
+        {
+            ok = details::parse_size(value, file_opts.file_size_) && file_opts.file_size_;
+            file_opts.file_size_ *= 1024 * 1024;
+        }
+        else if (key == "blocks")
+        {
+            ok = parse_list(value, file_opts.blocks_);
+        }
+        else if (key == "depths")
+        {
+            ok = parse_list(value, file_opts.depths_);
+        }
+        else if (key == "patterns")
+        {
+            ok = parse_patterns(value, file_opts.patterns_);
+        }
+        else if (key == "direct")
+        {
+            ok = parse_list(value, file_opts.direct_, true);
+        }
+        else
+        {
+            ok = false;
+        }
+    }
+
+    if (!ok)
+    {
+        print_usage(
+            _argv[0],
+            "  --file=PATH         the temporary file to use (default ./zab-bench-file_io.tmp)\n"
+            "  --size=N            the file size in MiB (default 64)\n"
+            "  --blocks=N,..       block sizes in bytes to sweep (default 4096,65536)\n"
+            "  --depths=N,..       operations in flight to sweep (default 1,8,32)\n"
+            "  --patterns=P,..     any of seqread,randread,seqwrite,randwrite (default all)\n"
+            "  --direct=0,1        buffered (0) and/or O_DIRECT (1) (default both)\n"
+            "  --iterations is the number of operations per run. --threads is ignored, every\n"
+            "  run uses one event loop.\n");
+        return 1;
+    }
+
+    zab::engine engine(zab::engine::configs{
+        .threads_         = 1,
+        .opt_             = zab::engine::configs::kExact,
+        .affinity_set_    = false,
+        .affinity_offset_ = 0});
+
+    file_io bench(opts, file_opts);
+    bench.register_engine(engine);
+
+    engine.start();
+
+    if (report(opts, bench.results())) { return 1; }
+
+    return bench.failed() ? 1 : 0;
+}
@@ -0,0 +1,200 @@
+/*
+ *  MMM"""AMV       db      `7MM"""Yp,
+ *  M'   AMV       ;MM:       MM    Yb
+ *  '   AMV       ,V^MM.      MM    dP
+ *     AMV       ,M  `MM      MM"""bg.
+ *    AMV   ,    AbmmmqMA     MM    `Y
+ *   AMV   ,M   A'     VML    MM    ,9
+ *  AMVmmmmMM .AMA.   .AMMA..JMMmmmd9
+ *
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021 Donald-Rupin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ *  @file bench-primitives.cpp
+ *
+ */
+
+#include <chrono>
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <string_view>
+
+#include "zab/async_function.hpp"
+#include "zab/async_latch.hpp"
+#include "zab/async_mutex.hpp"
+#include "zab/async_semaphore.hpp"
+#include "zab/engine.hpp"
+#include "zab/engine_enabled.hpp"
+#include "zab/observable.hpp"
+#include "zab/simple_future.hpp"
+#include "zab/threading.hpp"
+
+/**
+ * Exercises the uncontended paths of the synchronisation primitives from a single worker.
+ * Build it against `zab` and `zab_single_threaded` and compare the ns/op columns.
+ */
+namespace zab::bench {
+
+    static constexpr std::size_t kIterations = 1'000'000;
+
+    class primitives : public engine_enabled<primitives> {
+
+        public:
+
+            static constexpr auto kDefaultThread = 0;
+
+            void
+            initialise() noexcept
+            {
+                run();
+            }
+
+            async_function<>
+            run() noexcept
+            {
+                std::cout << "mode: " << (kSingleThreaded ? "single_threaded" : "multi_threaded")
+                          << "\n";
+
+                co_await bench_mutex();
+                co_await bench_semaphore();
+                co_await bench_latch();
+                co_await bench_yield();
+                co_await bench_observable();
+
+                engine_->stop();
+            }
+
+        private:
+
+            using clock = std::chrono::steady_clock;
+
+            static void
+            report(std::string_view _name, clock::time_point _start, std::size_t _ops) noexcept
+            {
+                auto elapsed =
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - _start);
+
+                std::cout << std::setw(12) << _name << std::setw(12) << std::fixed
+                          << std::setprecision(2) << (double) elapsed.count() / (double) _ops
+                          << " ns/op\n";
+            }
+
+            simple_future<>
+            bench_mutex() noexcept
+            {
+                async_mutex mtx(engine_);
+
+                auto start = clock::now();
+                for (std::size_t i = 0; i < kIterations; ++i)
+                {
+                    auto lck = co_await mtx;
+                }
+
+                report("mutex", start, kIterations);
+            }
+
+            simple_future<>
+            bench_semaphore() noexcept
+            {
+                async_counting_semaphore<4> sem(engine_);
+
+                auto start = clock::now();
+                for (std::size_t i = 0; i < kIterations; ++i)
+                {
+                    co_await sem;
+                    sem.release();
+                }
+
+                report("semaphore", start, kIterations);
+            }
+
+            simple_future<>
+            bench_latch() noexcept
+            {
+                async_latch latch(engine_, kIterations);
+
+                auto start = clock::now();
+                for (std::size_t i = 0; i < kIterations; ++i)
+                {
+                    latch.count_down();
+                }
+
+                co_await latch.wait();
+
+                report("latch", start, kIterations);
+            }
+
+            simple_future<>
+            bench_yield() noexcept
+            {
+                static constexpr std::size_t kYields = kIterations / 10;
+
+                auto start = clock::now();
+                for (std::size_t i = 0; i < kYields; ++i)
+                {
+                    co_await yield();
+                }
+
+                report("yield", start, kYields);
+            }
+
+            simple_future<>
+            bench_observable() noexcept
+            {
+                static constexpr std::size_t kEvents = kIterations / 10;
+
+                observable<std::size_t> ob(engine_);
+                auto                    connection = co_await ob.connect();
+
+                auto start = clock::now();
+                for (std::size_t i = 0; i < kEvents; ++i)
+                {
+                    ob.async_emit(i);
+                    auto guard = co_await connection;
+                }
+
+                report("observable", start, kEvents);
+
+                co_await ob.disconnect(connection);
+            }
+    };
+
+}   // namespace zab::bench
+
+int
+main()
+{
+    zab::engine engine(zab::engine::configs{
+        .threads_         = 1,
+        .opt_             = zab::engine::configs::kExact,
+        .affinity_set_    = false,
+        .affinity_offset_ = 0});
+
+    zab::bench::primitives bench;
+    bench.register_engine(engine);
+
+    engine.start();
+
+    return 0;
+}
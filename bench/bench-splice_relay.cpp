@@ -0,0 +1,431 @@
+/*
+ *  MMM"""AMV       db      `7MM"""Yp,
+ *  M'   AMV       ;MM:       MM    Yb
+ *  '   AMV       ,V^MM.      MM    dP
+ *     AMV       ,M  `MM      MM"""bg.
+ *    AMV   ,    AbmmmqMA     MM    `Y
+ *   AMV   ,M   A'     VML    MM    ,9
+ *  AMVmmmmMM .AMA.   .AMMA..JMMmmmd9
+ *
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021 Donald-Rupin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ *  @file bench-splice_relay.cpp
+ *
+ */
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <netinet/in.h>
+#include <span>
+#include <string>
+#include <sys/socket.h>
+#include <vector>
+
+#include "harness.hpp"
+#include "zab/async_function.hpp"
+#include "zab/async_latch.hpp"
+#include "zab/engine.hpp"
+#include "zab/engine_enabled.hpp"
+#include "zab/simple_future.hpp"
+#include "zab/splice.hpp"
+#include "zab/tcp_networking.hpp"
+#include "zab/tcp_stream.hpp"
+
+/**
+ * A source streams `--total` MiB through a relay to a sink, all over loopback on one event loop.
+ * The relay either copies through a user space buffer with `read_some` and `write`, or splices
+ * through a pipe with `zab::splice`. `--sizes` sweeps the size of the source's writes, which is
+ * also the relay's buffer size when copying.
+ */
+namespace zab::bench {
+
+    enum class mode {
+        kCopy,
+        kSplice
+    };
+
+    struct relay_options {
+
+            std::size_t              total_ = 256 * 1024 * 1024;
+            std::vector<std::size_t> sizes_ = {4096, 65536};
+            std::vector<mode>        modes_ = {mode::kCopy, mode::kSplice};
+    };
+
+    std::string_view
+    name(mode _mode) noexcept
+    {
+        return _mode == mode::kCopy ? "copy" : "splice";
+    }
+
+    bool
+    parse_list(std::string_view _value, std::vector<std::size_t>& _out)
+    {
+        _out.clear();
+        while (_value.size())
+        {
+            auto        comma = _value.find(',');
+            std::size_t value = 0;
+            if (!details::parse_size(_value.substr(0, comma), value) || !value) { return false; }
+
+            _out.push_back(value);
+            _value = comma == std::string_view::npos ? "" : _value.substr(comma + 1);
+        }
+
+        return _out.size();
+    }
+
+    bool
+    parse_modes(std::string_view _value, std::vector<mode>& _out)
+    {
+        _out.clear();
+        while (_value.size())
+        {
+            auto comma = _value.find(',');
+            auto token = _value.substr(0, comma);
+
+            if (token == "copy") { _out.push_back(mode::kCopy); }
+            else if (token == "splice")
+            {
+                _out.push_back(mode::kSplice);
+            }
+            else
+            {
+                return false;
+            }
+
+            _value = comma == std::string_view::npos ? "" : _value.substr(comma + 1);
+        }
+
+        return _out.size();
+    }
+
+    class splice_relay : public engine_enabled<splice_relay> {
+
+        public:
+
+            static constexpr auto kDefaultThread = 0;
+
+            splice_relay(const options& _options, const relay_options& _relay)
+                : options_(_options), relay_(_relay)
+            { }
+
+            void
+            initialise() noexcept
+            {
+                run();
+            }
+
+            const std::vector<result>&
+            results() const noexcept
+            {
+                return results_;
+            }
+
+            bool
+            failed() const noexcept
+            {
+                return failed_;
+            }
+
+        private:
+
+            async_function<>
+            run() noexcept
+            {
+                for (auto size : relay_.sizes_)
+                {
+                    for (auto m : relay_.modes_)
+                    {
+                        co_await run_config(m, size);
+                        if (failed_) { break; }
+                    }
+                }
+
+                engine_->stop();
+            }
+
+            simple_future<>
+            run_config(mode _mode, std::size_t _size) noexcept
+            {
+                result r;
+                r.name_    = "relay";
+                r.threads_ = 1;
+                r.params_  = {{"mode", std::string(name(_mode))}, {"size", std::to_string(_size)}};
+
+                auto mebibytes = relay_.total_ / (1024 * 1024);
+                for (std::size_t i = 0; i < options_.warmup_ + options_.repetitions_; ++i)
+                {
+                    auto elapsed = co_await run_once(_mode, _size);
+                    if (failed_) { co_return; }
+
+                    if (i >= options_.warmup_)
+                    {
+                        r.operations_ = mebibytes;
+                        r.ns_per_op_.push_back((double) elapsed / mebibytes);
+                    }
+                }
+
+                auto sorted = r.ns_per_op_;
+                std::sort(sorted.begin(), sorted.end());
+                r.metrics_ = {{"MiBps", 1e9 / sorted[sorted.size() / 2]}};
+
+                results_.push_back(std::move(r));
+            }
+
+            /**
+             * Connect a source to the relay and the relay to a sink, and time from the first
+             * write until the sink has everything.
+             */
+            guaranteed_future<std::uint64_t>
+            run_once(mode _mode, std::size_t _size) noexcept
+            {
+                tcp_acceptor front(engine_);
+                tcp_acceptor back(engine_);
+                if (!front.listen(AF_INET, 0, 1) || !back.listen(AF_INET, 0, 1))
+                {
+                    std::cerr << "listen failed\n";
+                    failed_ = true;
+                    co_return 0;
+                }
+
+                async_latch   done(engine_, 4);
+                std::uint64_t start = 0;
+                std::uint64_t end   = 0;
+
+                sink(back, end, done);
+                relay(_mode, _size, front, address_of(back), done);
+                source(address_of(front), _size, start, done);
+
+                co_await done.arrive_and_wait();
+
+                co_return end - start;
+            }
+
+            static struct sockaddr_in
+            address_of(const tcp_acceptor& _acceptor) noexcept
+            {
+                struct sockaddr_in address;
+                socklen_t          length = sizeof(address);
+                ::getsockname(_acceptor.descriptor(), (struct sockaddr*) &address, &length);
+                address.sin_addr.s_addr = ::htonl(INADDR_LOOPBACK);
+                return address;
+            }
+
+            async_function<>
+            source(
+                struct sockaddr_in _address,
+                std::size_t        _size,
+                std::uint64_t&     _start,
+                async_latch&       _done) noexcept
+            {
+                auto stream = co_await tcp_connect(
+                    engine_,
+                    (struct sockaddr*) &_address,
+                    sizeof(_address));
+
+                std::vector<std::byte> buffer(_size, std::byte{'z'});
+
+                _start = now_ns();
+                for (std::size_t sent = 0; sent < relay_.total_; sent += _size)
+                {
+                    auto amount = std::min(_size, relay_.total_ - sent);
+                    if (co_await stream.write({buffer.data(), amount}) != (long long) amount)
+                    {
+                        std::cerr << "source write failed: " << stream.last_error() << "\n";
+                        failed_ = true;
+                        break;
+                    }
+                }
+
+                /* Wait for the relay to pass on the sink's end of stream. */
+                ::shutdown(stream.descriptor(), SHUT_WR);
+                while (co_await stream.read_some(buffer) > 0) { }
+
+                co_await stream.close();
+                _done.count_down();
+            }
+
+            async_function<>
+            relay(
+                mode               _mode,
+                std::size_t        _size,
+                tcp_acceptor&      _front,
+                struct sockaddr_in _back,
+                async_latch&       _done) noexcept
+            {
+                struct sockaddr_storage address;
+                socklen_t               length = sizeof(address);
+
+                auto front = co_await _front.accept((struct sockaddr*) &address, &length);
+                auto back  = co_await tcp_connect(
+                    engine_,
+                    (struct sockaddr*) &_back,
+                    sizeof(_back));
+
+                if (!front)
+                {
+                    std::cerr << "accept failed: " << _front.last_error() << "\n";
+                    failed_ = true;
+                }
+                else if (_mode == mode::kSplice)
+                {
+                    auto moved = co_await splice(*front, back);
+                    failed_ |= moved.error_ != 0 || moved.to_second_ != (long long) relay_.total_;
+                }
+                else
+                {
+                    /* Only the source sends, so copying one way is enough. */
+                    std::vector<std::byte> buffer(_size);
+                    while (true)
+                    {
+                        auto amount = co_await front->read_some(buffer);
+                        if (amount <= 0) { break; }
+
+                        auto data = std::span<const std::byte>(buffer.data(), amount);
+                        if (co_await back.write(data) != amount)
+                        {
+                            failed_ = true;
+                            break;
+                        }
+                    }
+
+                    ::shutdown(back.descriptor(), SHUT_WR);
+                    while (co_await back.read_some(buffer) > 0) { }
+                    ::shutdown(front->descriptor(), SHUT_WR);
+                }
+
+                if (front) { co_await front->close(); }
+                co_await back.close();
+                _done.count_down();
+            }
+
+            async_function<>
+            sink(tcp_acceptor& _back, std::uint64_t& _end, async_latch& _done) noexcept
+            {
+                struct sockaddr_storage address;
+                socklen_t               length = sizeof(address);
+
+                auto stream = co_await _back.accept((struct sockaddr*) &address, &length);
+                if (!stream)
+                {
+                    std::cerr << "accept failed: " << _back.last_error() << "\n";
+                    failed_ = true;
+                    _done.count_down();
+                    co_return;
+                }
+
+                std::vector<std::byte> buffer(256 * 1024);
+                std::size_t            received = 0;
+                while (true)
+                {
+                    auto amount = co_await stream->read_some(buffer);
+                    if (amount <= 0) { break; }
+
+                    received += amount;
+                }
+
+                _end = now_ns();
+                if (received != relay_.total_)
+                {
+                    std::cerr << "sink received " << received << " bytes\n";
+                    failed_ = true;
+                }
+
+                ::shutdown(stream->descriptor(), SHUT_WR);
+                co_await stream->close();
+                _done.count_down();
+            }
+
+            const options&       options_;
+            const relay_options& relay_;
+            std::vector<result>  results_;
+            bool                 failed_ = false;
+    };
+
+}   // namespace zab::bench
+
+int
+main(int _argc, char** _argv)
+{
+    using namespace zab::bench;
+
+    options                                          opts;
+    relay_options                                    relay_opts;
+    std::vector<std::pair<std::string, std::string>> rest;
+
+    opts.repetitions_ = 3;
+
+    bool ok = parse_options(_argc, _argv, opts, &rest);
+    for (const auto& [key, value] : rest)
+    {
+        if (!ok) { break; }
+
+        if (key == "total")
+        {
+            ok = details::parse_size(value, relay_opts.total_) && relay_opts.total_;
+            relay_opts.total_ *= 1024 * 1024;
+        }
+        else if (key == "sizes")
+        {
+            ok = parse_list(value, relay_opts.sizes_);
+        }
+        else if (key == "modes")
+        {
+            ok = parse_modes(value, relay_opts.modes_);
+        }
+        else
+        {
+            ok = false;
+        }
+    }
+
+    if (!ok)
+    {
+        print_usage(
+            _argv[0],
+            "  --total=N           MiB to relay per run (default 256)\n"
+            "  --sizes=N,..        write sizes in bytes to sweep (default 4096,65536)\n"
+            "  --modes=M,..        any of copy,splice (default both)\n"
+            "  --iterations and --threads are ignored, every run uses one event loop.\n");
+        return 1;
+    }
+
+    zab::engine engine(zab::engine::configs{
+        .threads_         = 1,
+        .opt_             = zab::engine::configs::kExact,
+        .affinity_set_    = false,
+        .affinity_offset_ = 0});
+
+    splice_relay bench(opts, relay_opts);
+    bench.register_engine(engine);
+
+    engine.start();
+
+    if (report(opts, bench.results())) { return 1; }
+
+    return bench.failed() ? 1 : 0;
+}
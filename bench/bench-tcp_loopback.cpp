@@ -0,0 +1,487 @@
+/*
+ *  MMM"""AMV       db      `7MM"""Yp,
+ *  M'   AMV       ;MM:       MM    Yb
+ *  '   AMV       ,V^MM.      MM    dP
+ *     AMV       ,M  `MM      MM"""bg.
+ *    AMV   ,    AbmmmqMA     MM    `Y
+ *   AMV   ,M   A'     VML    MM    ,9
+ *  AMVmmmmMM .AMA.   .AMMA..JMMmmmd9
+ *
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021 Donald-Rupin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ *  @file bench-tcp_loopback.cpp
+ *
+ */
+
+#include <arpa/inet.h>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <iostream>
+#include <netinet/in.h>
+#include <span>
+#include <string>
+#include <sys/socket.h>
+#include <vector>
+
+#include "harness.hpp"
+#include "zab/async_function.hpp"
+#include "zab/async_latch.hpp"
+#include "zab/async_semaphore.hpp"
+#include "zab/engine.hpp"
+#include "zab/engine_enabled.hpp"
+#include "zab/simple_future.hpp"
+#include "zab/tcp_networking.hpp"
+#include "zab/tcp_stream.hpp"
+#include "zab/timer_service.hpp"
+#include "zab/yield.hpp"
+
+/**
+ * An echo server and a load generator over loopback, both driven by zab.
+ *
+ * Each configuration (connections, message size, pipelining depth) is first run closed loop to
+ * find the maximum request rate. It is then run open loop at `--load` of that rate (or at
+ * `--rate`). In the open loop every request has an intended send time on a fixed schedule and
+ * its latency is measured from that time, not from when it was actually sent. A stalled server
+ * then shows up in the latencies of every request it delayed instead of only in the one that
+ * was in flight (coordinated omission).
+ */
+namespace zab::bench {
+
+    struct loopback_options {
+
+            std::vector<std::size_t> connections_ = {1, 8, 32};
+            std::vector<std::size_t> sizes_       = {64, 4096};
+            std::vector<std::size_t> depths_      = {1, 16};
+            double                   rate_        = 0;
+            double                   load_        = 0.75;
+    };
+
+    bool
+    parse_list(std::string_view _value, std::vector<std::size_t>& _out)
+    {
+        _out.clear();
+        while (_value.size())
+        {
+            auto        comma = _value.find(',');
+            std::size_t value = 0;
+            if (!details::parse_size(_value.substr(0, comma), value) || !value) { return false; }
+
+            _out.push_back(value);
+            _value = comma == std::string_view::npos ? "" : _value.substr(comma + 1);
+        }
+
+        return _out.size();
+    }
+
+    class loopback : public engine_enabled<loopback> {
+
+        public:
+
+            static constexpr auto kDefaultThread = 0;
+
+            loopback(const options& _options, const loopback_options& _loopback)
+                : options_(_options), loopback_(_loopback)
+            { }
+
+            void
+            initialise() noexcept
+            {
+                run();
+            }
+
+            const std::vector<result>&
+            results() const noexcept
+            {
+                return results_;
+            }
+
+            bool
+            failed() const noexcept
+            {
+                return failed_;
+            }
+
+        private:
+
+            struct run_stats {
+
+                    std::uint64_t elapsed_ns_ = 0;
+                    std::size_t   requests_   = 0;
+            };
+
+            async_function<>
+            run() noexcept
+            {
+                for (auto connections : loopback_.connections_)
+                {
+                    for (auto size : loopback_.sizes_)
+                    {
+                        for (auto depth : loopback_.depths_)
+                        {
+                            co_await run_config(connections, size, depth);
+                            if (failed_) { break; }
+                        }
+                    }
+                }
+
+                engine_->stop();
+            }
+
+            simple_future<>
+            run_config(std::size_t _connections, std::size_t _size, std::size_t _depth) noexcept
+            {
+                result r;
+                r.name_    = "tcp_echo";
+                r.threads_ = engine_->number_of_workers();
+                r.params_  = {
+                    {"connections", std::to_string(_connections)},
+                    {"size", std::to_string(_size)},
+                    {"depth", std::to_string(_depth)}};
+
+                /* Closed loop to find the saturation rate. */
+                auto max = co_await run_once(_connections, _size, _depth, 0, nullptr);
+                if (failed_) { co_return; }
+
+                double max_rps = max.requests_ * 1e9 / std::max<std::uint64_t>(1, max.elapsed_ns_);
+                double rate    = loopback_.rate_ ? loopback_.rate_ : max_rps * loopback_.load_;
+
+                for (std::size_t i = 0; i < options_.warmup_; ++i)
+                {
+                    co_await run_once(_connections, _size, _depth, rate, nullptr);
+                }
+
+                context       ctx(engine_, options_.iterations_);
+                std::uint64_t elapsed  = 0;
+                std::size_t   requests = 0;
+                for (std::size_t i = 0; i < options_.repetitions_ && !failed_; ++i)
+                {
+                    auto stats = co_await run_once(_connections, _size, _depth, rate, &ctx);
+                    elapsed += stats.elapsed_ns_;
+                    requests += stats.requests_;
+
+                    r.operations_ = stats.requests_;
+                    r.ns_per_op_.push_back(
+                        (double) stats.elapsed_ns_ / std::max<std::size_t>(1, stats.requests_));
+                }
+
+                double rps = requests * 1e9 / std::max<std::uint64_t>(1, elapsed);
+
+                r.metrics_ = {
+                    {"max_rps", max_rps},
+                    {"max_MBps", max_rps * _size / 1e6},
+                    {"target_rps", rate},
+                    {"rps", rps},
+                    {"MBps", rps * _size / 1e6}};
+                r.latency_ = co_await ctx.latency();
+
+                results_.push_back(std::move(r));
+            }
+
+            /**
+             * Connect every client, release them at once and wait for all of them and their
+             * server side streams to finish. A `_rate` of 0 runs closed loop.
+             */
+            guaranteed_future<run_stats>
+            run_once(
+                std::size_t _connections,
+                std::size_t _size,
+                std::size_t _depth,
+                double      _rate,
+                context*    _ctx) noexcept
+            {
+                tcp_acceptor acceptor(engine_);
+                if (!acceptor.listen(AF_INET, 0, (int) _connections))
+                {
+                    std::cerr << "listen failed: " << acceptor.last_error() << "\n";
+                    failed_ = true;
+                    co_return run_stats{};
+                }
+
+                struct sockaddr_in address;
+                socklen_t          length = sizeof(address);
+                ::getsockname(acceptor.descriptor(), (struct sockaddr*) &address, &length);
+                address.sin_addr.s_addr = ::htonl(INADDR_LOOPBACK);
+
+                auto per_connection = std::max<std::size_t>(1, options_.iterations_ / _connections);
+                std::uint64_t interval =
+                    _rate > 0 ? (std::uint64_t) (1e9 * _connections / _rate) : 0;
+
+                async_latch   connected(engine_, _connections + 1);
+                async_latch   go(engine_, 1);
+                async_latch   done(engine_, 2 * _connections + 1);
+                std::uint64_t start = 0;
+
+                serve(acceptor, _connections, done);
+
+                for (std::size_t c = 0; c < _connections; ++c)
+                {
+                    client(
+                        thread_t{(std::uint16_t) (c % engine_->number_of_workers())},
+                        address,
+                        _size,
+                        _depth,
+                        per_connection,
+                        interval,
+                        start,
+                        _ctx,
+                        connected,
+                        go,
+                        done);
+                }
+
+                co_await connected.arrive_and_wait();
+
+                start = now_ns();
+                go.count_down();
+
+                co_await done.arrive_and_wait();
+
+                co_return run_stats{
+                    .elapsed_ns_ = now_ns() - start,
+                    .requests_   = per_connection * _connections};
+            }
+
+            async_function<>
+            serve(tcp_acceptor& _acceptor, std::size_t _connections, async_latch& _done) noexcept
+            {
+                for (std::size_t c = 0; c < _connections; ++c)
+                {
+                    struct sockaddr_storage address;
+                    socklen_t               length = sizeof(address);
+
+                    auto stream = co_await _acceptor.accept((struct sockaddr*) &address, &length);
+                    if (!stream)
+                    {
+                        std::cerr << "accept failed: " << _acceptor.last_error() << "\n";
+                        failed_ = true;
+                        _done.count_down(_connections - c);
+                        co_return;
+                    }
+
+                    echo(
+                        thread_t{(std::uint16_t) (c % engine_->number_of_workers())},
+                        std::move(*stream),
+                        _done);
+                }
+            }
+
+            async_function<>
+            echo(thread_t _thread, tcp_stream<std::byte> _stream, async_latch& _done) noexcept
+            {
+                co_await yield(_thread);
+
+                std::vector<std::byte> buffer(64 * 1024);
+                while (true)
+                {
+                    auto amount = co_await _stream.read_some(buffer);
+                    if (amount <= 0) { break; }
+
+                    auto written =
+                        co_await _stream.write({buffer.data(), (std::size_t) amount});
+                    if (written != amount) { break; }
+                }
+
+                co_await _stream.shutdown();
+                _done.count_down();
+            }
+
+            async_function<>
+            client(
+                thread_t             _thread,
+                struct sockaddr_in   _address,
+                std::size_t          _size,
+                std::size_t          _depth,
+                std::size_t          _requests,
+                std::uint64_t        _interval,
+                const std::uint64_t& _start,
+                context*             _ctx,
+                async_latch&         _connected,
+                async_latch&         _go,
+                async_latch&         _done) noexcept
+            {
+                co_await yield(_thread);
+
+                auto stream = co_await tcp_connect(
+                    engine_,
+                    (struct sockaddr*) &_address,
+                    sizeof(_address));
+
+                auto error = stream.last_error();
+                _connected.count_down();
+                co_await _go.wait();
+
+                if (error)
+                {
+                    std::cerr << "connect failed: " << error << "\n";
+                    failed_ = true;
+                    _done.count_down();
+                    co_return;
+                }
+
+                async_counting_semaphore<> window(engine_, (std::ptrdiff_t) _depth);
+                std::deque<std::uint64_t>  intended;
+                async_latch                sent(engine_, 2);
+
+                send(stream, window, intended, sent, _size, _requests, _interval, _start);
+
+                std::vector<std::byte> response(_size);
+                for (std::size_t i = 0; i < _requests; ++i)
+                {
+                    if (co_await stream.read(response) != (long long) _size)
+                    {
+                        std::cerr << "read failed: " << stream.last_error() << "\n";
+                        failed_ = true;
+                        break;
+                    }
+
+                    if (_ctx) { _ctx->record(now_ns() - intended.front()); }
+                    intended.pop_front();
+                    window.release();
+                }
+
+                co_await sent.arrive_and_wait();
+                co_await stream.shutdown();
+                _done.count_down();
+            }
+
+            async_function<>
+            send(
+                tcp_stream<std::byte>&      _stream,
+                async_counting_semaphore<>& _window,
+                std::deque<std::uint64_t>&  _intended,
+                async_latch&                _sent,
+                std::size_t                 _size,
+                std::size_t                 _requests,
+                std::uint64_t               _interval,
+                std::uint64_t               _start) noexcept
+            {
+                std::vector<std::byte> request(_size, std::byte{'z'});
+                for (std::size_t i = 0; i < _requests; ++i)
+                {
+                    co_await _window;
+
+                    auto now = now_ns();
+                    if (_interval)
+                    {
+                        /* Measure from the schedule, even if we are running behind it. */
+                        auto scheduled = _start + i * _interval;
+                        if (now < scheduled)
+                        {
+                            co_await engine_->get_timer().wait(scheduled - now);
+                        }
+                        now = scheduled;
+                    }
+
+                    _intended.push_back(now);
+                    if (co_await _stream.write(request) != (long long) _size)
+                    {
+                        std::cerr << "write failed: " << _stream.last_error() << "\n";
+                        failed_ = true;
+                        break;
+                    }
+                }
+
+                _sent.count_down();
+            }
+
+            const options&          options_;
+            const loopback_options& loopback_;
+            std::vector<result>     results_;
+            bool                    failed_ = false;
+    };
+
+}   // namespace zab::bench
+
+int
+main(int _argc, char** _argv)
+{
+    using namespace zab::bench;
+
+    options                                          opts;
+    loopback_options                                 loopback_opts;
+    std::vector<std::pair<std::string, std::string>> rest;
+
+    opts.iterations_  = 20'000;
+    opts.repetitions_ = 3;
+
+    bool ok = parse_options(_argc, _argv, opts, &rest);
+    for (const auto& [key, value] : rest)
+    {
+        if (!ok) { break; }
+
+        if (key == "connections") { ok = parse_list(value, loopback_opts.connections_); }
+        else if (key == "sizes")
+        {
+            ok = parse_list(value, loopback_opts.sizes_);
+        }
+        else if (key == "depths")
+        {
+            ok = parse_list(value, loopback_opts.depths_);
+        }
+        else if (key == "rate")
+        {
+            loopback_opts.rate_ = std::strtod(value.c_str(), nullptr);
+            ok                  = loopback_opts.rate_ > 0;
+        }
+        else if (key == "load")
+        {
+            loopback_opts.load_ = std::strtod(value.c_str(), nullptr);
+            ok                  = loopback_opts.load_ > 0;
+        }
+        else
+        {
+            ok = false;
+        }
+    }
+
+    if (!ok)
+    {
+        print_usage(
+            _argv[0],
+            "  --connections=N,..  connection counts to sweep (default 1,8,32)\n"
+            "  --sizes=N,..        message sizes in bytes to sweep (default 64,4096)\n"
+            "  --depths=N,..       requests in flight per connection (default 1,16)\n"
+            "  --rate=R            open loop requests/sec over all connections\n"
+            "  --load=F            open loop rate as a fraction of the closed loop maximum "
+            "(default 0.75)\n"
+            "  --iterations is the number of requests per run, split over the connections.\n");
+        return 1;
+    }
+
+    zab::engine engine(zab::engine::configs{
+        .threads_         = (std::uint16_t) opts.max_threads_,
+        .opt_             = zab::engine::configs::kExact,
+        .affinity_set_    = false,
+        .affinity_offset_ = 0});
+
+    loopback bench(opts, loopback_opts);
+    bench.register_engine(engine);
+
+    engine.start();
+
+    if (report(opts, bench.results())) { return 1; }
+
+    return bench.failed() ? 1 : 0;
+}
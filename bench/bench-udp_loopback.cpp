@@ -0,0 +1,488 @@
+/*
+ *  MMM"""AMV       db      `7MM"""Yp,
+ *  M'   AMV       ;MM:       MM    Yb
+ *  '   AMV       ,V^MM.      MM    dP
+ *     AMV       ,M  `MM      MM"""bg.
+ *    AMV   ,    AbmmmqMA     MM    `Y
+ *   AMV   ,M   A'     VML    MM    ,9
+ *  AMVmmmmMM .AMA.   .AMMA..JMMmmmd9
+ *
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021 Donald-Rupin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ *  @file bench-udp_loopback.cpp
+ *
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <netinet/in.h>
+#include <span>
+#include <string>
+#include <sys/socket.h>
+#include <vector>
+
+#include "harness.hpp"
+#include "zab/async_function.hpp"
+#include "zab/async_latch.hpp"
+#include "zab/async_semaphore.hpp"
+#include "zab/engine.hpp"
+#include "zab/engine_enabled.hpp"
+#include "zab/simple_future.hpp"
+#include "zab/udp_networking.hpp"
+#include "zab/yield.hpp"
+
+/**
+ * Datagrams per second from one UDP socket to another over loopback on a single event loop.
+ *
+ * Each mode moves the same datagrams with fewer syscalls than the last: one recvmsg per
+ * datagram, a multishot recvmsg into provided buffers, UDP_SEGMENT sends of `--batch` datagrams
+ * and finally UDP_GRO on the receiver as well. The sender never has more than `--window`
+ * datagrams in flight so that none are dropped.
+ */
+namespace zab::bench {
+
+    enum class mode {
+        kRecvmsg,
+        kMultishot,
+        kSegment,
+        kSegmentGro
+    };
+
+    struct udp_options {
+
+            std::vector<std::size_t> sizes_  = {64, 1024};
+            std::vector<mode>        modes_  = {
+                mode::kRecvmsg,
+                mode::kMultishot,
+                mode::kSegment,
+                mode::kSegmentGro};
+            std::size_t              batch_  = 32;
+            std::size_t              window_ = 128;
+    };
+
+    inline constexpr int kReceiveBuffer = 4 * 1024 * 1024;
+
+    inline constexpr std::uint16_t kBuffers = 256;
+
+    std::string_view
+    name(mode _mode) noexcept
+    {
+        switch (_mode)
+        {
+            case mode::kRecvmsg:
+                return "recvmsg";
+            case mode::kMultishot:
+                return "multishot";
+            case mode::kSegment:
+                return "gso";
+            case mode::kSegmentGro:
+                return "gso+gro";
+        }
+
+        return "";
+    }
+
+    bool
+    parse_list(std::string_view _value, std::vector<std::size_t>& _out)
+    {
+        _out.clear();
+        while (_value.size())
+        {
+            auto        comma = _value.find(',');
+            std::size_t value = 0;
+            if (!details::parse_size(_value.substr(0, comma), value) || !value) { return false; }
+
+            _out.push_back(value);
+            _value = comma == std::string_view::npos ? "" : _value.substr(comma + 1);
+        }
+
+        return _out.size();
+    }
+
+    bool
+    parse_modes(std::string_view _value, std::vector<mode>& _out)
+    {
+        _out.clear();
+        while (_value.size())
+        {
+            auto comma = _value.find(',');
+            auto token = _value.substr(0, comma);
+
+            bool found = false;
+            for (auto m : {mode::kRecvmsg, mode::kMultishot, mode::kSegment, mode::kSegmentGro})
+            {
+                if (token == name(m))
+                {
+                    _out.push_back(m);
+                    found = true;
+                }
+            }
+
+            if (!found) { return false; }
+
+            _value = comma == std::string_view::npos ? "" : _value.substr(comma + 1);
+        }
+
+        return _out.size();
+    }
+
+    class udp_loopback : public engine_enabled<udp_loopback> {
+
+        public:
+
+            static constexpr auto kDefaultThread = 0;
+
+            udp_loopback(const options& _options, const udp_options& _udp)
+                : options_(_options), udp_(_udp)
+            { }
+
+            void
+            initialise() noexcept
+            {
+                run();
+            }
+
+            const std::vector<result>&
+            results() const noexcept
+            {
+                return results_;
+            }
+
+            bool
+            failed() const noexcept
+            {
+                return failed_;
+            }
+
+        private:
+
+            async_function<>
+            run() noexcept
+            {
+                for (auto m : udp_.modes_)
+                {
+                    for (auto size : udp_.sizes_)
+                    {
+                        if (failed_) { break; }
+                        co_await run_config(m, size);
+                    }
+                }
+
+                engine_->stop();
+            }
+
+            simple_future<>
+            run_config(mode _mode, std::size_t _size) noexcept
+            {
+                /* A UDP_SEGMENT send is limited to one 64KiB datagram. */
+                auto batch = std::clamp<std::size_t>(60'000 / _size, 1, udp_.batch_);
+
+                result r;
+                r.name_    = "udp_loopback";
+                r.threads_ = 1;
+                r.params_  = {{"mode", std::string(name(_mode))}, {"size", std::to_string(_size)}};
+                if (_mode == mode::kSegment || _mode == mode::kSegmentGro)
+                {
+                    r.params_.emplace_back("batch", std::to_string(batch));
+                }
+
+                for (std::size_t i = 0; i < options_.warmup_; ++i)
+                {
+                    co_await run_once(_mode, _size, batch);
+                }
+
+                std::uint64_t elapsed = 0;
+                for (std::size_t i = 0; i < options_.repetitions_ && !failed_; ++i)
+                {
+                    auto took = co_await run_once(_mode, _size, batch);
+                    elapsed += took;
+
+                    r.operations_ = options_.iterations_;
+                    r.ns_per_op_.push_back((double) took / options_.iterations_);
+                }
+
+                double pps = (double) options_.repetitions_ * options_.iterations_ * 1e9 /
+                             std::max<std::uint64_t>(1, elapsed);
+
+                r.metrics_ = {{"pps", pps}, {"MBps", pps * _size / 1e6}};
+
+                results_.push_back(std::move(r));
+            }
+
+            guaranteed_future<std::uint64_t>
+            run_once(mode _mode, std::size_t _size, std::size_t _batch) noexcept
+            {
+                udp_socket sender(engine_);
+                udp_socket receiver(engine_);
+
+                bool gro = _mode == mode::kSegmentGro;
+                if (!sender.bind(AF_INET, 0) || !receiver.bind(AF_INET, 0) ||
+                    !receiver.set_gro(gro))
+                {
+                    std::cerr << "socket setup failed: " << sender.last_error() << " "
+                              << receiver.last_error() << "\n";
+                    failed_ = true;
+                    co_return 0;
+                }
+
+                ::setsockopt(
+                    receiver.descriptor(),
+                    SOL_SOCKET,
+                    SO_RCVBUF,
+                    &kReceiveBuffer,
+                    sizeof(kReceiveBuffer));
+
+                /* A coalesced datagram can be up to 64KiB. */
+                buffer_group buffers(
+                    engine_,
+                    kBuffers,
+                    (std::uint32_t) (udp_socket::kReceiveOverhead + (gro ? 65536 : _size)));
+
+                if (_mode != mode::kRecvmsg && !co_await buffers.provide())
+                {
+                    std::cerr << "provide buffers failed\n";
+                    failed_ = true;
+                    co_return 0;
+                }
+
+                async_counting_semaphore<> window(engine_, (std::ptrdiff_t) udp_.window_);
+                async_latch                done(engine_, 3);
+
+                auto start = now_ns();
+
+                send(sender, receiver.port(), _mode, _size, _batch, window, done);
+
+                if (_mode == mode::kRecvmsg) { receive_each(receiver, _size, window, done); }
+                else
+                {
+                    receive_multishot(receiver, buffers, window, done);
+                }
+
+                co_await done.arrive_and_wait();
+
+                auto elapsed = now_ns() - start;
+
+                co_await buffers.release();
+                co_await sender.close();
+                co_await receiver.close();
+
+                co_return elapsed;
+            }
+
+            async_function<>
+            send(
+                udp_socket&                 _sender,
+                std::uint16_t               _port,
+                mode                        _mode,
+                std::size_t                 _size,
+                std::size_t                 _batch,
+                async_counting_semaphore<>& _window,
+                async_latch&                _done) noexcept
+            {
+                struct sockaddr_in to;
+                ::memset(&to, 0, sizeof(to));
+                to.sin_family      = AF_INET;
+                to.sin_port        = ::htons(_port);
+                to.sin_addr.s_addr = ::htonl(INADDR_LOOPBACK);
+
+                bool segment = _mode == mode::kSegment || _mode == mode::kSegmentGro;
+                if (!segment) { _batch = 1; }
+
+                std::vector<std::byte> payload(_size * _batch, std::byte{'u'});
+
+                std::size_t sent = 0;
+                while (sent < options_.iterations_ && !failed_)
+                {
+                    auto amount = std::min(_batch, options_.iterations_ - sent);
+                    for (std::size_t i = 0; i < amount; ++i)
+                    {
+                        co_await _window;
+                    }
+
+                    auto bytes  = amount * _size;
+                    auto result = co_await _sender.send_to(
+                        std::span<const std::byte>(payload).first(bytes),
+                        (struct sockaddr*) &to,
+                        sizeof(to),
+                        segment ? (std::uint16_t) _size : 0);
+
+                    if (result != (int) bytes)
+                    {
+                        std::cerr << "send failed: " << _sender.last_error() << "\n";
+                        failed_ = true;
+                        break;
+                    }
+
+                    sent += amount;
+                }
+
+                _done.count_down();
+            }
+
+            async_function<>
+            receive_each(
+                udp_socket&                 _receiver,
+                std::size_t                 _size,
+                async_counting_semaphore<>& _window,
+                async_latch&                _done) noexcept
+            {
+                std::vector<std::byte> buffer(_size);
+                struct iovec           vector{.iov_base = buffer.data(), .iov_len = buffer.size()};
+                struct msghdr          message;
+                ::memset(&message, 0, sizeof(message));
+                message.msg_iov    = &vector;
+                message.msg_iovlen = 1;
+
+                for (std::size_t i = 0; i < options_.iterations_ && !failed_; ++i)
+                {
+                    if (co_await _receiver.recv_msg(&message) != (int) _size)
+                    {
+                        std::cerr << "recvmsg failed: " << _receiver.last_error() << "\n";
+                        failed_ = true;
+                        break;
+                    }
+
+                    _window.release();
+                }
+
+                _done.count_down();
+            }
+
+            async_function<>
+            receive_multishot(
+                udp_socket&                 _receiver,
+                buffer_group&               _buffers,
+                async_counting_semaphore<>& _window,
+                async_latch&                _done) noexcept
+            {
+                std::size_t received = 0;
+
+                auto error = co_await _receiver.receive(
+                    _buffers,
+                    [&](const datagram& _datagram) noexcept
+                    {
+                        std::size_t count = 1;
+                        if (_datagram.segment_size_)
+                        {
+                            count = (_datagram.data_.size() + _datagram.segment_size_ - 1) /
+                                    _datagram.segment_size_;
+                        }
+
+                        received += count;
+                        _window.release((std::ptrdiff_t) count);
+
+                        if (received == options_.iterations_) { stop(_receiver); }
+                    });
+
+                if (error != ECANCELED)
+                {
+                    std::cerr << "multishot receive failed: " << error << "\n";
+                    failed_ = true;
+                }
+
+                _done.count_down();
+            }
+
+            async_function<>
+            stop(udp_socket& _receiver) noexcept
+            {
+                /* Let the receive rearm before canceling it. */
+                co_await yield();
+                co_await _receiver.cancel();
+            }
+
+            const options&      options_;
+            const udp_options&  udp_;
+            std::vector<result> results_;
+            bool                failed_ = false;
+    };
+
+}   // namespace zab::bench
+
+int
+main(int _argc, char** _argv)
+{
+    using namespace zab::bench;
+
+    options                                          opts;
+    udp_options                                      udp_opts;
+    std::vector<std::pair<std::string, std::string>> rest;
+
+    opts.iterations_ = 100'000;
+
+    bool ok = parse_options(_argc, _argv, opts, &rest);
+    for (const auto& [key, value] : rest)
+    {
+        if (!ok) { break; }
+
+        if (key == "sizes") { ok = parse_list(value, udp_opts.sizes_); }
+        else if (key == "modes")
+        {
+            ok = parse_modes(value, udp_opts.modes_);
+        }
+        else if (key == "batch")
+        {
+            ok = details::parse_size(value, udp_opts.batch_) && udp_opts.batch_;
+        }
+        else if (key == "window")
+        {
+            ok = details::parse_size(value, udp_opts.window_) && udp_opts.window_;
+        }
+        else
+        {
+            ok = false;
+        }
+    }
+
+    if (!ok)
+    {
+        print_usage(
+            _argv[0],
+            "  --sizes=N,..        datagram sizes in bytes to sweep (default 64,1024)\n"
+            "  --modes=M,..        any of recvmsg,multishot,gso,gso+gro (default all)\n"
+            "  --batch=N           datagrams per UDP_SEGMENT send (default 32)\n"
+            "  --window=N          datagrams in flight (default 128)\n"
+            "  --iterations is the number of datagrams per run (default 100000). --threads is\n"
+            "  ignored, every run uses one event loop.\n");
+        return 1;
+    }
+
+    zab::engine engine(zab::engine::configs{
+        .threads_         = 1,
+        .opt_             = zab::engine::configs::kExact,
+        .affinity_set_    = false,
+        .affinity_offset_ = 0});
+
+    udp_loopback bench(opts, udp_opts);
+    bench.register_engine(engine);
+
+    engine.start();
+
+    if (report(opts, bench.results())) { return 1; }
+
+    return bench.failed() ? 1 : 0;
+}
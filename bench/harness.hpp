@@ -0,0 +1,608 @@
+/*
+ *  MMM"""AMV       db      `7MM"""Yp,
+ *  M'   AMV       ;MM:       MM    Yb
+ *  '   AMV       ,V^MM.      MM    dP
+ *     AMV       ,M  `MM      MM"""bg.
+ *    AMV   ,    AbmmmqMA     MM    `Y
+ *   AMV   ,M   A'     VML    MM    ,9
+ *  AMVmmmmMM .AMA.   .AMMA..JMMmmmd9
+ *
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021 Donald-Rupin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ *  @file harness.hpp
+ *
+ */
+
+#ifndef ZAB_BENCH_HARNESS_HPP_
+#define ZAB_BENCH_HARNESS_HPP_
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "zab/async_function.hpp"
+#include "zab/async_latch.hpp"
+#include "zab/engine.hpp"
+#include "zab/engine_enabled.hpp"
+#include "zab/engine_local.hpp"
+#include "zab/latency_histogram.hpp"
+#include "zab/simple_future.hpp"
+#include "zab/threading.hpp"
+#include "zab/tracing.hpp"
+#include "zab/yield.hpp"
+
+/**
+ * A small self contained benchmark harness. A benchmark is a coroutine that is run for a number
+ * of unmeasured warmup repetitions and then for a number of measured repetitions, at every worker
+ * count from 1 up to `--threads`. The harness reports the time per operation of each repetition
+ * and the percentiles of any per operation latencies the benchmark records, as a table and
+ * optionally as JSON so that runs of two releases can be compared.
+ */
+namespace zab::bench {
+
+    /**
+     * @brief The command line options shared by every benchmark executable.
+     */
+    struct options {
+
+            std::size_t warmup_      = 1;
+            std::size_t repetitions_ = 5;
+            std::size_t iterations_  = 10'000;
+            std::size_t max_threads_ = std::max(1u, std::thread::hardware_concurrency());
+            std::string filter_;
+            std::string json_;
+    };
+
+    namespace details {
+
+        inline bool
+        parse_size(std::string_view _value, std::size_t& _out) noexcept
+        {
+            auto [ptr, ec] = std::from_chars(_value.data(), _value.data() + _value.size(), _out);
+            return ec == std::errc{} && ptr == _value.data() + _value.size();
+        }
+
+        inline void
+        write_string(std::ostream& _out, std::string_view _value)
+        {
+            _out << '"';
+            for (auto c : _value)
+            {
+                if (c == '"' || c == '\\') { _out << '\\'; }
+                _out << c;
+            }
+            _out << '"';
+        }
+
+    }   // namespace details
+
+    /**
+     * @brief Parse the harness options. Unknown `--key=value` options are left for the caller in
+     *        `_rest`.
+     *
+     * @return false if an option was malformed or `--help` was given.
+     */
+    inline bool
+    parse_options(
+        int                                               _argc,
+        char**                                            _argv,
+        options&                                          _options,
+        std::vector<std::pair<std::string, std::string>>* _rest = nullptr)
+    {
+        for (int i = 1; i < _argc; ++i)
+        {
+            std::string_view arg = _argv[i];
+            if (arg == "--help" || !arg.starts_with("--")) { return false; }
+
+            auto             eq    = arg.find('=');
+            std::string_view key   = arg.substr(2, eq == std::string_view::npos ? eq : eq - 2);
+            std::string_view value = eq == std::string_view::npos ? "" : arg.substr(eq + 1);
+
+            bool ok = true;
+            if (key == "warmup") { ok = details::parse_size(value, _options.warmup_); }
+            else if (key == "repetitions")
+            {
+                ok = details::parse_size(value, _options.repetitions_) && _options.repetitions_;
+            }
+            else if (key == "iterations")
+            {
+                ok = details::parse_size(value, _options.iterations_) && _options.iterations_;
+            }
+            else if (key == "threads")
+            {
+                ok = details::parse_size(value, _options.max_threads_) && _options.max_threads_;
+            }
+            else if (key == "filter")
+            {
+                _options.filter_ = value;
+            }
+            else if (key == "json")
+            {
+                _options.json_ = value;
+            }
+            else if (_rest)
+            {
+                _rest->emplace_back(key, value);
+            }
+            else
+            {
+                ok = false;
+            }
+
+            if (!ok)
+            {
+                std::cerr << "Bad option: " << arg << "\n";
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    /**
+     * @brief Print the usage of the harness options.
+     */
+    inline void
+    print_usage(std::string_view _program, std::string_view _extra = {})
+    {
+        std::cerr << "usage: " << _program << " [options]\n"
+                  << "  --warmup=N       unmeasured repetitions (default 1)\n"
+                  << "  --repetitions=N  measured repetitions (default 5)\n"
+                  << "  --iterations=N   operations per worker per repetition (default 10000)\n"
+                  << "  --threads=N      the largest worker count to run (default all cpus)\n"
+                  << "  --filter=S       only run benchmarks whose name contains S\n"
+                  << "  --json=PATH      also write the results as JSON, - for stdout\n"
+                  << _extra;
+    }
+
+    /**
+     * @brief The results of one benchmark at one worker count.
+     */
+    struct result {
+
+            std::string                                      name_;
+            std::size_t                                      threads_ = 0;
+            std::vector<std::pair<std::string, std::string>> params_;
+            std::vector<std::pair<std::string, double>>      metrics_;
+            std::vector<double>                              ns_per_op_;
+            std::size_t                                      operations_ = 0;
+            latency_snapshot                                 latency_;
+    };
+
+    /**
+     * @brief Print results as a table.
+     */
+    inline void
+    print_table(std::ostream& _out, const std::vector<result>& _results)
+    {
+        _out << std::left << std::setw(36) << "benchmark" << std::right << std::setw(8)
+             << "threads" << std::setw(12) << "ns/op" << std::setw(10) << "+/-%" << std::setw(12)
+             << "p50" << std::setw(12) << "p99" << std::setw(12) << "p99.9" << std::setw(12)
+             << "max"
+             << "\n";
+
+        for (const auto& r : _results)
+        {
+            std::string name = r.name_;
+            for (const auto& [key, value] : r.params_)
+            {
+                name += " " + key + "=" + value;
+            }
+
+            auto sorted = r.ns_per_op_;
+            std::sort(sorted.begin(), sorted.end());
+            double median = sorted.empty() ? 0 : sorted[sorted.size() / 2];
+            double spread =
+                median > 0 ? 100.0 * (sorted.back() - sorted.front()) / (2 * median) : 0;
+
+            _out << std::left << std::setw(36) << name << std::right << std::setw(8) << r.threads_
+                 << std::fixed << std::setprecision(1) << std::setw(12) << median << std::setw(10)
+                 << spread;
+
+            if (r.latency_.count())
+            {
+                _out << std::setw(12) << r.latency_.percentile(50).count() << std::setw(12)
+                     << r.latency_.percentile(99).count() << std::setw(12)
+                     << r.latency_.percentile(99.9).count() << std::setw(12)
+                     << r.latency_.max().count();
+            }
+
+            for (const auto& [key, value] : r.metrics_)
+            {
+                _out << "  " << key << "=" << value;
+            }
+
+            _out << "\n";
+        }
+    }
+
+    /**
+     * @brief Write results as JSON.
+     */
+    inline void
+    write_json(std::ostream& _out, const std::vector<result>& _results)
+    {
+        _out << "{\n  \"context\": {\"hardware_concurrency\": "
+             << std::thread::hardware_concurrency()
+             << ", \"single_threaded\": " << (kSingleThreaded ? "true" : "false")
+             << ", \"tracing\": " << (kTracing ? "true" : "false") << "},\n  \"benchmarks\": [";
+
+        bool first = true;
+        for (const auto& r : _results)
+        {
+            _out << (first ? "\n" : ",\n") << "    {\"name\": ";
+            details::write_string(_out, r.name_);
+            _out << ", \"threads\": " << r.threads_ << ", \"operations\": " << r.operations_;
+
+            _out << ", \"params\": {";
+            for (std::size_t i = 0; i < r.params_.size(); ++i)
+            {
+                _out << (i ? ", " : "");
+                details::write_string(_out, r.params_[i].first);
+                _out << ": ";
+                details::write_string(_out, r.params_[i].second);
+            }
+
+            _out << "}, \"metrics\": {";
+            for (std::size_t i = 0; i < r.metrics_.size(); ++i)
+            {
+                _out << (i ? ", " : "");
+                details::write_string(_out, r.metrics_[i].first);
+                _out << ": " << r.metrics_[i].second;
+            }
+
+            _out << "}, \"ns_per_op\": [";
+            for (std::size_t i = 0; i < r.ns_per_op_.size(); ++i)
+            {
+                _out << (i ? ", " : "") << r.ns_per_op_[i];
+            }
+
+            const auto& l = r.latency_;
+            _out << "], \"latency_ns\": {\"count\": " << l.count()
+                 << ", \"mean\": " << l.mean().count()
+                 << ", \"p50\": " << l.percentile(50).count()
+                 << ", \"p90\": " << l.percentile(90).count()
+                 << ", \"p99\": " << l.percentile(99).count()
+                 << ", \"p99.9\": " << l.percentile(99.9).count()
+                 << ", \"max\": " << l.max().count() << "}}";
+
+            first = false;
+        }
+
+        _out << "\n  ]\n}\n";
+    }
+
+    /**
+     * @brief Print the results and write the JSON file if one was asked for.
+     *
+     * @return 0 on success.
+     */
+    inline int
+    report(const options& _options, const std::vector<result>& _results)
+    {
+        /* Keep stdout clean when the JSON goes there. */
+        print_table(_options.json_ == "-" ? std::cerr : std::cout, _results);
+
+        if (_options.json_ == "-") { write_json(std::cout, _results); }
+        else if (_options.json_.size())
+        {
+            std::ofstream file(_options.json_, std::ios::out | std::ios::trunc);
+            write_json(file, _results);
+            if (!file.good())
+            {
+                std::cerr << "Failed to write " << _options.json_ << "\n";
+                return 1;
+            }
+        }
+
+        return 0;
+    }
+
+    /**
+     * @brief The worker counts to run at: powers of two up to and including `_max`.
+     */
+    inline std::vector<std::size_t>
+    thread_counts(std::size_t _max)
+    {
+        std::vector<std::size_t> counts;
+        for (std::size_t i = 1; i < _max; i *= 2)
+        {
+            counts.push_back(i);
+        }
+
+        counts.push_back(_max);
+        return counts;
+    }
+
+    /**
+     * @brief The monotonic clock in nanoseconds.
+     */
+    inline std::uint64_t
+    now_ns() noexcept
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
+    /**
+     * @brief Handed to a benchmark for each repetition.
+     */
+    class context {
+
+        public:
+
+            context(engine* _engine, std::size_t _iterations)
+                : engine_(_engine), iterations_(_iterations), latency_(_engine)
+            { }
+
+            /**
+             * @brief The engine the benchmark runs in.
+             */
+            inline engine*
+            get_engine() const noexcept
+            {
+                return engine_;
+            }
+
+            /**
+             * @brief The number of workers in the engine.
+             */
+            inline std::size_t
+            workers() const noexcept
+            {
+                return engine_->number_of_workers();
+            }
+
+            /**
+             * @brief The operations each worker should perform per repetition.
+             */
+            inline std::size_t
+            iterations() const noexcept
+            {
+                return iterations_;
+            }
+
+            /**
+             * @brief Record the latency of one operation from the calling worker.
+             */
+            inline void
+            record(std::uint64_t _nanoseconds) noexcept
+            {
+                latency_->record(_nanoseconds);
+            }
+
+            /**
+             * @brief The latencies recorded on every worker.
+             */
+            guaranteed_future<latency_snapshot>
+            latency() noexcept
+            {
+                auto total = co_await latency_.reduce(
+                    latency_snapshot{},
+                    [](latency_snapshot _total, latency_histogram& _histogram)
+                    {
+                        _total += _histogram.snapshot();
+                        return _total;
+                    });
+
+                co_return total ? std::move(*total) : latency_snapshot{};
+            }
+
+            /**
+             * @brief Run `_function(thread_t)` on every worker at once and wait for them all.
+             *
+             * @param _function Returns a `simple_future<>` for the given worker.
+             */
+            template <typename Function>
+            simple_future<>
+            on_each_worker(Function _function) noexcept
+            {
+                async_latch latch(engine_, workers() + 1);
+                for (std::uint16_t t = 0; t < workers(); ++t)
+                {
+                    run_on(thread_t{t}, _function, latch);
+                }
+
+                co_await latch.arrive_and_wait();
+            }
+
+        private:
+
+            template <typename Function>
+            async_function<>
+            run_on(thread_t _thread, Function& _function, async_latch& _latch) noexcept
+            {
+                co_await yield(engine_, _thread);
+                co_await _function(_thread);
+                _latch.count_down();
+            }
+
+            engine*                         engine_;
+            std::size_t                     iterations_;
+            engine_local<latency_histogram> latency_;
+    };
+
+    /**
+     * @brief A benchmark returns the number of operations it performed.
+     */
+    using benchmark_function = std::function<guaranteed_future<std::size_t>(context&)>;
+
+    /**
+     * @brief Runs a set of benchmarks and reports them.
+     */
+    class harness {
+
+            struct benchmark {
+
+                    std::string        name_;
+                    benchmark_function function_;
+                    std::size_t        min_threads_;
+            };
+
+            class driver : public engine_enabled<driver> {
+
+                public:
+
+                    static constexpr auto kDefaultThread = 0;
+
+                    driver(const options& _options, const benchmark& _benchmark, result& _result)
+                        : options_(_options), benchmark_(_benchmark), result_(_result)
+                    { }
+
+                    void
+                    initialise() noexcept
+                    {
+                        run();
+                    }
+
+                    async_function<>
+                    run() noexcept
+                    {
+                        {
+                            context warmup(engine_, options_.iterations_);
+                            for (std::size_t i = 0; i < options_.warmup_; ++i)
+                            {
+                                co_await benchmark_.function_(warmup);
+                            }
+                        }
+
+                        context measured(engine_, options_.iterations_);
+                        for (std::size_t i = 0; i < options_.repetitions_; ++i)
+                        {
+                            auto start      = now_ns();
+                            auto operations = co_await benchmark_.function_(measured);
+                            auto elapsed    = now_ns() - start;
+
+                            result_.operations_ = operations;
+                            result_.ns_per_op_.push_back(
+                                (double) elapsed / (double) std::max<std::size_t>(1, operations));
+                        }
+
+                        result_.latency_ = co_await measured.latency();
+
+                        engine_->stop();
+                    }
+
+                private:
+
+                    const options&   options_;
+                    const benchmark& benchmark_;
+                    result&          result_;
+            };
+
+        public:
+
+            /**
+             * @brief Add a benchmark.
+             *
+             * @param _name The name to report.
+             * @param _function The benchmark.
+             * @param _min_threads Skip worker counts below this.
+             */
+            void
+            add(std::string _name, benchmark_function _function, std::size_t _min_threads = 1)
+            {
+                benchmarks_.push_back(benchmark{
+                    .name_        = std::move(_name),
+                    .function_    = std::move(_function),
+                    .min_threads_ = _min_threads});
+            }
+
+            /**
+             * @brief Parse the options, run every benchmark at every worker count and report.
+             *
+             * @return The exit code for main.
+             */
+            int
+            run(int _argc, char** _argv)
+            {
+                options opts;
+                if (!parse_options(_argc, _argv, opts))
+                {
+                    print_usage(_argv[0]);
+                    return 1;
+                }
+
+                /* The engine only ever has one worker. */
+                if constexpr (kSingleThreaded) { opts.max_threads_ = 1; }
+
+                std::vector<result> results;
+                for (const auto& b : benchmarks_)
+                {
+                    if (b.name_.find(opts.filter_) == std::string::npos) { continue; }
+
+                    for (auto threads : thread_counts(opts.max_threads_))
+                    {
+                        if (threads < b.min_threads_) { continue; }
+
+                        results.push_back(run_one(opts, b, threads));
+                    }
+                }
+
+                return report(opts, results);
+            }
+
+        private:
+
+            static result
+            run_one(const options& _options, const benchmark& _benchmark, std::size_t _threads)
+            {
+                result r;
+                r.name_    = _benchmark.name_;
+                r.threads_ = _threads;
+
+                engine engine(engine::configs{
+                    .threads_         = (std::uint16_t) _threads,
+                    .opt_             = engine::configs::kExact,
+                    .affinity_set_    = false,
+                    .affinity_offset_ = 0});
+
+                driver d(_options, _benchmark, r);
+                d.register_engine(engine);
+
+                engine.start();
+
+                return r;
+            }
+
+            std::vector<benchmark> benchmarks_;
+    };
+
+}   // namespace zab::bench
+
+#endif /* ZAB_BENCH_HARNESS_HPP_ */
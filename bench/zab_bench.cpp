@@ -0,0 +1,308 @@
+/*
+ *  MMM"""AMV       db      `7MM"""Yp,
+ *  M'   AMV       ;MM:       MM    Yb
+ *  '   AMV       ,V^MM.      MM    dP
+ *     AMV       ,M  `MM      MM"""bg.
+ *    AMV   ,    AbmmmqMA     MM    `Y
+ *   AMV   ,M   A'     VML    MM    ,9
+ *  AMVmmmmMM .AMA.   .AMMA..JMMmmmd9
+ *
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021 Donald-Rupin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ *  @file zab_bench.cpp
+ *
+ */
+
+#include <cstddef>
+#include <cstdint>
+
+#include "harness.hpp"
+#include "zab/async_barrier.hpp"
+#include "zab/async_function.hpp"
+#include "zab/async_latch.hpp"
+#include "zab/async_mutex.hpp"
+#include "zab/async_semaphore.hpp"
+#include "zab/first_of.hpp"
+#include "zab/observable.hpp"
+#include "zab/simple_future.hpp"
+#include "zab/timer_service.hpp"
+#include "zab/wait_for.hpp"
+#include "zab/yield.hpp"
+
+/**
+ * Microbenchmarks of the scheduling and synchronisation primitives at 1..N workers. Every
+ * worker runs `--iterations` operations per repetition (fewer for the slow primitives) and
+ * records the latency of each.
+ */
+namespace zab::bench {
+
+    simple_future<>
+    yield_worker(context& _ctx, thread_t) noexcept
+    {
+        for (std::size_t i = 0; i < _ctx.iterations(); ++i)
+        {
+            auto start = now_ns();
+            co_await yield(_ctx.get_engine());
+            _ctx.record(now_ns() - start);
+        }
+    }
+
+    guaranteed_future<std::size_t>
+    bench_yield(context& _ctx) noexcept
+    {
+        co_await _ctx.on_each_worker([&](thread_t _thread) { return yield_worker(_ctx, _thread); });
+        co_return _ctx.iterations() * _ctx.workers();
+    }
+
+    simple_future<>
+    thread_resume_worker(context& _ctx, thread_t _thread) noexcept
+    {
+        auto workers = _ctx.workers();
+        auto current = _thread.thread_;
+        for (std::size_t i = 0; i < _ctx.iterations(); ++i)
+        {
+            current = (current + 1) % workers;
+
+            auto start = now_ns();
+            co_await yield(_ctx.get_engine(), thread_t{(std::uint16_t) current});
+            _ctx.record(now_ns() - start);
+        }
+    }
+
+    guaranteed_future<std::size_t>
+    bench_thread_resume(context& _ctx) noexcept
+    {
+        co_await _ctx.on_each_worker([&](thread_t _thread)
+                                     { return thread_resume_worker(_ctx, _thread); });
+        co_return _ctx.iterations() * _ctx.workers();
+    }
+
+    simple_future<>
+    mutex_worker(context& _ctx, async_mutex& _mtx, std::size_t& _counter) noexcept
+    {
+        for (std::size_t i = 0; i < _ctx.iterations(); ++i)
+        {
+            auto start = now_ns();
+            auto lck   = co_await _mtx;
+            _ctx.record(now_ns() - start);
+            ++_counter;
+        }
+    }
+
+    guaranteed_future<std::size_t>
+    bench_mutex(context& _ctx) noexcept
+    {
+        async_mutex mtx(_ctx.get_engine());
+        std::size_t counter = 0;
+
+        co_await _ctx.on_each_worker([&](thread_t) { return mutex_worker(_ctx, mtx, counter); });
+        co_return counter;
+    }
+
+    simple_future<>
+    semaphore_worker(context& _ctx, async_counting_semaphore<>& _sem) noexcept
+    {
+        for (std::size_t i = 0; i < _ctx.iterations(); ++i)
+        {
+            auto start = now_ns();
+            co_await _sem;
+            _ctx.record(now_ns() - start);
+            _sem.release();
+        }
+    }
+
+    guaranteed_future<std::size_t>
+    bench_semaphore(context& _ctx) noexcept
+    {
+        async_counting_semaphore<> sem(_ctx.get_engine());
+
+        co_await _ctx.on_each_worker([&](thread_t) { return semaphore_worker(_ctx, sem); });
+        co_return _ctx.iterations() * _ctx.workers();
+    }
+
+    simple_future<>
+    barrier_worker(context& _ctx, async_barrier<>& _barrier, std::size_t _phases) noexcept
+    {
+        for (std::size_t i = 0; i < _phases; ++i)
+        {
+            auto start = now_ns();
+            co_await _barrier.arrive_and_wait();
+            _ctx.record(now_ns() - start);
+        }
+    }
+
+    guaranteed_future<std::size_t>
+    bench_barrier(context& _ctx) noexcept
+    {
+        auto            phases = std::max<std::size_t>(1, _ctx.iterations() / 10);
+        async_barrier<> barrier(_ctx.get_engine(), _ctx.workers(), zab::details::no_op{});
+
+        co_await _ctx.on_each_worker([&](thread_t)
+                                     { return barrier_worker(_ctx, barrier, phases); });
+        co_return phases;
+    }
+
+    async_function<>
+    observe(
+        engine*                  _engine,
+        observable<std::size_t>& _observable,
+        async_latch&             _ready,
+        async_latch&             _done,
+        thread_t                 _thread,
+        std::size_t              _events) noexcept
+    {
+        co_await yield(_engine, _thread);
+
+        auto connection = co_await _observable.connect();
+        _ready.count_down();
+
+        for (std::size_t i = 0; i < _events; ++i)
+        {
+            auto guard = co_await connection;
+        }
+
+        co_await _observable.disconnect(connection);
+        _done.count_down();
+    }
+
+    guaranteed_future<std::size_t>
+    bench_observable(context& _ctx) noexcept
+    {
+        auto events = std::max<std::size_t>(1, _ctx.iterations() / 10);
+        auto engine = _ctx.get_engine();
+
+        observable<std::size_t> ob(engine);
+        async_latch             ready(engine, _ctx.workers() + 1);
+        async_latch             done(engine, _ctx.workers() + 1);
+
+        for (std::uint16_t t = 0; t < _ctx.workers(); ++t)
+        {
+            observe(engine, ob, ready, done, thread_t{t}, events);
+        }
+
+        co_await ready.arrive_and_wait();
+
+        for (std::size_t i = 0; i < events; ++i)
+        {
+            auto start = now_ns();
+            co_await ob.emit(i);
+            _ctx.record(now_ns() - start);
+        }
+
+        co_await done.arrive_and_wait();
+        co_return events;
+    }
+
+    simple_future<>
+    timer_worker(context& _ctx, std::size_t _waits) noexcept
+    {
+        static constexpr std::uint64_t kWait = 10'000;
+
+        for (std::size_t i = 0; i < _waits; ++i)
+        {
+            auto start = now_ns();
+            co_await _ctx.get_engine()->get_timer().wait(kWait);
+            _ctx.record(now_ns() - start);
+        }
+    }
+
+    guaranteed_future<std::size_t>
+    bench_timer(context& _ctx) noexcept
+    {
+        auto waits = std::max<std::size_t>(1, _ctx.iterations() / 100);
+
+        co_await _ctx.on_each_worker([&](thread_t) { return timer_worker(_ctx, waits); });
+        co_return waits * _ctx.workers();
+    }
+
+    simple_future<int>
+    value(int _value) noexcept
+    {
+        co_return _value;
+    }
+
+    simple_future<bool>
+    flag(bool _value) noexcept
+    {
+        co_return _value;
+    }
+
+    simple_future<>
+    wait_for_worker(context& _ctx) noexcept
+    {
+        for (std::size_t i = 0; i < _ctx.iterations(); ++i)
+        {
+            auto start = now_ns();
+            co_await wait_for(value(1), value(2));
+            _ctx.record(now_ns() - start);
+        }
+    }
+
+    guaranteed_future<std::size_t>
+    bench_wait_for(context& _ctx) noexcept
+    {
+        co_await _ctx.on_each_worker([&](thread_t) { return wait_for_worker(_ctx); });
+        co_return _ctx.iterations() * _ctx.workers();
+    }
+
+    simple_future<>
+    first_of_worker(context& _ctx, std::size_t _calls) noexcept
+    {
+        for (std::size_t i = 0; i < _calls; ++i)
+        {
+            auto start = now_ns();
+            co_await first_of(_ctx.get_engine(), value(1), flag(true));
+            _ctx.record(now_ns() - start);
+        }
+    }
+
+    guaranteed_future<std::size_t>
+    bench_first_of(context& _ctx) noexcept
+    {
+        auto calls = std::max<std::size_t>(1, _ctx.iterations() / 10);
+
+        co_await _ctx.on_each_worker([&](thread_t) { return first_of_worker(_ctx, calls); });
+        co_return calls * _ctx.workers();
+    }
+
+}   // namespace zab::bench
+
+int
+main(int _argc, char** _argv)
+{
+    using namespace zab::bench;
+
+    harness h;
+    h.add("yield", bench_yield);
+    h.add("thread_resume", bench_thread_resume);
+    h.add("async_mutex", bench_mutex);
+    h.add("async_counting_semaphore", bench_semaphore);
+    h.add("async_barrier", bench_barrier);
+    h.add("observable::emit", bench_observable);
+    h.add("timer_service::wait 10us", bench_timer);
+    h.add("wait_for", bench_wait_for);
+    h.add("first_of", bench_first_of);
+
+    return h.run(_argc, _argv);
+}
@@ -0,0 +1,454 @@
+/*
+ *  MMM"""AMV       db      `7MM"""Yp,
+ *  M'   AMV       ;MM:       MM    Yb
+ *  '   AMV       ,V^MM.      MM    dP
+ *     AMV       ,M  `MM      MM"""bg.
+ *    AMV   ,    AbmmmqMA     MM    `Y
+ *   AMV   ,M   A'     VML    MM    ,9
+ *  AMVmmmmMM .AMA.   .AMMA..JMMmmmd9
+ *
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021 Donald-Rupin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ *  @file arena.hpp
+ *
+ */
+
+#ifndef ZAB_ARENA_HPP_
+#define ZAB_ARENA_HPP_
+
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "zab/simple_future.hpp"
+#include "zab/simple_promise.hpp"
+
+namespace zab {
+
+    /**
+     * @brief A bump allocator for memory that shares the lifetime of a single coroutine tree.
+     *
+     * @details Allocations are carved sequentially out of chunks obtained from the heap.
+     *          Deallocation is a no-op, all memory is released wholesale when `release()` is
+     *          called or the arena is destroyed.
+     *
+     *          An arena can be installed into the current thread (see `arena_scope` and
+     *          `use_arena`) so that `arena_future` frames and `std::pmr` containers constructed
+     *          with `arena_resource()` allocate from it.
+     *
+     *          The arena is not thread safe. A coroutine tree using an arena must not allocate
+     *          from it concurrently from different threads.
+     */
+    class arena : public std::pmr::memory_resource {
+
+        public:
+
+            /**
+             * @brief The default size of a chunk requested from the heap.
+             *
+             */
+            static constexpr std::size_t kDefaultChunkSize = 16 * 1024;
+
+            /**
+             * @brief Construct a new arena object.
+             *
+             * @details No memory is requested until the first allocation.
+             *
+             * @param _chunk_size The size of each chunk requested from the heap.
+             */
+            arena(std::size_t _chunk_size = kDefaultChunkSize) noexcept;
+
+            /**
+             * @brief Arenas are not copyable.
+             *
+             */
+            arena(const arena&) = delete;
+
+            /**
+             * @brief Destroy the arena object releasing all memory.
+             *
+             */
+            ~arena();
+
+            /**
+             * @brief Release all memory held by the arena.
+             *
+             * @details The first chunk is kept for reuse, so an arena that is reused across
+             *          requests of a similar size stops touching the heap.
+             *
+             *          It is undefined behaviour to use memory previously given out by the arena
+             *          after calling this function.
+             */
+            void
+            release() noexcept;
+
+            /**
+             * @brief The amount of bytes handed out by the arena since the last `release()`.
+             *
+             * @return std::size_t The bytes used.
+             */
+            [[nodiscard]] inline std::size_t
+            used() const noexcept
+            {
+                return used_;
+            }
+
+            /**
+             * @brief Get the arena installed in the current thread.
+             *
+             * @return arena* The current arena or nullptr if none is installed.
+             */
+            [[nodiscard]] static inline arena*
+            current() noexcept
+            {
+                return current_;
+            }
+
+            /**
+             * @brief Install an arena into the current thread.
+             *
+             * @param _arena The arena to install or nullptr to uninstall.
+             */
+            static inline void
+            install(arena* _arena) noexcept
+            {
+                current_ = _arena;
+            }
+
+            /**
+             * @brief Allocate memory for a coroutine frame.
+             *
+             * @details The frame is taken from the current arena if one is installed, otherwise
+             *          from the heap. The source is recorded in front of the frame so that it can
+             *          be freed correctly from any context.
+             *
+             * @param _size The size of the frame.
+             * @return void* The frame memory.
+             */
+            static void*
+            allocate_frame(std::size_t _size);
+
+            /**
+             * @brief Free memory given out by `allocate_frame()`.
+             *
+             * @param _frame The frame memory.
+             * @param _size The size of the frame.
+             */
+            static void
+            deallocate_frame(void* _frame, std::size_t _size) noexcept;
+
+        protected:
+
+            void*
+            do_allocate(std::size_t _bytes, std::size_t _alignment) override;
+
+            void
+            do_deallocate(void*, std::size_t, std::size_t) noexcept override
+            { }
+
+            bool
+            do_is_equal(const std::pmr::memory_resource& _other) const noexcept override
+            {
+                return this == &_other;
+            }
+
+        private:
+
+            struct chunk {
+                    chunk*      next_;
+                    std::size_t size_;
+            };
+
+            static constexpr std::size_t kFrameHeader = __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+
+            void*
+            allocate_chunk(std::size_t _bytes, std::size_t _alignment);
+
+            static thread_local arena* current_;
+
+            std::size_t chunk_size_;
+            chunk*      chunks_;
+            std::byte*  head_;
+            std::byte*  end_;
+            std::size_t used_;
+    };
+
+    /**
+     * @brief Installs an arena into the current thread for the lifetime of the scope.
+     *
+     * @details Useful for creating the root of a coroutine tree from outside of an arena aware
+     *          coroutine. A scope must not be held across a suspension point.
+     */
+    class arena_scope {
+
+        public:
+
+            arena_scope(arena& _arena) noexcept : previous_(arena::current())
+            {
+                arena::install(&_arena);
+            }
+
+            arena_scope(const arena_scope&) = delete;
+
+            ~arena_scope() { arena::install(previous_); }
+
+        private:
+
+            arena* previous_;
+    };
+
+    /**
+     * @brief Get the memory resource for the current thread.
+     *
+     * @return std::pmr::memory_resource* The current arena, or the default resource if no arena
+     *                                    is installed.
+     */
+    [[nodiscard]] inline std::pmr::memory_resource*
+    arena_resource() noexcept
+    {
+        if (auto* a = arena::current(); a) { return a; }
+        else { return std::pmr::get_default_resource(); }
+    }
+
+    template <typename T>
+    class arena_promise;
+
+    namespace details {
+
+        template <typename Awaitable>
+        decltype(auto)
+        get_awaiter(Awaitable&& _awaitable) noexcept
+        {
+            if constexpr (requires { std::forward<Awaitable>(_awaitable).operator co_await(); })
+            {
+                return std::forward<Awaitable>(_awaitable).operator co_await();
+            }
+            else
+            {
+                return std::forward<Awaitable>(_awaitable);
+            }
+        }
+
+        /**
+         * @brief Wraps the awaiters of an `arena_promise` so that its arena is uninstalled when
+         *        it suspends and re-installed when it resumes.
+         *
+         * @tparam Awaiter The underlying awaiter.
+         */
+        template <typename Awaiter>
+        struct arena_awaiter {
+
+                bool
+                await_ready() noexcept
+                {
+                    return awaiter_.await_ready();
+                }
+
+                template <typename PromiseType>
+                decltype(auto)
+                await_suspend(std::coroutine_handle<PromiseType> _awaiter) noexcept
+                {
+                    arena::install(nullptr);
+                    return awaiter_.await_suspend(_awaiter);
+                }
+
+                decltype(auto)
+                await_resume() noexcept
+                {
+                    arena::install(arena_);
+                    return awaiter_.await_resume();
+                }
+
+                Awaiter awaiter_;
+                arena*  arena_;
+        };
+
+        /**
+         * @brief The initial suspension of an `arena_promise`. Installs the arena when the body
+         *        starts.
+         *
+         */
+        struct arena_initial_suspension {
+
+                bool
+                await_ready() const noexcept
+                {
+                    return false;
+                }
+
+                void
+                await_suspend(std::coroutine_handle<>) const noexcept
+                { }
+
+                void
+                await_resume() const noexcept
+                {
+                    arena::install(arena_);
+                }
+
+                arena* arena_;
+        };
+
+        /**
+         * @brief A request to install an arena into the awaiting `arena_promise`.
+         *
+         */
+        struct arena_install {
+                arena* arena_;
+        };
+
+    }   // namespace details
+
+    /**
+     * @brief A `simple_promise` whose frame, and the frames of any `arena_future` created while
+     *        it is running, are allocated from the arena installed when it was created.
+     *
+     * @details The arena is re-installed each time the coroutine resumes, and uninstalled each
+     *          time it suspends, so the arena follows the coroutine tree and not the thread.
+     *
+     * @tparam T The type of the promised value.
+     */
+    template <typename T = void>
+    class arena_promise : public simple_promise<T> {
+
+        public:
+
+            arena_promise() noexcept : arena_(arena::current()) { }
+
+            static void*
+            operator new(std::size_t _size)
+            {
+                return arena::allocate_frame(_size);
+            }
+
+            static void
+            operator delete(void* _frame, std::size_t _size) noexcept
+            {
+                arena::deallocate_frame(_frame, _size);
+            }
+
+            inline auto
+            get_return_object() noexcept
+            {
+                return std::coroutine_handle<arena_promise>::from_promise(*this);
+            }
+
+            inline auto
+            initial_suspend() const noexcept
+            {
+                return details::arena_initial_suspension{.arena_ = arena_};
+            }
+
+            /**
+             * @brief Uninstall the arena before resuming the awaiting coroutine.
+             *
+             * @details The arena may have been destroyed with the locals of this coroutine. An
+             *          awaiting `arena_promise` re-installs its own arena on resumption.
+             *
+             * @return A structure for resuming the underlying coroutine.
+             */
+            inline auto
+            final_suspend() const noexcept
+            {
+                arena::install(nullptr);
+                return details::final_suspension{};
+            }
+
+            /**
+             * @brief Installs a new arena for this coroutine and its children.
+             *
+             * @details The arena is installed without suspending.
+             *
+             * @param _install The arena to install.
+             * @return std::suspend_never
+             */
+            inline auto
+            await_transform(details::arena_install _install) noexcept
+            {
+                arena_ = _install.arena_;
+                arena::install(arena_);
+                return std::suspend_never{};
+            }
+
+            template <typename Awaitable>
+            inline auto
+            await_transform(Awaitable&& _awaitable) noexcept
+            {
+                using awaiter_t = decltype(details::get_awaiter(std::forward<Awaitable>(_awaitable)));
+
+                return details::arena_awaiter<awaiter_t>{
+                    .awaiter_ = details::get_awaiter(std::forward<Awaitable>(_awaitable)),
+                    .arena_   = arena_};
+            }
+
+        private:
+
+            arena* arena_;
+    };
+
+    /**
+     * @brief A simple_future whose coroutine tree is allocated from an arena.
+     *
+     * @details The root of a tree creates the arena and installs it with `co_await
+     *          use_arena(arena)`. When the root completes the arena is destroyed along with all
+     *          frames and `std::pmr` buffers allocated beneath it.
+     *
+     *          ```
+     *          arena_future<>
+     *          handle_request()
+     *          {
+     *              arena a;
+     *              co_await use_arena(a);
+     *
+     *              std::pmr::vector<std::byte> buffer(4096, arena_resource());
+     *              co_await child(buffer);
+     *          }
+     *          ```
+     *
+     * @tparam T The type of the promised value.
+     */
+    template <typename T = void>
+    using arena_future = simple_future<T, arena_promise<T>>;
+
+    /**
+     * @brief Install an arena into the awaiting `arena_future` and its future children.
+     *
+     * @details Does not suspend. The arena must outlive all frames and buffers allocated from it.
+     *
+     * @param _arena The arena to install.
+     * @return An awaitable that can only be awaited within an `arena_future`.
+     */
+    [[nodiscard]] inline details::arena_install
+    use_arena(arena& _arena) noexcept
+    {
+        return details::arena_install{.arena_ = &_arena};
+    }
+
+}   // namespace zab
+
+#endif /* ZAB_ARENA_HPP_ */
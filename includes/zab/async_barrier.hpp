@@ -39,7 +39,6 @@
 #define ZAB_ASYNC_BARRIER_HPP_
 
 #include <algorithm>
-#include <atomic>
 #include <coroutine>
 #include <cstddef>
 #include <cstdint>
@@ -48,8 +47,10 @@
 
 #include "zab/async_function.hpp"
 #include "zab/engine.hpp"
+#include "zab/introspection.hpp"
 #include "zab/simple_future.hpp"
 #include "zab/strong_types.hpp"
+#include "zab/threading.hpp"
 #include "zab/yield.hpp"
 
 namespace zab {
@@ -141,6 +142,7 @@ namespace zab {
                     await_suspend(std::coroutine_handle<> _awaiter) noexcept
                     {
                         handle_ = _awaiter;
+                        introspection::begin(_awaiter.address(), "async_barrier", &barrier_);
 
                         auto amount = barrier_.count_.fetch_sub(1, std::memory_order_acquire);
 
@@ -156,7 +158,9 @@ namespace zab {
 
                     void
                     await_resume() const noexcept
-                    { }
+                    {
+                        introspection::end(handle_.address());
+                    }
 
                 private:
 
@@ -186,7 +190,7 @@ namespace zab {
 
                 private:
 
-                    arrival_token() : phase_complete_(std::make_unique<std::atomic<void*>>(nullptr))
+                    arrival_token() : phase_complete_(std::make_unique<atomic<void*>>(nullptr))
                     { }
 
                     bool
@@ -217,7 +221,7 @@ namespace zab {
 
                             std::uintptr_t next_;
 
-                            std::atomic<void*> handle_;
+                            atomic<void*> handle_;
                     };
 
                     std::unique_ptr<InternalState> phase_complete_;
@@ -610,8 +614,8 @@ namespace zab {
 
             std::ptrdiff_t expected_;
 
-            std::atomic<std::uintptr_t> working_set_ = 0;
-            std::atomic<std::ptrdiff_t> count_       = 0;
+            atomic<std::uintptr_t> working_set_ = 0;
+            atomic<std::ptrdiff_t> count_       = 0;
 
             CompletionFunction function_;
             thread_t           thread_;
@@ -606,6 +606,76 @@ namespace zab {
                     });
             }
 
+            /**
+             * @brief Reads up to `_data.size()` bytes from the file starting at `_position`.
+             *
+             * @details Does not use or move the file cursor, so many reads may be in flight on
+             *          the same file at once.
+             *
+             * @param _data The buffer to read data into.
+             * @param _position The offset in the file to read from.
+             * @return suspension_point The awaitable instance for reading some data.
+             *                      Async returns the amount of bytes read.
+             */
+            auto
+            read_at(std::span<ReadType> _data, off_t _position) noexcept
+            {
+                return suspension_point(
+                    [this, ret = event_loop::io_event{}, _data, _position]<typename T>(
+                        T _handle) mutable noexcept
+                    {
+                        if constexpr (is_suspend<T>())
+                        {
+                            ret.handle_ = _handle;
+
+                            engine_->get_event_loop()
+                                .read(&ret, file_, convert(_data, _data.size()), _position);
+                        }
+                        else if constexpr (is_resume<T>())
+                        {
+                            std::optional<std::size_t> result;
+                            if (ret.result_ >= 0) { result.emplace(std::move(ret.result_)); }
+
+                            return result;
+                        }
+                    });
+            }
+
+            /**
+             * @brief Writes up to `_data.size()` bytes to the file starting at `_position`.
+             *
+             * @details Does not use or move the file cursor, so many writes may be in flight on
+             *          the same file at once.
+             *
+             * @param _data The buffer to write data from.
+             * @param _position The offset in the file to write to.
+             * @return suspension_point The awaitable instance for writing some data.
+             *                      Async returns the amount of bytes written.
+             */
+            auto
+            write_at(std::span<const ReadType> _data, off_t _position) noexcept
+            {
+                return suspension_point(
+                    [this, ret = event_loop::io_event{}, _data, _position]<typename T>(
+                        T _handle) mutable noexcept
+                    {
+                        if constexpr (is_suspend<T>())
+                        {
+                            ret.handle_ = _handle;
+
+                            engine_->get_event_loop()
+                                .write(&ret, file_, convert(_data, _data.size()), _position);
+                        }
+                        else if constexpr (is_resume<T>())
+                        {
+                            std::optional<std::size_t> result;
+                            if (ret.result_ >= 0) { result.emplace(std::move(ret.result_)); }
+
+                            return result;
+                        }
+                    });
+            }
+
             /**
              * @brief      Reset the poistion of the file cursor.
              *
@@ -645,6 +715,17 @@ namespace zab {
                 return (bool) file_;
             }
 
+            /**
+             * @brief Get the underlying file descriptor.
+             *
+             * @return int
+             */
+            [[nodiscard]] inline int
+            descriptor() const noexcept
+            {
+                return file_;
+            }
+
         private:
 
             static inline constexpr std::span<std::byte>
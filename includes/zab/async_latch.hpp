@@ -38,11 +38,11 @@
 #ifndef ZAB_ASYNC_LATCH_HPP_
 #define ZAB_ASYNC_LATCH_HPP_
 
-#include <atomic>
 #include <deque>
 
 #include "zab/pause_token.hpp"
 #include "zab/strong_types.hpp"
+#include "zab/threading.hpp"
 
 namespace zab {
 
@@ -91,7 +91,7 @@ namespace zab {
             void
             notify();
 
-            std::atomic<std::ptrdiff_t> count_;
+            atomic<std::ptrdiff_t> count_;
 
             pause_token complete_;
     };
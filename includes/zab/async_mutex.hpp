@@ -41,6 +41,7 @@
 #include <atomic>
 #include <coroutine>
 #include <cstddef>
+#include <source_location>
 
 #include "zab/async_semaphore.hpp"
 
@@ -92,23 +93,37 @@ namespace zab {
             /**
              * @brief      lock()
              *
+             * @param[in]  _location  The caller, for the `profiler`.
+             *
              * @return     Locks the mutex.
              *
              */
-            auto operator co_await() noexcept
+            auto
+            lock(std::source_location _location = std::source_location::current()) noexcept
             {
                 struct : public async_binary_semaphore::waiter {
                         [[nodiscard]] async_lock_guard
                         await_resume() const noexcept
                         {
+                            introspection::end(handle_.address());
                             return async_lock_guard{&semaphore_};
                         }
 
-                } waiter{{sem_}};
+                } waiter{{sem_, thread_t{}, nullptr, nullptr, "async_mutex", _location}};
 
                 return waiter;
             }
 
+            /**
+             * @brief      lock()
+             *
+             * @details    The `profiler` does not know the caller, use `lock()` for that.
+             *
+             * @return     Locks the mutex.
+             *
+             */
+            auto operator co_await() noexcept { return lock(std::source_location{}); }
+
         private:
 
             async_binary_semaphore sem_;
@@ -38,13 +38,15 @@
 #ifndef ZAB_BINARY_SEMAPHORE_HPP
 #define ZAB_BINARY_SEMAPHORE_HPP
 
-#include <atomic>
 #include <coroutine>
 #include <cstddef>
+#include <source_location>
 
 #include "zab/async_function.hpp"
 #include "zab/engine.hpp"
+#include "zab/introspection.hpp"
 #include "zab/strong_types.hpp"
+#include "zab/threading.hpp"
 #include "zab/yield.hpp"
 
 namespace zab {
@@ -78,6 +80,11 @@ namespace zab {
 
                         handle_ = _awaiter;
 
+                        introspection::begin(
+                            _awaiter.address(),
+                            "async_counting_semaphore",
+                            &semaphore_);
+
                         semaphore_.suspend(this);
 
                         return true;
@@ -91,7 +98,9 @@ namespace zab {
 
                     void
                     await_resume() const noexcept
-                    { }
+                    {
+                        introspection::end(handle_.address());
+                    }
 
                     async_counting_semaphore& semaphore_;
                     thread_t                  thread_       = thread_t{};
@@ -266,11 +275,11 @@ namespace zab {
 
             engine* engine_;
 
-            std::atomic<waiter*> resuming_ = nullptr;
+            atomic<waiter*> resuming_ = nullptr;
 
-            std::atomic<std::ptrdiff_t> active_count_ = Count;
+            atomic<std::ptrdiff_t> active_count_ = Count;
 
-            std::atomic<std::ptrdiff_t> release_count_ = 0;
+            atomic<std::ptrdiff_t> release_count_ = 0;
 
             waiter* transfer_ = nullptr;
     };
@@ -286,6 +295,8 @@ namespace zab {
                     await_suspend(std::coroutine_handle<> _awaiter) noexcept
                     {
                         handle_ = _awaiter;
+                        introspection::begin(_awaiter.address(), kind_, &semaphore_, location_);
+
                         if (semaphore_.suspend(this)) { return true; }
                         else
                         {
@@ -301,12 +312,16 @@ namespace zab {
 
                     void
                     await_resume() const noexcept
-                    { }
+                    {
+                        introspection::end(handle_.address());
+                    }
 
                     async_counting_semaphore& semaphore_;
                     thread_t                  thread_       = thread_t{};
                     waiter*                   next_waiting_ = nullptr;
                     std::coroutine_handle<>   handle_       = nullptr;
+                    const char*               kind_         = "async_binary_semaphore";
+                    std::source_location      location_     = {};
             };
 
             async_counting_semaphore(engine* _engine, bool _unlocked)
@@ -424,7 +439,7 @@ namespace zab {
 
             engine* engine_;
 
-            std::atomic<std::uintptr_t> resuming_ = 0;
+            atomic<std::uintptr_t> resuming_ = 0;
             waiter*                     transfer_ = nullptr;
     };
 
@@ -0,0 +1,286 @@
+/*
+ *  MMM"""AMV       db      `7MM"""Yp,
+ *  M'   AMV       ;MM:       MM    Yb
+ *  '   AMV       ,V^MM.      MM    dP
+ *     AMV       ,M  `MM      MM"""bg.
+ *    AMV   ,    AbmmmqMA     MM    `Y
+ *   AMV   ,M   A'     VML    MM    ,9
+ *  AMVmmmmMM .AMA.   .AMMA..JMMmmmd9
+ *
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021 Donald-Rupin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ *  @file buffered_reader.hpp
+ *
+ */
+
+#ifndef ZAB_BUFFERED_READER_HPP_
+#define ZAB_BUFFERED_READER_HPP_
+
+#include <algorithm>
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "zab/memory_type.hpp"
+#include "zab/simple_future.hpp"
+#include "zab/tcp_stream.hpp"
+
+namespace zab {
+
+    namespace details {
+
+        /**
+         * @brief Find the first occurrence of `_delimiter` in `_data` using the widest vector
+         *        instructions the cpu supports (AVX2 or SSE2), or a scalar scan elsewhere.
+         *
+         * @return The offset of the delimiter, `_data.size()` if there is none or 0 if
+         *         `_delimiter` is empty.
+         */
+        [[nodiscard]] std::size_t
+        find_delimiter(
+            std::span<const std::byte> _data,
+            std::span<const std::byte> _delimiter) noexcept;
+
+        /**
+         * @brief The same as find_delimiter() but one byte at a time.
+         */
+        [[nodiscard]] std::size_t
+        find_delimiter_scalar(
+            std::span<const std::byte> _data,
+            std::span<const std::byte> _delimiter) noexcept;
+
+        /**
+         * @brief The implementation find_delimiter() uses: "avx2", "sse2" or "scalar".
+         */
+        [[nodiscard]] std::string_view
+        delimiter_scan_name() noexcept;
+
+    }   // namespace details
+
+    /**
+     * @brief Reads framed data from a tcp_stream through a buffer, for protocols that split
+     *        messages on a delimiter or prefix them with a length.
+     *
+     * @details Data is read from the stream in as large chunks as the buffer allows. Reads
+     *          return spans into the buffer rather than copies, which stay valid until the
+     *          next read through the reader. The buffer is used as a ring: space freed at the
+     *          front is reclaimed by moving what is left back to the start when the end is
+     *          reached, so that every result is contiguous. It doubles in size whenever a
+     *          frame does not fit, up to a limit.
+     *
+     * @tparam DataType The MemoryType of the underlying stream.
+     */
+    template <MemoryType DataType = std::byte>
+    class buffered_reader {
+
+        public:
+
+            static constexpr std::size_t kDefaultCapacity = 4096;
+
+            static constexpr std::size_t kDefaultLimit = 1024 * 1024;
+
+            /**
+             * @brief Construct a reader over `_stream`.
+             *
+             * @param _stream The stream to read from. Must outlive the reader.
+             * @param _capacity The initial size of the buffer.
+             * @param _limit The largest the buffer may grow to, and so the largest frame that
+             *               can be read.
+             */
+            explicit buffered_reader(
+                tcp_stream<DataType>& _stream,
+                std::size_t           _capacity = kDefaultCapacity,
+                std::size_t           _limit    = kDefaultLimit)
+                : stream_(_stream), buffer_(std::max<std::size_t>(_capacity, 1)),
+                  limit_(std::max(_limit, buffer_.size()))
+            { }
+
+            /**
+             * @brief Read up to and including the next `_delimiter`.
+             *
+             * @param _delimiter The sequence that ends the frame. Must not be empty.
+             * @co_return std::optional<std::span<DataType>> The frame, including the delimiter,
+             *            or std::nullopt if the stream ended, an error occurred or no delimiter
+             *            was found within the size limit.
+             */
+            simple_future<std::span<DataType>>
+            read_until(std::span<const DataType> _delimiter) noexcept
+            {
+                auto delimiter = std::as_bytes(_delimiter);
+
+                /* Only rescan the end of what was already searched in case it is split. */
+                std::size_t searched = 0;
+                while (true)
+                {
+                    auto unread = std::as_bytes(buffered()).subspan(searched);
+                    auto found  = details::find_delimiter(unread, delimiter);
+
+                    if (found != unread.size())
+                    {
+                        co_return take(searched + found + delimiter.size());
+                    }
+
+                    auto available = tail_ - head_;
+                    if (available >= delimiter.size())
+                    {
+                        searched = available - delimiter.size() + 1;
+                    }
+
+                    if (!reserve(available + 1)) { co_return std::nullopt; }
+
+                    auto amount = co_await read_more();
+                    if (amount <= 0) { co_return std::nullopt; }
+
+                    tail_ += amount;
+                }
+            }
+
+            /**
+             * @brief Read the next line ending in "\n" or "\r\n".
+             *
+             * @co_return std::optional<std::span<DataType>> The line without its ending, or
+             *            std::nullopt under the same conditions as read_until().
+             */
+            simple_future<std::span<DataType>>
+            read_line() noexcept
+            {
+                static constexpr DataType kNewLine[] = {DataType{'\n'}};
+
+                auto line = co_await read_until(kNewLine);
+                if (!line) { co_return std::nullopt; }
+
+                auto size = line->size() - 1;
+                if (size && (*line)[size - 1] == DataType{'\r'}) { --size; }
+
+                co_return line->first(size);
+            }
+
+            /**
+             * @brief Read exactly `_amount` elements, such as a body after a length prefix.
+             *
+             * @param _amount The amount to read.
+             * @co_return std::optional<std::span<DataType>> The data, or std::nullopt if the
+             *            stream ended, an error occurred or `_amount` is over the size limit.
+             */
+            simple_future<std::span<DataType>>
+            read_exact(std::size_t _amount) noexcept
+            {
+                while (tail_ - head_ < _amount)
+                {
+                    if (!reserve(_amount)) { co_return std::nullopt; }
+
+                    auto amount = co_await read_more();
+                    if (amount <= 0) { co_return std::nullopt; }
+
+                    tail_ += amount;
+                }
+
+                co_return take(_amount);
+            }
+
+            /**
+             * @brief What has been read from the stream but not yet returned. Reading through
+             *        the stream directly would skip this.
+             */
+            [[nodiscard]] std::span<DataType>
+            buffered() noexcept
+            {
+                return std::span(buffer_.data() + head_, tail_ - head_);
+            }
+
+            /**
+             * @brief The current size of the buffer.
+             */
+            [[nodiscard]] std::size_t
+            capacity() const noexcept
+            {
+                return buffer_.size();
+            }
+
+        private:
+
+            /**
+             * @brief Hand out the next `_amount` buffered elements.
+             */
+            std::span<DataType>
+            take(std::size_t _amount) noexcept
+            {
+                auto result = std::span(buffer_.data() + head_, _amount);
+                head_ += _amount;
+                return result;
+            }
+
+            /**
+             * @brief Make room for `_required` elements from the start of the unread data, which
+             *        must be more than is buffered.
+             *
+             * @return false if that would grow the buffer over its limit.
+             */
+            bool
+            reserve(std::size_t _required)
+            {
+                if (head_ == tail_) { head_ = tail_ = 0; }
+
+                if (head_ + _required <= buffer_.size()) { return true; }
+
+                if (head_)
+                {
+                    std::copy(buffer_.data() + head_, buffer_.data() + tail_, buffer_.data());
+                    tail_ -= head_;
+                    head_ = 0;
+                }
+
+                if (_required > buffer_.size())
+                {
+                    if (_required > limit_) [[unlikely]] { return false; }
+
+                    buffer_.resize(std::min(std::max(buffer_.size() * 2, _required), limit_));
+                }
+
+                return true;
+            }
+
+            /**
+             * @brief Read as much as fits in to the end of the buffer.
+             *
+             * @co_return int The amount read, or -1 if the stream ended or an error occurred.
+             */
+            [[nodiscard]] auto
+            read_more() noexcept
+            {
+                return stream_.read_some(std::span(buffer_.data() + tail_, buffer_.size() - tail_));
+            }
+
+            tcp_stream<DataType>& stream_;
+            std::vector<DataType> buffer_;
+            std::size_t           limit_;
+            std::size_t           head_ = 0;
+            std::size_t           tail_ = 0;
+    };
+
+}   // namespace zab
+
+#endif /* ZAB_BUFFERED_READER_HPP_ */
@@ -37,7 +37,11 @@
 #ifndef ZAB_ENGINE_HPP_
 #define ZAB_ENGINE_HPP_
 
+#include <chrono>
 #include <cstdint>
+#include <latch>
+#include <memory>
+#include <stop_token>
 #include <thread>
 #include <vector>
 
@@ -45,6 +49,8 @@
 #include "zab/event_loop.hpp"
 #include "zab/signal_handler.hpp"
 #include "zab/timer_service.hpp"
+#include "zab/topology.hpp"
+#include "zab/watchdog.hpp"
 
 namespace zab {
 
@@ -70,9 +76,44 @@ namespace zab {
 
                     thread_option opt_ = kAtLeast;
 
+                    /**
+                     * @brief Pin each worker to its cpu. Without an explicit `cpus_` list,
+                     *        workers are only placed on cpus the process is allowed to run on.
+                     */
                     bool affinity_set_ = true;
 
                     uint16_t affinity_offset_ = 0;
+
+                    /**
+                     * @brief Explicit cpus to pin workers to. Worker i is pinned to
+                     *        `cpus_[(i + affinity_offset_) % cpus_.size()]`. If empty, the
+                     *        discovered topology decides the placement.
+                     */
+                    std::vector<std::uint16_t> cpus_ = {};
+
+                    /**
+                     * @brief If true, the thread calling `start()` runs event loop 0 itself
+                     *        rather than spawning a thread for it and blocking.
+                     */
+                    bool use_caller_thread_ = false;
+
+                    /**
+                     * @brief If true, every event loop records scheduling latency histograms.
+                     *        Costs two clock reads per event.
+                     */
+                    bool track_latency_ = false;
+
+                    /**
+                     * @brief If non zero, a watchdog thread reports any single event that runs on
+                     *        a loop for longer than this. Costs two clock reads per event.
+                     */
+                    std::chrono::nanoseconds stall_threshold_ = std::chrono::nanoseconds(0);
+
+                    /**
+                     * @brief Called from the watchdog thread for each stall. If empty, stalls are
+                     *        written to std::cerr.
+                     */
+                    watchdog::handler stall_handler_ = {};
             };
 
             /**
@@ -103,9 +144,53 @@ namespace zab {
             static uint16_t
             validate(configs& _configs);
 
+            /**
+             * @brief      Pins the calling thread to the cpu assigned to a worker.
+             *
+             * @param[in]  _thread_id  The worker the calling thread runs.
+             */
             void
             set_worker_affinity(thread_t _thread_id) noexcept;
 
+            /**
+             * @brief      Provides access to the discovered machine topology.
+             *
+             * @return     The topology.
+             */
+            inline const topology&
+            get_topology() const noexcept
+            {
+                return topology_;
+            }
+
+            /**
+             * @brief      Get the cpu a worker is placed on.
+             *
+             * @param[in]  _thread  The worker.
+             *
+             * @return     The cpu id.
+             */
+            inline std::uint16_t
+            worker_cpu(thread_t _thread) const noexcept
+            {
+                assert(_thread.thread_ < worker_cpus_.size());
+                return worker_cpus_[_thread.thread_];
+            }
+
+            /**
+             * @brief      Get the NUMA node a worker is placed on.
+             *
+             * @param[in]  _thread  The worker.
+             *
+             * @return     The node id.
+             */
+            inline std::uint16_t
+            worker_node(thread_t _thread) const noexcept
+            {
+                assert(_thread.thread_ < worker_nodes_.size());
+                return worker_nodes_[_thread.thread_];
+            }
+
             /**
              * @brief      Provides direct access to the signal handler.
              *
@@ -163,6 +248,17 @@ namespace zab {
             void
             delayed_resume(tagged_event _handle, order_t _order, thread_t _thread) noexcept;
 
+            /**
+             * @brief      Runs the workers until `stop()` is called.
+             *
+             * @details    If `configs::use_caller_thread_` is set, the calling thread runs worker
+             *             0 and is restored to its previous identity and affinity on return.
+             *
+             *             SIGPIPE is blocked in every worker while it runs, so writing or
+             *             splicing to a closed socket fails with EPIPE instead of killing the
+             *             process. A SIGPIPE handler registered with the signal_handler does not
+             *             see those.
+             */
             void
             start() noexcept;
 
@@ -194,6 +290,52 @@ namespace zab {
                 return event_loop_.size();
             }
 
+            /**
+             * @brief      Get the metrics of a single worker.
+             *
+             * @param[in]  _thread  The worker.
+             *
+             * @return     A snapshot of the workers event loop metrics.
+             */
+            inline event_loop_metrics
+            metrics(thread_t _thread) const noexcept
+            {
+                assert(_thread.thread_ < event_loop_.size());
+                return event_loop_[_thread.thread_].metrics();
+            }
+
+            /**
+             * @brief      Get the metrics of all workers combined.
+             *
+             * @return     The sum of every event loops metrics.
+             */
+            event_loop_metrics
+            metrics() const noexcept;
+
+            /**
+             * @brief      Get the latency histograms of a single worker.
+             *
+             * @param[in]  _thread  The worker.
+             *
+             * @return     A snapshot of the workers event loop histograms.
+             */
+            inline event_loop_latency
+            latency(thread_t _thread) const noexcept
+            {
+                assert(_thread.thread_ < event_loop_.size());
+                return event_loop_[_thread.thread_].latency();
+            }
+
+            /**
+             * @brief      Get the latency histograms of all workers merged.
+             *
+             * @details    Empty unless `configs::track_latency_` is set.
+             *
+             * @return     The merged histograms.
+             */
+            event_loop_latency
+            latency() const noexcept;
+
         private:
 
             static thread_local thread_t this_thead_;
@@ -201,6 +343,9 @@ namespace zab {
             thread_t
             get_any_thread();
 
+            void
+            run_worker(thread_t _thread, std::stop_token _stop_token, std::latch& _latch) noexcept;
+
             // This is mainly stop helgrind et al. complaining
             // The auto latch should stop any race conditions...
             std::mutex                 mtx_;
@@ -211,7 +356,15 @@ namespace zab {
 
             std::vector<std::jthread> threads_;
 
+            std::stop_source caller_stop_;
+
             configs configs_;
+
+            topology                   topology_;
+            std::vector<std::uint16_t> worker_cpus_;
+            std::vector<std::uint16_t> worker_nodes_;
+
+            std::unique_ptr<watchdog> watchdog_;
     };
 
 }   // namespace zab
@@ -0,0 +1,221 @@
+/*
+ *  MMM"""AMV       db      `7MM"""Yp,
+ *  M'   AMV       ;MM:       MM    Yb
+ *  '   AMV       ,V^MM.      MM    dP
+ *     AMV       ,M  `MM      MM"""bg.
+ *    AMV   ,    AbmmmqMA     MM    `Y
+ *   AMV   ,M   A'     VML    MM    ,9
+ *  AMVmmmmMM .AMA.   .AMMA..JMMmmmd9
+ *
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021 Donald-Rupin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ *  @file engine_local.hpp
+ *
+ */
+
+#ifndef ZAB_ENGINE_LOCAL_HPP_
+#define ZAB_ENGINE_LOCAL_HPP_
+
+#include <cassert>
+#include <functional>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "zab/engine.hpp"
+#include "zab/hardware_interface_size.hpp"
+#include "zab/simple_future.hpp"
+#include "zab/strong_types.hpp"
+#include "zab/yield.hpp"
+
+namespace zab {
+
+    /**
+     * @brief Holds one instance of `T` per event_loop of an engine.
+     *
+     * @details Each instance is allocated and constructed lazily by the worker that owns it, so
+     *          that it is placed in memory local to that worker, and is padded to
+     *          `hardware_destructive_interference_size` so workers never share a cache line.
+     *          An instance should only be touched by its own worker. Use `for_each_worker` or
+     *          `reduce` to visit every instance.
+     *
+     * @tparam T The type to store.
+     */
+    template <typename T>
+    class engine_local {
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Winterference-size"
+            static constexpr std::size_t kSlotAlignment = hardware_destructive_interference_size;
+#pragma GCC diagnostic pop
+
+            struct alignas(kSlotAlignment) slot {
+                    T value_;
+            };
+
+        public:
+
+            /**
+             * @brief Construct an engine_local whose instances are default constructed.
+             *
+             * @param _engine The engine to allocate an instance for each worker of.
+             */
+            explicit engine_local(engine* _engine) requires(std::is_default_constructible_v<T>)
+                : engine_local(_engine, [] { return T{}; })
+            { }
+
+            /**
+             * @brief Construct an engine_local whose instances are created by a factory.
+             *
+             * @param _engine The engine to allocate an instance for each worker of.
+             * @param _factory Invoked on a worker to create that workers instance.
+             */
+            template <typename Factory>
+                requires(std::is_invocable_r_v<T, Factory>)
+            engine_local(engine* _engine, Factory&& _factory)
+                : engine_(_engine), factory_(std::forward<Factory>(_factory)),
+                  slots_(_engine->number_of_workers(), nullptr)
+            { }
+
+            engine_local(const engine_local&) = delete;
+
+            engine_local&
+            operator=(const engine_local&) = delete;
+
+            ~engine_local()
+            {
+                for (auto* s : slots_)
+                {
+                    if (s) { delete s; }
+                }
+            }
+
+            /**
+             * @brief Get the instance belonging to the calling worker.
+             *
+             * @return The instance.
+             */
+            inline T&
+            get() noexcept
+            {
+                return get(engine::current_id());
+            }
+
+            /**
+             * @brief Get the instance belonging to a worker.
+             *
+             * @details The caller must be running in `_thread` or otherwise ensure it is not being
+             *          used concurrently.
+             *
+             * @param _thread The worker.
+             * @return The instance.
+             */
+            inline T&
+            get(thread_t _thread) noexcept
+            {
+                assert(_thread.thread_ < slots_.size());
+                auto*& s = slots_[_thread.thread_];
+                if (!s) [[unlikely]] { s = new slot{factory_()}; }
+
+                return s->value_;
+            }
+
+            inline T&
+            operator*() noexcept
+            {
+                return get();
+            }
+
+            inline T*
+            operator->() noexcept
+            {
+                return &get();
+            }
+
+            /**
+             * @brief Visit the instance of every worker in turn, from within that worker.
+             *
+             * @details Resumes in the calling thread once all workers have been visited.
+             *
+             * @param _functor Invoked as `_functor(thread_t, T&)` on each worker.
+             *
+             * @co_return void Resumes once all instances have been visited.
+             */
+            template <typename Functor>
+                requires(std::is_invocable_v<Functor, thread_t, T&>)
+            [[nodiscard]] simple_future<>
+            for_each_worker(Functor _functor) noexcept
+            {
+                auto return_to = engine::current_id();
+
+                for (std::uint16_t i = 0; i < slots_.size(); ++i)
+                {
+                    if (engine::current_id() != thread_t{i})
+                    {
+                        co_await yield(engine_, thread_t{i});
+                    }
+
+                    _functor(thread_t{i}, get());
+                }
+
+                if (return_to != thread_t::any_thread() && engine::current_id() != return_to)
+                {
+                    co_await yield(engine_, return_to);
+                }
+            }
+
+            /**
+             * @brief Fold the instance of every worker into a single value.
+             *
+             * @param _init The initial value.
+             * @param _functor Invoked as `_functor(R, T&)` on each worker, returning the new value.
+             *
+             * @co_return R The folded value.
+             */
+            template <typename R, typename Functor>
+                requires(std::is_invocable_r_v<R, Functor, R, T&>)
+            [[nodiscard]] simple_future<R>
+            reduce(R _init, Functor _functor) noexcept
+            {
+                co_await for_each_worker(
+                    [&](thread_t, T& _value)
+                    {
+                        _init = _functor(std::move(_init), _value);
+                    });
+
+                co_return _init;
+            }
+
+        private:
+
+            engine*            engine_;
+            std::function<T()> factory_;
+            std::vector<slot*> slots_;
+    };
+
+}   // namespace zab
+
+#endif /* ZAB_ENGINE_LOCAL_HPP_ */
@@ -45,6 +45,7 @@
 #include <variant>
 
 #include "zab/strong_types.hpp"
+#include "zab/tracing.hpp"
 
 // delete
 #include <iostream>
@@ -89,6 +90,20 @@ namespace zab {
         return _event.index() == 1;
     }
 
+    /**
+     * @brief The identity of what an event resumes: the coroutine frame or the event context.
+     */
+    inline const void*
+    event_address(const tagged_event& _event) noexcept
+    {
+        if (auto handle = std::get_if<std::coroutine_handle<>>(&_event))
+        {
+            return handle->address();
+        }
+
+        return std::get<event<>>(_event).context_;
+    }
+
     template <typename ReturnType>
     void
     execute_event(event<ReturnType>* _event_address, ReturnType _result) noexcept
@@ -111,7 +126,12 @@ namespace zab {
     inline void
     execute_event(std::coroutine_handle<> _handle) noexcept
     {
-        if (_handle) { _handle.resume(); }
+        if (_handle)
+        {
+            tracing::begin("resume", _handle.address());
+            _handle.resume();
+            tracing::end(_handle.address());
+        }
     }
 
     inline void
@@ -137,7 +157,7 @@ namespace zab {
                 if constexpr (std::is_same_v<T, event<>>) { (*_handle.cb_)(_handle.context_); }
                 else
                 {
-                    if (_handle) { _handle.resume(); }
+                    execute_event(_handle);
                 }
             },
             *_event_address);
@@ -164,7 +184,8 @@ namespace zab {
     {
         return event<>{
             .cb_ =
-                +[](void* _context) { std::coroutine_handle<>::from_address(_context).resume(); },
+                +[](void* _context)
+                { execute_event(std::coroutine_handle<>::from_address(_context)); },
             .context_ = _handle.address(),
         };
     }
@@ -37,8 +37,8 @@
 #ifndef ZAB_EVENT_LOOP_HPP_
 #define ZAB_EVENT_LOOP_HPP_
 
-#include <atomic>
 #include <coroutine>
+#include <cstdint>
 #include <deque>
 #include <optional>
 #include <span>
@@ -49,12 +49,16 @@
 #include "zab/async_function.hpp"
 #include "zab/event.hpp"
 #include "zab/generic_awaitable.hpp"
+#include "zab/latency_histogram.hpp"
+#include "zab/metrics.hpp"
 #include "zab/pause.hpp"
 #include "zab/simple_future.hpp"
-#include "zab/spin_lock.hpp"
+#include "zab/threading.hpp"
+#include "zab/watchdog.hpp"
 
 struct io_uring;
 struct iovec;
+struct msghdr;
 struct sockaddr;
 
 namespace zab {
@@ -682,6 +686,338 @@ namespace zab {
                 std::span<const std::byte> _buffer,
                 int                        _flags) noexcept;
 
+            /**
+             * @brief Receive a message from a socket, with its source address and control data.
+             *
+             * @details See https://man7.org/linux/man-pages/man2/recvmsg.2.html.
+             *
+             * @param _sockfd The socket descriptor.
+             * @param _message The message header to receive into.
+             * @param _flags The flags to apply to the receive operation.
+             * @param[out] _cancel_token A ptr to a io_event* which will bet set to the
+             *                           cancelation handle.
+             *
+             * @co_return The result of the `::recvmsg()` operation.
+             */
+            auto
+            recv_msg(
+                int                _sockfd,
+                struct msghdr*     _message,
+                int                _flags,
+                cancelation_token* _cancel_token = nullptr) noexcept
+            {
+                return suspension_point(
+                    [this, ret = io_event{}, _sockfd, _message, _flags, _cancel_token]<typename T>(
+                        T _handle) mutable noexcept
+                    {
+                        if constexpr (is_suspend<T>())
+                        {
+                            ret.handle_ = _handle;
+
+                            if (_cancel_token) { *_cancel_token = &ret; }
+                            recv_msg(&ret, _sockfd, _message, _flags);
+                        }
+                        else if constexpr (is_resume<T>()) { return ret.result_; }
+                    });
+            }
+
+            /**
+             * @brief Receive a message from a socket, with its source address and control data.
+             *
+             * @details _cancel_token->data_ will hold the return code of the op.
+             *
+             *          See https://man7.org/linux/man-pages/man2/recvmsg.2.html.
+             *
+             * @param _cancel_token  A io_event* which will be resumed on completion.
+             * @param _sockfd The socket descriptor.
+             * @param _message The message header to receive into.
+             * @param _flags The flags to apply to the receive operation.
+             *
+             */
+            void
+            recv_msg(
+                io_event*      _cancel_token,
+                int            _sockfd,
+                struct msghdr* _message,
+                int            _flags) noexcept;
+
+            /**
+             * @brief Keep receiving messages from a socket into buffers taken from a provided
+             *        buffer group, until an error occurs or the operation is canceled.
+             *
+             * @details _cancel_token is resumed once per message. `completion_flags()` then holds
+             *          `IORING_CQE_F_BUFFER` and the buffer id above `IORING_CQE_BUFFER_SHIFT`
+             *          when a buffer was used, and `IORING_CQE_F_MORE` while the operation
+             *          remains armed. Each buffer starts with a
+             *          `io_uring_recvmsg_out` followed by the name, control data and payload,
+             *          sized by `_message->msg_namelen` and `_message->msg_controllen`.
+             *
+             *          See `provide_buffers()` and
+             *          https://man7.org/linux/man-pages/man3/io_uring_prep_recvmsg_multishot.3.html.
+             *
+             * @param _cancel_token  A io_event* which will be resumed for every completion.
+             * @param _sockfd The socket descriptor.
+             * @param _message The message header describing the name and control lengths.
+             * @param _flags The flags to apply to the receive operation.
+             * @param _group The buffer group to take buffers from.
+             *
+             */
+            void
+            recv_msg_multishot(
+                io_event*      _cancel_token,
+                int            _sockfd,
+                struct msghdr* _message,
+                int            _flags,
+                std::uint16_t  _group) noexcept;
+
+            /**
+             * @brief Send a message on a socket, with a destination address and control data.
+             *
+             * @details: See https://man7.org/linux/man-pages/man2/sendmsg.2.html.
+             *
+             * @param _sockfd The socket descriptor.
+             * @param _message The message header to send.
+             * @param _flags The flags to apply to the send operation.
+             * @param[out] _cancel_token A ptr to a io_event* which will bet set to the
+             *                           cancelation handle.
+             *
+             * @co_return The result of the `::sendmsg()` operation.
+             */
+            auto
+            send_msg(
+                int                  _sockfd,
+                const struct msghdr* _message,
+                int                  _flags,
+                cancelation_token*   _cancel_token = nullptr) noexcept
+            {
+                return suspension_point(
+                    [this, ret = io_event{}, _sockfd, _message, _flags, _cancel_token]<typename T>(
+                        T _handle) mutable noexcept
+                    {
+                        if constexpr (is_suspend<T>())
+                        {
+                            ret.handle_ = _handle;
+
+                            if (_cancel_token) { *_cancel_token = &ret; }
+                            send_msg(&ret, _sockfd, _message, _flags);
+                        }
+                        else if constexpr (is_resume<T>()) { return ret.result_; }
+                    });
+            }
+
+            /**
+             * @brief Send a message on a socket, with a destination address and control data.
+             *
+             * @details _cancel_token->data_ will hold the return code of the op.
+             *
+             *          See https://man7.org/linux/man-pages/man2/sendmsg.2.html.
+             *
+             * @param _cancel_token  A io_event* which will be resumed on completion.
+             * @param _sockfd The socket descriptor.
+             * @param _message The message header to send.
+             * @param _flags The flags to apply to the send operation.
+             *
+             */
+            void
+            send_msg(
+                io_event*            _cancel_token,
+                int                  _sockfd,
+                const struct msghdr* _message,
+                int                  _flags) noexcept;
+
+            /**
+             * @brief Move data between two descriptors without copying it through user space.
+             *        One of them must be a pipe.
+             *
+             * @details: See https://man7.org/linux/man-pages/man2/splice.2.html.
+             *
+             * @param _fd_in The descriptor to move data from.
+             * @param _off_in The offset to read from, or -1 to use (and advance) the current one.
+             * @param _fd_out The descriptor to move data to.
+             * @param _off_out The offset to write to, or -1 to use (and advance) the current one.
+             * @param _length The maximum amount to move.
+             * @param _flags The splice flags, such as SPLICE_F_MOVE.
+             * @param[out] _cancel_token A ptr to a io_event* which will bet set to the
+             *                           cancelation handle.
+             *
+             * @co_return The amount moved, 0 at the end of input or -errno.
+             */
+            auto
+            splice(
+                int                _fd_in,
+                std::int64_t       _off_in,
+                int                _fd_out,
+                std::int64_t       _off_out,
+                unsigned           _length,
+                unsigned           _flags,
+                cancelation_token* _cancel_token = nullptr) noexcept
+            {
+                return suspension_point(
+                    [this,
+                     ret = io_event{},
+                     _fd_in,
+                     _off_in,
+                     _fd_out,
+                     _off_out,
+                     _length,
+                     _flags,
+                     _cancel_token]<typename T>(T _handle) mutable noexcept
+                    {
+                        if constexpr (is_suspend<T>())
+                        {
+                            ret.handle_ = _handle;
+
+                            if (_cancel_token) { *_cancel_token = &ret; }
+                            splice(&ret, _fd_in, _off_in, _fd_out, _off_out, _length, _flags);
+                        }
+                        else if constexpr (is_resume<T>()) { return ret.result_; }
+                    });
+            }
+
+            /**
+             * @brief Move data between two descriptors without copying it through user space.
+             *        One of them must be a pipe.
+             *
+             * @details _cancel_token->data_ will hold the return code of the op.
+             *
+             *          See https://man7.org/linux/man-pages/man2/splice.2.html.
+             *
+             * @param _cancel_token  A io_event* which will be resumed on completion.
+             * @param _fd_in The descriptor to move data from.
+             * @param _off_in The offset to read from, or -1 to use (and advance) the current one.
+             * @param _fd_out The descriptor to move data to.
+             * @param _off_out The offset to write to, or -1 to use (and advance) the current one.
+             * @param _length The maximum amount to move.
+             * @param _flags The splice flags, such as SPLICE_F_MOVE.
+             *
+             */
+            void
+            splice(
+                io_event*    _cancel_token,
+                int          _fd_in,
+                std::int64_t _off_in,
+                int          _fd_out,
+                std::int64_t _off_out,
+                unsigned     _length,
+                unsigned     _flags) noexcept;
+
+            /**
+             * @brief Hand a contiguous run of equally sized buffers to the kernel for operations
+             *        that select their own buffer from `_group`.
+             *
+             * @details Buffers are provided to this event loop's ring only.
+             *
+             *          See https://man7.org/linux/man-pages/man3/io_uring_prep_provide_buffers.3.html.
+             *
+             * @param _buffers The memory of `_count` buffers of `_size` bytes.
+             * @param _size The size of each buffer.
+             * @param _count The number of buffers.
+             * @param _group The buffer group to add them to.
+             * @param _first_id The id of the first buffer. The others are numbered after it.
+             * @param[out] _cancel_token A ptr to a io_event* which will bet set to the
+             *                           cancelation handle.
+             *
+             * @co_return The number of buffers provided or -errno.
+             */
+            auto
+            provide_buffers(
+                std::span<std::byte> _buffers,
+                int                  _size,
+                int                  _count,
+                std::uint16_t        _group,
+                std::uint16_t        _first_id,
+                cancelation_token*   _cancel_token = nullptr) noexcept
+            {
+                return suspension_point(
+                    [this,
+                     ret = io_event{},
+                     _buffers,
+                     _size,
+                     _count,
+                     _group,
+                     _first_id,
+                     _cancel_token]<typename T>(T _handle) mutable noexcept
+                    {
+                        if constexpr (is_suspend<T>())
+                        {
+                            ret.handle_ = _handle;
+
+                            if (_cancel_token) { *_cancel_token = &ret; }
+                            provide_buffers(&ret, _buffers, _size, _count, _group, _first_id);
+                        }
+                        else if constexpr (is_resume<T>()) { return ret.result_; }
+                    });
+            }
+
+            /**
+             * @brief Hand a contiguous run of equally sized buffers to the kernel for operations
+             *        that select their own buffer from `_group`.
+             *
+             * @details _cancel_token->data_ will hold the return code of the op.
+             *
+             * @param _cancel_token  A io_event* which will be resumed on completion.
+             * @param _buffers The memory of `_count` buffers of `_size` bytes.
+             * @param _size The size of each buffer.
+             * @param _count The number of buffers.
+             * @param _group The buffer group to add them to.
+             * @param _first_id The id of the first buffer. The others are numbered after it.
+             *
+             */
+            void
+            provide_buffers(
+                io_event*            _cancel_token,
+                std::span<std::byte> _buffers,
+                int                  _size,
+                int                  _count,
+                std::uint16_t        _group,
+                std::uint16_t        _first_id) noexcept;
+
+            /**
+             * @brief Take back buffers that have not been used from a buffer group.
+             *
+             * @details See https://man7.org/linux/man-pages/man3/io_uring_prep_remove_buffers.3.html.
+             *
+             * @param _count The most buffers to remove.
+             * @param _group The buffer group to remove them from.
+             * @param[out] _cancel_token A ptr to a io_event* which will bet set to the
+             *                           cancelation handle.
+             *
+             * @co_return The number of buffers removed or -errno.
+             */
+            auto
+            remove_buffers(
+                int                _count,
+                std::uint16_t      _group,
+                cancelation_token* _cancel_token = nullptr) noexcept
+            {
+                return suspension_point(
+                    [this, ret = io_event{}, _count, _group, _cancel_token]<typename T>(
+                        T _handle) mutable noexcept
+                    {
+                        if constexpr (is_suspend<T>())
+                        {
+                            ret.handle_ = _handle;
+
+                            if (_cancel_token) { *_cancel_token = &ret; }
+                            remove_buffers(&ret, _count, _group);
+                        }
+                        else if constexpr (is_resume<T>()) { return ret.result_; }
+                    });
+            }
+
+            /**
+             * @brief Take back buffers that have not been used from a buffer group.
+             *
+             * @details _cancel_token->data_ will hold the return code of the op.
+             *
+             * @param _cancel_token  A io_event* which will be resumed on completion.
+             * @param _count The most buffers to remove.
+             * @param _group The buffer group to remove them from.
+             *
+             */
+            void
+            remove_buffers(io_event* _cancel_token, int _count, std::uint16_t _group) noexcept;
+
             /**
              * @brief Accept a connection on a socket.
              *
@@ -915,6 +1251,86 @@ namespace zab {
                 return size_.load(std::memory_order_relaxed);
             }
 
+            /**
+             * @brief The flags of the io_uring completion that resumed the current event, such as
+             *        the id of a selected buffer. Only valid until the event suspends again.
+             *
+             */
+            [[nodiscard]] inline std::uint32_t
+            completion_flags() const noexcept
+            {
+                return completion_flags_;
+            }
+
+            /**
+             * @brief Read the runtime counters of the loop. Safe to call from any thread.
+             *
+             * @return A snapshot of the counters.
+             */
+            inline event_loop_metrics
+            metrics() const noexcept
+            {
+                return counters_.snapshot();
+            }
+
+            /**
+             * @brief Timestamp user events and completions so their scheduling latency is
+             *        recorded. Must be called before the loop is run.
+             */
+            inline void
+            enable_latency_tracking() noexcept
+            {
+                track_latency_ = true;
+            }
+
+            /**
+             * @brief Read the latency histograms of the loop. Safe to call from any thread.
+             *
+             * @details Empty unless `enable_latency_tracking` was called.
+             *
+             * @return A snapshot of the histograms.
+             */
+            inline event_loop_latency
+            latency() const noexcept
+            {
+                return event_loop_latency{
+                    .queue_delay_      = queue_delay_.snapshot(),
+                    .completion_delay_ = completion_delay_.snapshot()};
+            }
+
+            /**
+             * @brief Publish the start time and identity of every event the loop runs so that a
+             *        `watchdog` can detect stalls. Must be called before the loop is run.
+             */
+            inline void
+            enable_step_monitoring() noexcept
+            {
+                monitor_steps_ = true;
+            }
+
+            /**
+             * @brief The step the loop is currently running. Safe to read from any thread.
+             *
+             * @details Never started unless `enable_step_monitoring` was called.
+             */
+            inline const details::step_monitor&
+            steps() const noexcept
+            {
+                return steps_;
+            }
+
+            /**
+             * @brief Record timer waits that have fired on this loop. Must be called from the
+             *        thread running the loop.
+             *
+             * @param _amount The number of waits that fired.
+             */
+            inline void
+            count_timer_fires(std::uint64_t _amount) noexcept
+            {
+                counters_.timer_fires_.add(_amount);
+            }
+
             /**
              * @brief Get the stop function for the run time.
              *
@@ -942,6 +1358,9 @@ namespace zab {
             /**
              * @brief Wakes the event loop by inserting a user space event.
              *
+             * @details The write is submitted through the ring of `_from`, so this must be
+             *          called on the thread running `_from`. Falls back to `wake()` if the
+             *          submission queue of `_from` is full.
              *
              * @param _from The event_loop to wake up from.
              */
@@ -960,19 +1379,42 @@ namespace zab {
 
         private:
 
+            static void
+            woken(void*) noexcept
+            { }
+
             async_function<>
             run_user_space(std::stop_token _st) noexcept;
 
+            void
+            submit() noexcept;
+
             std::unique_ptr<io_uring> ring_;
 
             static constexpr int kWriteIndex = 0;
             static constexpr int kReadIndex  = 1;
 
+            struct queued_event {
+                    user_event    event_;
+                    std::uint64_t queued_at_;
+            };
+
             int                      user_space_event_fd_;
-            std::atomic<std::size_t> size_;
-            spin_lock                mtx_;
-            std::deque<user_event>   handles_[2];
+            atomic<std::size_t>      size_;
+            spin_mutex               mtx_;
+            std::deque<queued_event> handles_[2];
             cancelation_token        use_space_handle_;
+            io_event                 wake_event_{
+                .handle_ = event<>{.cb_ = &woken, .context_ = nullptr},
+                .result_ = 0};
+            details::loop_counters   counters_;
+            atomic<std::thread::id>  owner_;
+            bool                     track_latency_ = false;
+            latency_histogram        queue_delay_;
+            latency_histogram        completion_delay_;
+            bool                     monitor_steps_ = false;
+            details::step_monitor    steps_;
+            std::uint32_t            completion_flags_ = 0;
     };
 
 }   // namespace zab
@@ -40,6 +40,8 @@
 #include <coroutine>
 #include <iostream>
 
+#include "zab/tracing.hpp"
+
 namespace zab {
 
     /**
@@ -90,7 +92,9 @@ namespace zab {
              */
             void
             return_void() noexcept
-            { }
+            {
+                tracing::complete("async_function", get_return_object().address());
+            }
 
             /**
              * @brief      Exceptions are currently not implermented.
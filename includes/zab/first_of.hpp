@@ -37,12 +37,12 @@
 #ifndef ZAB_FIRTS_OF_HPP
 #define ZAB_FIRTS_OF_HPP
 
-#include <atomic>
 #include <memory>
 
 #include "zab/async_semaphore.hpp"
 #include "zab/event.hpp"
 #include "zab/strong_types.hpp"
+#include "zab/threading.hpp"
 #include "zab/wait_for.hpp"
 #include "zab/yield.hpp"
 
@@ -112,7 +112,7 @@ namespace zab {
             co_await zab::pause(
                 [&](auto _pp) noexcept
                 {
-                    auto handle    = std::make_shared<std::atomic<zab::pause_pack*>>(_pp);
+                    auto handle    = std::make_shared<atomic<zab::pause_pack*>>(_pp);
                     _pp->thread_   = resume_thread;
                     auto functions = std::make_tuple(std::reference_wrapper(_args)...);
 
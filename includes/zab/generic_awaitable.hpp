@@ -38,9 +38,11 @@
 #define ZAB_GENERIC_AWAITABLE_HPP_
 
 #include <coroutine>
+#include <source_location>
 #include <type_traits>
 
 #include "zab/event.hpp"
+#include "zab/introspection.hpp"
 
 namespace zab {
 
@@ -148,7 +150,9 @@ namespace zab {
             generic_awaitable&
             operator=(generic_awaitable&& _move_op) = default;
 
-            generic_awaitable(Functor* _functor) : functor_(_functor) { }
+            generic_awaitable(Functor* _functor, const std::source_location& _location = {})
+                : functor_(_functor), wait_(_location)
+            { }
 
             template <typename F = Functor, typename PromiseType>
             auto
@@ -161,6 +165,8 @@ namespace zab {
             auto
             await_suspend(tagged_event _event) noexcept
             {
+                wait_.begin(event_address(_event), "suspension_point");
+
                 if constexpr (details::PassThroughSuspend<F>)
                 {
                     if constexpr (std::is_void_v<decltype(functor_->await_suspend(_event))>)
@@ -263,6 +269,8 @@ namespace zab {
             decltype(auto)
             await_resume() noexcept
             {
+                wait_.end();
+
                 if constexpr (details::PassThroughResume<F>) { return functor_->await_resume(); }
                 else if constexpr (details::GenericResume<F>)
                 {
@@ -283,6 +291,16 @@ namespace zab {
                 return functor_;
             }
 
+            /**
+             * @brief Where the awaitable was created. Only kept for `introspection` and
+             *        `profiler` builds.
+             */
+            std::source_location
+            location() const noexcept
+            {
+                return wait_.location();
+            }
+
         protected:
 
             bool
@@ -318,7 +336,8 @@ namespace zab {
 
         private:
 
-            Functor* functor_;
+            Functor*                                                 functor_;
+            [[no_unique_address]] introspection::details::wait_scope wait_;
     };
 
     template <typename Functor, typename AwaitableType = generic_awaitable<Functor>>
@@ -326,9 +345,17 @@ namespace zab {
 
         public:
 
-            suspension_point(Functor&& _functor) : functor_(std::move(_functor)), at_(&functor_) { }
+            suspension_point(
+                Functor&&            _functor,
+                std::source_location _location = std::source_location::current())
+                : functor_(std::move(_functor)), at_(&functor_, _location)
+            { }
 
-            suspension_point(const Functor& _functor) : functor_(_functor), at_(&functor_) { }
+            suspension_point(
+                const Functor&       _functor,
+                std::source_location _location = std::source_location::current())
+                : functor_(_functor), at_(&functor_, _location)
+            { }
 
             template <typename... Args>
             suspension_point(Args&&... _args)
@@ -336,7 +363,7 @@ namespace zab {
             { }
 
             suspension_point(suspension_point&& _move)
-                : functor_(std::move(_move.functor_)), at_(&functor_)
+                : functor_(std::move(_move.functor_)), at_(&functor_, _move.at_.location())
             { }
 
             suspension_point&
@@ -0,0 +1,310 @@
+/*
+ *  MMM"""AMV       db      `7MM"""Yp,
+ *  M'   AMV       ;MM:       MM    Yb
+ *  '   AMV       ,V^MM.      MM    dP
+ *     AMV       ,M  `MM      MM"""bg.
+ *    AMV   ,    AbmmmqMA     MM    `Y
+ *   AMV   ,M   A'     VML    MM    ,9
+ *  AMVmmmmMM .AMA.   .AMMA..JMMmmmd9
+ *
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021 Donald-Rupin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ *  @file introspection.hpp
+ *
+ */
+
+#ifndef ZAB_INTROSPECTION_HPP_
+#define ZAB_INTROSPECTION_HPP_
+
+#include <chrono>
+#include <cstddef>
+#include <iosfwd>
+#include <signal.h>
+#include <source_location>
+#include <vector>
+
+#include "zab/profiler.hpp"
+
+namespace zab {
+
+#ifdef ZAB_INTROSPECTION
+    /**
+     * @brief Set when zab is compiled with `ZAB_INTROSPECTION`. Otherwise suspended coroutines are
+     *        not registered.
+     */
+    inline constexpr bool kIntrospection = true;
+#else
+    inline constexpr bool kIntrospection = false;
+#endif
+
+#if defined(ZAB_INTROSPECTION) || defined(ZAB_PROFILING)
+#define ZAB_WAIT_REGISTRY
+#endif
+
+    class engine;
+
+    /**
+     * @brief A registry of every coroutine currently suspended on a zab awaitable, for finding out
+     *        what a degraded service is waiting on.
+     *
+     * @details Waits are registered by `suspension_point`, `async_mutex`,
+     *          `async_counting_semaphore`, `async_barrier`, `timer_service` and the `event_loop`
+     *          io operations when compiled with `ZAB_INTROSPECTION`. Each wait is keyed by the
+     *          coroutine (or event context) that will be resumed, so a wait that is refined further
+     *          down (a `suspension_point` that submits a `recv`) is counted once under the most
+     *          specific kind.
+     *
+     *          The registry is also kept when compiled with `ZAB_PROFILING`, see `profiler`.
+     */
+    namespace introspection {
+
+        /**
+         * @brief Set when waits are registered, which is when compiled with `ZAB_INTROSPECTION` or
+         *        `ZAB_PROFILING`.
+         */
+        inline constexpr bool kEnabled = kIntrospection || kProfiling;
+
+        /**
+         * @brief The default age after which a wait is counted as long.
+         */
+        inline constexpr std::chrono::nanoseconds kDefaultThreshold = std::chrono::seconds(1);
+
+        /**
+         * @brief All of the waits on the same kind of awaitable and object.
+         */
+        struct wait_group {
+
+                /**
+                 * @brief The kind of awaitable, such as "async_mutex" or "recv".
+                 */
+                const char* kind_;
+
+                /**
+                 * @brief The object waited on, such as the mutex. nullptr for io and plain
+                 *        suspension points.
+                 */
+                const void* object_;
+
+                /**
+                 * @brief The number of suspended coroutines.
+                 */
+                std::size_t count_;
+
+                /**
+                 * @brief The number that have been suspended for longer than the threshold.
+                 */
+                std::size_t over_threshold_;
+
+                /**
+                 * @brief How long the oldest has been suspended for.
+                 */
+                std::chrono::nanoseconds oldest_;
+        };
+
+        namespace details {
+
+            void
+            begin(
+                const void*                 _waiter,
+                const char*                 _kind,
+                const void*                 _object,
+                const std::source_location& _location) noexcept;
+
+            void
+            relabel(const void* _waiter, const char* _kind, const void* _object) noexcept;
+
+            void
+            end(const void* _waiter) noexcept;
+
+        }   // namespace details
+
+        /**
+         * @brief Register a suspended coroutine.
+         *
+         * @details Must be called before the coroutine can be resumed by another thread.
+         *
+         * @param _waiter The address of the coroutine (or event context) that will be resumed.
+         * @param _kind A string literal naming the awaitable.
+         * @param _object The object waited on, if any.
+         * @param _location Where the awaitable was created, for the `profiler`.
+         */
+        inline void
+        begin(
+            const void*                 _waiter,
+            const char*                 _kind,
+            const void*                 _object   = nullptr,
+            const std::source_location& _location = {}) noexcept
+        {
+            if constexpr (kEnabled) { details::begin(_waiter, _kind, _object, _location); }
+        }
+
+        /**
+         * @brief Give a registered wait a more specific kind. Does nothing if `_waiter` is not
+         *        registered.
+         *
+         * @param _waiter The address of the coroutine (or event context) that will be resumed.
+         * @param _kind A string literal naming the awaitable.
+         * @param _object The object waited on, if any.
+         */
+        inline void
+        relabel(const void* _waiter, const char* _kind, const void* _object = nullptr) noexcept
+        {
+            if constexpr (kEnabled) { details::relabel(_waiter, _kind, _object); }
+        }
+
+        /**
+         * @brief Remove a wait once the coroutine has resumed. Does nothing for nullptr.
+         *
+         * @param _waiter The address given to `begin`.
+         */
+        inline void
+        end(const void* _waiter) noexcept
+        {
+            if constexpr (kEnabled)
+            {
+                if (_waiter) { details::end(_waiter); }
+            }
+        }
+
+        namespace details {
+
+            /**
+             * @brief Held by an awaitable to end the wait it began, along with where the
+             *        awaitable was created. Empty unless compiled with `ZAB_INTROSPECTION` or
+             *        `ZAB_PROFILING`.
+             */
+            class wait_scope {
+
+                public:
+
+                    constexpr wait_scope(
+                        [[maybe_unused]] const std::source_location& _location = {}) noexcept
+#ifdef ZAB_WAIT_REGISTRY
+                        : location_(_location)
+#endif
+                    { }
+
+                    inline void
+                    begin(
+                        [[maybe_unused]] const void* _waiter,
+                        [[maybe_unused]] const char* _kind,
+                        [[maybe_unused]] const void* _object = nullptr) noexcept
+                    {
+#ifdef ZAB_WAIT_REGISTRY
+                        waiter_ = _waiter;
+                        introspection::begin(_waiter, _kind, _object, location_);
+#endif
+                    }
+
+                    inline void
+                    end() noexcept
+                    {
+#ifdef ZAB_WAIT_REGISTRY
+                        introspection::end(waiter_);
+                        waiter_ = nullptr;
+#endif
+                    }
+
+                    inline std::source_location
+                    location() const noexcept
+                    {
+#ifdef ZAB_WAIT_REGISTRY
+                        return location_;
+#else
+                        return {};
+#endif
+                    }
+
+#ifdef ZAB_WAIT_REGISTRY
+                private:
+
+                    const void*          waiter_ = nullptr;
+                    std::source_location location_;
+#endif
+            };
+
+        }   // namespace details
+
+        /**
+         * @brief The number of suspended coroutines.
+         */
+        std::size_t
+        waiting() noexcept;
+
+        /**
+         * @brief Aggregate the suspended coroutines by kind and object.
+         *
+         * @param _threshold The age after which a wait is counted in `over_threshold_`.
+         * @return The groups, largest first.
+         */
+        std::vector<wait_group>
+        snapshot(std::chrono::nanoseconds _threshold = kDefaultThreshold);
+
+        /**
+         * @brief Write the aggregated waits as text, for example:
+         *
+         * @code
+         *  zab::introspection 4324 suspended
+         *      4312 on recv, 0 for >1000ms, oldest 820ms
+         *      12 on async_mutex 0x6020000000d0, 12 for >1000ms, oldest 5100ms
+         * @endcode
+         *
+         * @param _out The stream to write to.
+         * @param _threshold The age after which a wait is counted as long.
+         */
+        void
+        dump(std::ostream& _out, std::chrono::nanoseconds _threshold = kDefaultThreshold);
+
+        /**
+         * @brief Dump the waits whenever the process receives `_signal`, via the engine's
+         *        `signal_handler`.
+         *
+         * @param _engine The engine.
+         * @param _signal The signal to dump on.
+         * @param _out The stream to write to. Must outlive the engine.
+         * @param _threshold The age after which a wait is counted as long.
+         * @return If the handler was registered.
+         */
+        bool
+        dump_on_signal(
+            engine*                  _engine,
+            int                      _signal,
+            std::ostream&            _out,
+            std::chrono::nanoseconds _threshold = kDefaultThreshold);
+
+        /**
+         * @brief Dump the waits to std::cerr whenever the process receives `_signal`.
+         *
+         * @param _engine The engine.
+         * @param _signal The signal to dump on.
+         * @return If the handler was registered.
+         */
+        bool
+        dump_on_signal(engine* _engine, int _signal = SIGUSR2);
+
+    }   // namespace introspection
+
+}   // namespace zab
+
+#endif /* ZAB_INTROSPECTION_HPP_ */
@@ -0,0 +1,276 @@
+/*
+ *  MMM"""AMV       db      `7MM"""Yp,
+ *  M'   AMV       ;MM:       MM    Yb
+ *  '   AMV       ,V^MM.      MM    dP
+ *     AMV       ,M  `MM      MM"""bg.
+ *    AMV   ,    AbmmmqMA     MM    `Y
+ *   AMV   ,M   A'     VML    MM    ,9
+ *  AMVmmmmMM .AMA.   .AMMA..JMMmmmd9
+ *
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021 Donald-Rupin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ *  @file latency_histogram.hpp
+ *
+ */
+
+#ifndef ZAB_LATENCY_HISTOGRAM_HPP_
+#define ZAB_LATENCY_HISTOGRAM_HPP_
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "zab/metrics.hpp"
+
+namespace zab {
+
+    namespace details {
+
+        /**
+         * @brief The bucket layout shared by `latency_histogram` and its snapshots.
+         *
+         * @details Values below 16 get exact buckets. Above that, every power of two range is
+         *          split into 16 linear sub buckets, so any recorded value is reported within
+         *          6.25% of its true value.
+         */
+        struct histogram_layout {
+
+                static constexpr std::size_t kSubBucketBits = 4;
+                static constexpr std::size_t kSubBuckets    = 1 << kSubBucketBits;
+                static constexpr std::size_t kBuckets       = 64 * kSubBuckets;
+
+                static constexpr std::size_t
+                index(std::uint64_t _value) noexcept
+                {
+                    if (_value < kSubBuckets) { return _value; }
+
+                    std::size_t shift = std::bit_width(_value) - 1 - kSubBucketBits;
+                    std::size_t sub   = (_value >> shift) & (kSubBuckets - 1);
+                    return (shift + 1) * kSubBuckets + sub;
+                }
+
+                static constexpr std::uint64_t
+                highest_equivalent(std::size_t _index) noexcept
+                {
+                    if (_index < kSubBuckets) { return _index; }
+
+                    std::size_t shift = _index / kSubBuckets - 1;
+                    std::size_t sub   = _index % kSubBuckets;
+                    return (((kSubBuckets + sub) << shift) + (std::uint64_t{1} << shift)) - 1;
+                }
+        };
+
+    }   // namespace details
+
+    /**
+     * @brief A point in time copy of a `latency_histogram` that can be queried and combined.
+     */
+    class latency_snapshot {
+
+        public:
+
+            latency_snapshot() : counts_(details::histogram_layout::kBuckets, 0) { }
+
+            /**
+             * @brief The number of recorded values.
+             */
+            inline std::uint64_t
+            count() const noexcept
+            {
+                return total_;
+            }
+
+            /**
+             * @brief The value at or below which `_percentile` percent of values fall.
+             *
+             * @param _percentile In the range [0, 100].
+             * @return The value, or 0 if nothing was recorded.
+             */
+            std::chrono::nanoseconds
+            percentile(double _percentile) const noexcept
+            {
+                if (!total_) { return std::chrono::nanoseconds(0); }
+
+                _percentile = std::clamp(_percentile, 0.0, 100.0);
+                auto          rank   = (std::uint64_t) (_percentile / 100.0 * total_ + 0.5);
+                std::uint64_t target = std::max<std::uint64_t>(1, rank);
+
+                std::uint64_t seen = 0;
+                for (std::size_t i = 0; i < counts_.size(); ++i)
+                {
+                    seen += counts_[i];
+                    if (seen >= target)
+                    {
+                        return std::chrono::nanoseconds(
+                            details::histogram_layout::highest_equivalent(i));
+                    }
+                }
+
+                return max();
+            }
+
+            /**
+             * @brief The largest recorded value, to histogram precision.
+             */
+            std::chrono::nanoseconds
+            max() const noexcept
+            {
+                for (std::size_t i = counts_.size(); i > 0; --i)
+                {
+                    if (counts_[i - 1])
+                    {
+                        return std::chrono::nanoseconds(
+                            details::histogram_layout::highest_equivalent(i - 1));
+                    }
+                }
+
+                return std::chrono::nanoseconds(0);
+            }
+
+            /**
+             * @brief The sum of the recorded values.
+             */
+            std::chrono::nanoseconds
+            sum() const noexcept
+            {
+                return std::chrono::nanoseconds(sum_);
+            }
+
+            /**
+             * @brief The mean of the recorded values.
+             */
+            std::chrono::nanoseconds
+            mean() const noexcept
+            {
+                return std::chrono::nanoseconds(total_ ? sum_ / total_ : 0);
+            }
+
+            /**
+             * @brief Merge another snapshot into this one.
+             *
+             * @param _other The snapshot to add.
+             * @return This snapshot.
+             */
+            latency_snapshot&
+            operator+=(const latency_snapshot& _other) noexcept
+            {
+                for (std::size_t i = 0; i < counts_.size(); ++i)
+                {
+                    counts_[i] += _other.counts_[i];
+                }
+
+                total_ += _other.total_;
+                sum_ += _other.sum_;
+                return *this;
+            }
+
+        private:
+
+            friend class latency_histogram;
+
+            std::vector<std::uint64_t> counts_;
+            std::uint64_t              total_ = 0;
+            std::uint64_t              sum_   = 0;
+    };
+
+    /**
+     * @brief A log linear histogram of nanosecond latencies.
+     *
+     * @details Has a single writer that never takes a lock or issues a locked instruction. Any
+     *          thread may take a `snapshot`, including under ZAB_SINGLE_THREADED. A snapshot is
+     *          consistent per bucket but may miss values recorded concurrently.
+     */
+    class latency_histogram {
+
+        public:
+
+            /**
+             * @brief Record a latency.
+             *
+             * @param _nanoseconds The latency.
+             */
+            inline void
+            record(std::uint64_t _nanoseconds) noexcept
+            {
+                buckets_[details::histogram_layout::index(_nanoseconds)].add();
+                sum_.add(_nanoseconds);
+            }
+
+            /**
+             * @brief Copy out the current state.
+             *
+             * @return The snapshot.
+             */
+            latency_snapshot
+            snapshot() const noexcept
+            {
+                latency_snapshot result;
+                for (std::size_t i = 0; i < buckets_.size(); ++i)
+                {
+                    result.counts_[i] = buckets_[i].get();
+                    result.total_ += result.counts_[i];
+                }
+
+                result.sum_ = sum_.get();
+                return result;
+            }
+
+        private:
+
+            std::array<details::metric_counter, details::histogram_layout::kBuckets> buckets_;
+            details::metric_counter                                                 sum_;
+    };
+
+    /**
+     * @brief The latency histograms of one or more event_loops.
+     */
+    struct event_loop_latency {
+
+            /**
+             * @brief Time from `dispatch_user_event` until the event is executed. This is the
+             *        loop lag.
+             */
+            latency_snapshot queue_delay_;
+
+            /**
+             * @brief Time from a completion being reaped until its coroutine is resumed.
+             */
+            latency_snapshot completion_delay_;
+
+            event_loop_latency&
+            operator+=(const event_loop_latency& _other) noexcept
+            {
+                queue_delay_ += _other.queue_delay_;
+                completion_delay_ += _other.completion_delay_;
+                return *this;
+            }
+    };
+
+}   // namespace zab
+
+#endif /* ZAB_LATENCY_HISTOGRAM_HPP_ */
@@ -0,0 +1,203 @@
+/*
+ *  MMM"""AMV       db      `7MM"""Yp,
+ *  M'   AMV       ;MM:       MM    Yb
+ *  '   AMV       ,V^MM.      MM    dP
+ *     AMV       ,M  `MM      MM"""bg.
+ *    AMV   ,    AbmmmqMA     MM    `Y
+ *   AMV   ,M   A'     VML    MM    ,9
+ *  AMVmmmmMM .AMA.   .AMMA..JMMmmmd9
+ *
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021 Donald-Rupin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ *  @file metrics.hpp
+ *
+ */
+
+#ifndef ZAB_METRICS_HPP_
+#define ZAB_METRICS_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace zab {
+
+    /**
+     * @brief A snapshot of the runtime counters of one or more event_loops.
+     */
+    struct event_loop_metrics {
+
+            /**
+             * @brief Submission queue entries handed to the kernel.
+             */
+            std::uint64_t sqes_submitted_ = 0;
+
+            /**
+             * @brief Completion queue entries processed.
+             */
+            std::uint64_t cqes_reaped_ = 0;
+
+            /**
+             * @brief Calls to `io_uring_submit` with work pending.
+             */
+            std::uint64_t submit_syscalls_ = 0;
+
+            /**
+             * @brief Times the loop had no completions ready and blocked in the kernel.
+             */
+            std::uint64_t wait_syscalls_ = 0;
+
+            /**
+             * @brief User events pushed into the loop from any thread.
+             */
+            std::uint64_t user_events_dispatched_ = 0;
+
+            /**
+             * @brief User events the loop has executed.
+             */
+            std::uint64_t user_events_executed_ = 0;
+
+            /**
+             * @brief Times another thread had to wake the loop to hand it user events.
+             */
+            std::uint64_t cross_thread_wakes_ = 0;
+
+            /**
+             * @brief Times an operation failed with -ENOMEM because the submission queue was
+             *        full.
+             */
+            std::uint64_t sq_full_ = 0;
+
+            /**
+             * @brief Timer waits that have fired on this loop.
+             */
+            std::uint64_t timer_fires_ = 0;
+
+            /**
+             * @brief Time spent blocked waiting for completions.
+             */
+            std::chrono::nanoseconds idle_time_ = {};
+
+            /**
+             * @brief Time spent doing everything else.
+             */
+            std::chrono::nanoseconds busy_time_ = {};
+
+            /**
+             * @brief Accumulate another snapshot into this one.
+             *
+             * @param _other The snapshot to add.
+             * @return This snapshot.
+             */
+            event_loop_metrics&
+            operator+=(const event_loop_metrics& _other) noexcept
+            {
+                sqes_submitted_ += _other.sqes_submitted_;
+                cqes_reaped_ += _other.cqes_reaped_;
+                submit_syscalls_ += _other.submit_syscalls_;
+                wait_syscalls_ += _other.wait_syscalls_;
+                user_events_dispatched_ += _other.user_events_dispatched_;
+                user_events_executed_ += _other.user_events_executed_;
+                cross_thread_wakes_ += _other.cross_thread_wakes_;
+                sq_full_ += _other.sq_full_;
+                timer_fires_ += _other.timer_fires_;
+                idle_time_ += _other.idle_time_;
+                busy_time_ += _other.busy_time_;
+                return *this;
+            }
+    };
+
+    namespace details {
+
+        /**
+         * @brief A counter with a single writer that any thread may read.
+         *
+         * @details Increments are a relaxed load and store, so there is no locked instruction
+         *          on the hot path. If more than one thread writes, they must hold a common lock.
+         *          Always a `std::atomic`, even under ZAB_SINGLE_THREADED, as monitoring threads
+         *          still read it.
+         */
+        class metric_counter {
+
+            public:
+
+                inline void
+                add(std::uint64_t _amount = 1) noexcept
+                {
+                    value_.store(
+                        value_.load(std::memory_order_relaxed) + _amount,
+                        std::memory_order_relaxed);
+                }
+
+                inline std::uint64_t
+                get() const noexcept
+                {
+                    return value_.load(std::memory_order_relaxed);
+                }
+
+            private:
+
+                std::atomic<std::uint64_t> value_ = 0;
+        };
+
+        /**
+         * @brief The live counters owned by an event_loop.
+         */
+        struct loop_counters {
+
+                event_loop_metrics
+                snapshot() const noexcept
+                {
+                    return event_loop_metrics{
+                        .sqes_submitted_         = sqes_submitted_.get(),
+                        .cqes_reaped_            = cqes_reaped_.get(),
+                        .submit_syscalls_        = submit_syscalls_.get(),
+                        .wait_syscalls_          = wait_syscalls_.get(),
+                        .user_events_dispatched_ = user_events_dispatched_.get(),
+                        .user_events_executed_   = user_events_executed_.get(),
+                        .cross_thread_wakes_     = cross_thread_wakes_.get(),
+                        .sq_full_                = sq_full_.get(),
+                        .timer_fires_            = timer_fires_.get(),
+                        .idle_time_              = std::chrono::nanoseconds(idle_ns_.get()),
+                        .busy_time_              = std::chrono::nanoseconds(busy_ns_.get())};
+                }
+
+                metric_counter sqes_submitted_;
+                metric_counter cqes_reaped_;
+                metric_counter submit_syscalls_;
+                metric_counter wait_syscalls_;
+                metric_counter user_events_dispatched_;
+                metric_counter user_events_executed_;
+                metric_counter cross_thread_wakes_;
+                metric_counter sq_full_;
+                metric_counter timer_fires_;
+                metric_counter idle_ns_;
+                metric_counter busy_ns_;
+        };
+
+    }   // namespace details
+
+}   // namespace zab
+
+#endif /* ZAB_METRICS_HPP_ */
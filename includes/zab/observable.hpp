@@ -41,7 +41,6 @@
 #include <coroutine>
 #include <deque>
 #include <memory>
-#include <mutex>
 #include <optional>
 #include <utility>
 
@@ -49,6 +48,7 @@
 #include "zab/async_mutex.hpp"
 #include "zab/engine_enabled.hpp"
 #include "zab/simple_future.hpp"
+#include "zab/threading.hpp"
 
 namespace zab {
 
@@ -82,7 +82,7 @@ namespace zab {
 
                         if (handle_) { handle_.destroy(); }
                     }
-                    std::mutex              mtx_;
+                    mutex                   mtx_;
                     pending_result*         result_;
                     std::coroutine_handle<> handle_;
                     thread_t                thread_;
@@ -37,10 +37,10 @@
 #ifndef ZAB_PAUSE_TOKEN_HPP_
 #define ZAB_PAUSE_TOKEN_HPP_
 
-#include <atomic>
 
 #include "zab/engine.hpp"
 #include "zab/strong_types.hpp"
+#include "zab/threading.hpp"
 
 namespace zab {
 
@@ -209,7 +209,7 @@ namespace zab {
 
             engine* engine_;
 
-            std::atomic<std::uintptr_t> resuming_ = 0;
+            atomic<std::uintptr_t> resuming_ = 0;
     };
 
 }   // namespace zab
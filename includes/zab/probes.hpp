@@ -0,0 +1,91 @@
+/*
+ *  MMM"""AMV       db      `7MM"""Yp,
+ *  M'   AMV       ;MM:       MM    Yb
+ *  '   AMV       ,V^MM.      MM    dP
+ *     AMV       ,M  `MM      MM"""bg.
+ *    AMV   ,    AbmmmqMA     MM    `Y
+ *   AMV   ,M   A'     VML    MM    ,9
+ *  AMVmmmmMM .AMA.   .AMMA..JMMmmmd9
+ *
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021 Donald-Rupin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ *  @file probes.hpp
+ *
+ */
+
+#ifndef ZAB_PROBES_HPP_
+#define ZAB_PROBES_HPP_
+
+/**
+ * @brief USDT (systemtap sdt.h) probe points under the `zab` provider.
+ *
+ * @details A probe is a single nop in the instruction stream plus an ELF note, so it costs
+ *          nothing until a tracer such as bpftrace or perf attaches to it. Probes are compiled in
+ *          when <sys/sdt.h> is available and `ZAB_NO_USDT` is not defined. Arguments must be
+ *          integers or pointers.
+ *
+ *          The probes are:
+ *
+ *          | probe           | arguments                                   |
+ *          |-----------------|---------------------------------------------|
+ *          | loop_reaped     | completions reaped in the batch             |
+ *          | loop_submit     | sqes ready, sqes submitted (or -errno)      |
+ *          | user_event      | queue depth after the push, woke the loop   |
+ *          | thread_resume   | target thread                               |
+ *          | timer_fire      | timers resumed, timer service time (ns)     |
+ *          | timer_rearm     | nanoseconds until the next expiry, 0 disarm |
+ *          | tcp_read        | descriptor, result (bytes or -errno)        |
+ *          | tcp_write       | descriptor, result (bytes or -errno)        |
+ *
+ *          See scripts/bpftrace for examples.
+ */
+
+#if !defined(ZAB_NO_USDT) && __has_include(<sys/sdt.h>)
+
+#include <sys/sdt.h>
+
+#define ZAB_PROBE(_name, ...) STAP_PROBEV(zab, _name __VA_OPT__(, ) __VA_ARGS__)
+
+namespace zab {
+
+    /**
+     * @brief Set when zab is compiled with USDT probes.
+     */
+    inline constexpr bool kProbes = true;
+
+}   // namespace zab
+
+#else
+
+#define ZAB_PROBE(_name, ...) static_cast<void>(0)
+
+namespace zab {
+
+    inline constexpr bool kProbes = false;
+
+}   // namespace zab
+
+#endif
+
+#endif /* ZAB_PROBES_HPP_ */
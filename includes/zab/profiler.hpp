@@ -0,0 +1,147 @@
+/*
+ *  MMM"""AMV       db      `7MM"""Yp,
+ *  M'   AMV       ;MM:       MM    Yb
+ *  '   AMV       ,V^MM.      MM    dP
+ *     AMV       ,M  `MM      MM"""bg.
+ *    AMV   ,    AbmmmqMA     MM    `Y
+ *   AMV   ,M   A'     VML    MM    ,9
+ *  AMVmmmmMM .AMA.   .AMMA..JMMmmmd9
+ *
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021 Donald-Rupin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ *  @file profiler.hpp
+ *
+ */
+
+#ifndef ZAB_PROFILER_HPP_
+#define ZAB_PROFILER_HPP_
+
+#include <cstdint>
+#include <iosfwd>
+#include <source_location>
+#include <string>
+#include <vector>
+
+#include "zab/latency_histogram.hpp"
+
+namespace zab {
+
+#ifdef ZAB_PROFILING
+    /**
+     * @brief Set when zab is compiled with `ZAB_PROFILING`. Otherwise nothing is profiled.
+     */
+    inline constexpr bool kProfiling = true;
+#else
+    inline constexpr bool kProfiling = false;
+#endif
+
+    /**
+     * @brief Measures how long coroutines spend suspended, per awaitable kind and `co_await` site.
+     *
+     * @details Built on the `introspection` registry, which is kept when compiled with
+     *          `ZAB_PROFILING`. When a wait ends its duration is recorded in the resuming thread's
+     *          table under the wait's kind ("async_mutex", "timer", "recv", ...) and the source
+     *          location its awaitable was created at. `timer_service::wait` and
+     *          `async_mutex::lock` take the caller's location. Other `suspension_point`s are
+     *          located at the zab function that created them.
+     */
+    namespace profiler {
+
+        /**
+         * @brief The merged profile of one awaitable kind at one source location.
+         */
+        struct site_profile {
+
+                /**
+                 * @brief The kind of awaitable, such as "async_mutex" or "recv".
+                 */
+                std::string kind_;
+
+                /**
+                 * @brief The file of the site, empty if unknown.
+                 */
+                std::string file_;
+
+                /**
+                 * @brief The line of the site, 0 if unknown.
+                 */
+                std::uint_least32_t line_;
+
+                /**
+                 * @brief The function of the site.
+                 */
+                std::string function_;
+
+                /**
+                 * @brief The time spent suspended at the site.
+                 */
+                latency_snapshot suspended_;
+
+                /**
+                 * @brief The total time spent suspended at the site.
+                 */
+                inline std::chrono::nanoseconds
+                total() const noexcept
+                {
+                    return suspended_.sum();
+                }
+        };
+
+        namespace details {
+
+            void
+            record(
+                const char*                 _kind,
+                const std::source_location& _location,
+                std::uint64_t               _nanoseconds) noexcept;
+
+        }   // namespace details
+
+        /**
+         * @brief Merge the tables of every thread.
+         *
+         * @return The sites, most total time suspended first.
+         */
+        std::vector<site_profile>
+        merge();
+
+        /**
+         * @brief Write the merged profile as a table.
+         *
+         * @param _out The stream to write to.
+         */
+        void
+        print(std::ostream& _out);
+
+        /**
+         * @brief Discard everything recorded so far.
+         */
+        void
+        reset() noexcept;
+
+    }   // namespace profiler
+
+}   // namespace zab
+
+#endif /* ZAB_PROFILER_HPP_ */
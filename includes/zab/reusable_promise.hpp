@@ -128,8 +128,10 @@ namespace zab {
             {
                 struct {
                         std::coroutine_handle<>
-                        await_suspend(std::coroutine_handle<>) noexcept
+                        await_suspend(std::coroutine_handle<> _us) noexcept
                         {
+                            tracing::instant("reusable_promise yield", _us.address());
+
                             if (next_) { return next_; }
                             else
                             {
@@ -357,8 +359,10 @@ namespace zab {
             {
                 struct {
                         std::coroutine_handle<>
-                        await_suspend(std::coroutine_handle<>) noexcept
+                        await_suspend(std::coroutine_handle<> _us) noexcept
                         {
+                            tracing::instant("reusable_promise yield", _us.address());
+
                             if (next_) { return next_; }
                             else
                             {
@@ -0,0 +1,380 @@
+/*
+ *  MMM"""AMV       db      `7MM"""Yp,
+ *  M'   AMV       ;MM:       MM    Yb
+ *  '   AMV       ,V^MM.      MM    dP
+ *     AMV       ,M  `MM      MM"""bg.
+ *    AMV   ,    AbmmmqMA     MM    `Y
+ *   AMV   ,M   A'     VML    MM    ,9
+ *  AMVmmmmMM .AMA.   .AMMA..JMMmmmd9
+ *
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021 Donald-Rupin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ *  @file send_queue.hpp
+ *
+ */
+
+#ifndef ZAB_SEND_QUEUE_HPP_
+#define ZAB_SEND_QUEUE_HPP_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <span>
+#include <vector>
+
+#include "zab/async_function.hpp"
+#include "zab/event.hpp"
+#include "zab/generic_awaitable.hpp"
+#include "zab/memory_type.hpp"
+#include "zab/socket_options.hpp"
+#include "zab/tcp_stream.hpp"
+
+namespace zab {
+
+    /**
+     * @brief A snapshot of the counters of a send_queue.
+     */
+    struct send_queue_metrics {
+
+            /**
+             * @brief Bytes queued and not yet written to the socket, including those being
+             *        written.
+             */
+            std::size_t queued_bytes_ = 0;
+
+            /**
+             * @brief The most bytes that have been queued at once.
+             */
+            std::size_t peak_queued_bytes_ = 0;
+
+            /**
+             * @brief Producers currently waiting for space.
+             */
+            std::size_t waiting_producers_ = 0;
+
+            /**
+             * @brief Bytes written to the socket.
+             */
+            std::uint64_t bytes_sent_ = 0;
+
+            /**
+             * @brief Writes made to the socket, each of every buffer queued at the time.
+             */
+            std::uint64_t writes_ = 0;
+
+            /**
+             * @brief Times a producer had to wait for space.
+             */
+            std::uint64_t producer_waits_ = 0;
+    };
+
+    /**
+     * @brief A bounded queue of outgoing data for a tcp_stream, so that a slow reader holds
+     *        up its producers instead of growing memory without limit.
+     *
+     * @details Pushed data is copied in to the queue and written in the background, every
+     *          buffer queued at the time in one `::sendmsg()`. Once the queued bytes reach the
+     *          high watermark, producers wait. They are let back in, in the order they arrived,
+     *          once the queue drains to the low watermark, and until it reaches the high
+     *          watermark again.
+     *
+     *          TCP_NOTSENT_LOWAT is set to the low watermark by default, so that the kernel
+     *          also stops accepting data once that much is waiting to be sent. Without it, a
+     *          slow reader's socket buffer fills before the queue does.
+     *
+     *          If a write fails, everything queued is dropped and every push fails from then
+     *          on. The queue, the stream and the producers must all live in the same thread,
+     *          and the queue must outlive anything pushed to it. Nothing else should write to
+     *          the stream while the queue is in use.
+     *
+     * @tparam DataType The MemoryType of the underlying stream.
+     */
+    template <MemoryType DataType = std::byte>
+    class send_queue {
+
+        public:
+
+            /**
+             * @brief Construct a send queue in front of `_stream`.
+             *
+             * @param _stream The stream to write to. Must outlive the queue.
+             * @param _high_watermark Producers wait once this many bytes are queued.
+             * @param _low_watermark Waiting producers are let back in once the queue has
+             *                       drained to this many bytes. Limited to the high watermark.
+             * @param _limit_kernel_buffer Whether to set TCP_NOTSENT_LOWAT on the stream to
+             *                             the low watermark. If that fails the stream's
+             *                             `last_error()` is set.
+             */
+            send_queue(
+                tcp_stream<DataType>& _stream,
+                std::size_t           _high_watermark,
+                std::size_t           _low_watermark,
+                bool                  _limit_kernel_buffer = true)
+                : stream_(_stream), high_(std::max<std::size_t>(_high_watermark, 1)),
+                  low_(std::min(_low_watermark, high_))
+            {
+                if (_limit_kernel_buffer)
+                {
+                    auto lowat = std::min<std::size_t>(low_, std::numeric_limits<int>::max());
+                    (void) stream_.set_options({.not_sent_lowat_ = (int) lowat});
+                }
+            }
+
+            send_queue(const send_queue&) = delete;
+
+            send_queue&
+            operator=(const send_queue&) = delete;
+
+            /**
+             * @brief Copy `_data` in to the queue, first waiting for space if the queue has
+             *        reached its high watermark or other producers are already waiting.
+             *
+             * @param _data The data to send.
+             * @co_return bool true once the data is queued, or false if a write has failed.
+             */
+            [[nodiscard]] auto
+            push(std::span<const DataType> _data) noexcept
+            {
+                return suspension_point(
+                    [this,
+                     entry = producer{
+                         .data_   = _data,
+                         .handle_ = {},
+                         .result_ = false}]<typename T>(T _handle) mutable noexcept
+                    {
+                        if constexpr (is_ready<T>())
+                        {
+                            if (failed_) { return true; }
+
+                            if (queued_ < high_ && waiting_.empty())
+                            {
+                                enqueue(entry.data_);
+                                entry.result_ = true;
+                                return true;
+                            }
+
+                            return false;
+                        }
+                        else if constexpr (is_suspend<T>())
+                        {
+                            entry.handle_ = _handle;
+                            waiting_.push_back(&entry);
+                            ++producer_waits_;
+                        }
+                        else if constexpr (is_resume<T>())
+                        {
+                            return entry.result_;
+                        }
+                    });
+            }
+
+            /**
+             * @brief Wait until everything queued has been written, such as before shutting
+             *        the stream down.
+             *
+             * @co_return bool true if everything was written, or false if a write failed.
+             */
+            [[nodiscard]] auto
+            flush() noexcept
+            {
+                return suspension_point(
+                    [this]<typename T>(T _handle) noexcept
+                    {
+                        if constexpr (is_ready<T>()) { return failed_ || !queued_; }
+                        else if constexpr (is_suspend<T>())
+                        {
+                            flushing_.push_back(_handle);
+                        }
+                        else if constexpr (is_resume<T>())
+                        {
+                            return !failed_;
+                        }
+                    });
+            }
+
+            /**
+             * @brief The bytes queued and not yet written.
+             */
+            [[nodiscard]] std::size_t
+            queued_bytes() const noexcept
+            {
+                return queued_;
+            }
+
+            /**
+             * @brief Whether a write has failed. The stream's `last_error()` holds why.
+             */
+            [[nodiscard]] bool
+            failed() const noexcept
+            {
+                return failed_;
+            }
+
+            /**
+             * @brief A snapshot of the queue's counters.
+             */
+            [[nodiscard]] send_queue_metrics
+            metrics() const noexcept
+            {
+                return send_queue_metrics{
+                    .queued_bytes_      = queued_,
+                    .peak_queued_bytes_ = peak_queued_,
+                    .waiting_producers_ = waiting_.size(),
+                    .bytes_sent_        = bytes_sent_,
+                    .writes_            = writes_,
+                    .producer_waits_    = producer_waits_};
+            }
+
+        private:
+
+            struct producer {
+                    std::span<const DataType> data_;
+                    tagged_event              handle_;
+                    bool                      result_;
+            };
+
+            /**
+             * @brief Copy `_data` to the back of the queue and start writing if not already.
+             */
+            void
+            enqueue(std::span<const DataType> _data)
+            {
+                if (_data.empty()) { return; }
+
+                buffers_.emplace_back(_data.begin(), _data.end());
+                queued_ += _data.size();
+                peak_queued_ = std::max(peak_queued_, queued_);
+
+                if (!writing_)
+                {
+                    writing_ = true;
+                    write();
+                }
+            }
+
+            /**
+             * @brief Let waiting producers in once the queue has drained to the low watermark.
+             */
+            void
+            admit() noexcept
+            {
+                if (queued_ > low_) { return; }
+
+                while (waiting_.size() && queued_ < high_)
+                {
+                    auto* next = waiting_.front();
+                    waiting_.pop_front();
+
+                    enqueue(next->data_);
+                    next->result_ = true;
+                    execute_event(next->handle_);
+                }
+            }
+
+            /**
+             * @brief Write until the queue is empty or a write fails.
+             */
+            async_function<>
+            write() noexcept
+            {
+                while (buffers_.size() && !failed_)
+                {
+                    /* Buffers pushed while this is in flight go to the back of the deque, which
+                     * leaves these in place. */
+                    spans_.clear();
+                    std::size_t batch = 0;
+                    for (const auto& buffer : buffers_)
+                    {
+                        if (spans_.size() == kMaxBuffers) { break; }
+
+                        spans_.push_back(buffer);
+                        batch += buffer.size();
+                    }
+
+                    ++writes_;
+                    auto written = co_await stream_.write_v(spans_);
+
+                    if (written > 0) { bytes_sent_ += written; }
+                    if (written != (long long) batch) [[unlikely]]
+                    {
+                        failed_ = true;
+                        break;
+                    }
+
+                    buffers_.erase(buffers_.begin(), buffers_.begin() + spans_.size());
+                    queued_ -= batch;
+
+                    admit();
+                }
+
+                writing_ = false;
+
+                if (failed_) [[unlikely]]
+                {
+                    buffers_.clear();
+                    queued_ = 0;
+
+                    while (waiting_.size())
+                    {
+                        auto* next = waiting_.front();
+                        waiting_.pop_front();
+                        execute_event(next->handle_);
+                    }
+                }
+
+                if (!queued_)
+                {
+                    auto flushing = std::move(flushing_);
+                    flushing_.clear();
+                    for (auto handle : flushing)
+                    {
+                        execute_event(handle);
+                    }
+                }
+            }
+
+            /* The most buffers one `::sendmsg()` takes. */
+            static constexpr std::size_t kMaxBuffers = 1024;
+
+            tcp_stream<DataType>&                  stream_;
+            std::deque<std::vector<DataType>>      buffers_;
+            std::deque<producer*>                  waiting_;
+            std::vector<tagged_event>              flushing_;
+            std::vector<std::span<const DataType>> spans_;
+            std::size_t                            high_;
+            std::size_t                            low_;
+            std::size_t                            queued_         = 0;
+            std::size_t                            peak_queued_    = 0;
+            std::uint64_t                          bytes_sent_     = 0;
+            std::uint64_t                          writes_         = 0;
+            std::uint64_t                          producer_waits_ = 0;
+            bool                                   writing_        = false;
+            bool                                   failed_         = false;
+    };
+
+}   // namespace zab
+
+#endif /* ZAB_SEND_QUEUE_HPP_ */
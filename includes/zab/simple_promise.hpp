@@ -57,6 +57,8 @@ namespace zab {
                 {
                     auto& self = _us.promise();
 
+                    tracing::complete("simple_promise", _us.address());
+
                     auto next = self.underlying();
                     self.set_underlying(nullptr);
                     self.complete();
@@ -0,0 +1,157 @@
+/*
+ *  MMM"""AMV       db      `7MM"""Yp,
+ *  M'   AMV       ;MM:       MM    Yb
+ *  '   AMV       ,V^MM.      MM    dP
+ *     AMV       ,M  `MM      MM"""bg.
+ *    AMV   ,    AbmmmqMA     MM    `Y
+ *   AMV   ,M   A'     VML    MM    ,9
+ *  AMVmmmmMM .AMA.   .AMMA..JMMmmmd9
+ *
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021 Donald-Rupin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ *  @file socket_options.hpp
+ *
+ */
+
+#ifndef ZAB_SOCKET_OPTIONS_HPP_
+#define ZAB_SOCKET_OPTIONS_HPP_
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <sys/socket.h>
+
+namespace zab {
+
+    /**
+     * @brief Typed socket options for tcp listeners and streams. Options that are not set are
+     *        left as the system default.
+     */
+    struct socket_options {
+
+            /**
+             * @brief TCP_NODELAY: send small segments straight away instead of batching them
+             *        (Nagle's algorithm).
+             */
+            std::optional<bool> no_delay_ = std::nullopt;
+
+            /**
+             * @brief TCP_QUICKACK: acknowledge straight away instead of delaying. The kernel
+             *        may turn this off again on its own. Streams only.
+             */
+            std::optional<bool> quick_ack_ = std::nullopt;
+
+            /**
+             * @brief SO_BUSY_POLL: microseconds to busy poll the device queue for on a blocking
+             *        receive. Raising it above net.core.busy_read needs CAP_NET_ADMIN.
+             */
+            std::optional<int> busy_poll_ = std::nullopt;
+
+            /**
+             * @brief SO_PREFER_BUSY_POLL: prefer busy polling over softirq processing.
+             */
+            std::optional<bool> prefer_busy_poll_ = std::nullopt;
+
+            /**
+             * @brief SO_SNDBUF: the send buffer size in bytes. The kernel doubles it.
+             */
+            std::optional<int> send_buffer_ = std::nullopt;
+
+            /**
+             * @brief SO_RCVBUF: the receive buffer size in bytes. The kernel doubles it. For
+             *        the window scale to reflect it, it must be set on the listener.
+             */
+            std::optional<int> receive_buffer_ = std::nullopt;
+
+            /**
+             * @brief TCP_DEFER_ACCEPT: seconds to wait for data before completing an accept.
+             *        Listeners only.
+             */
+            std::optional<int> defer_accept_ = std::nullopt;
+
+            /**
+             * @brief TCP_FASTOPEN: the length of the queue of TCP Fast Open requests not yet
+             *        accepted. Listeners only.
+             */
+            std::optional<int> fast_open_ = std::nullopt;
+
+            /**
+             * @brief TCP_NOTSENT_LOWAT: the bytes not yet sent that the kernel will queue
+             *        before the socket stops being writable.
+             */
+            std::optional<int> not_sent_lowat_ = std::nullopt;
+
+            /**
+             * @brief SO_INCOMING_CPU: the cpu whose connections a listener in a SO_REUSEPORT
+             *        group should prefer.
+             */
+            std::optional<int> incoming_cpu_ = std::nullopt;
+
+            /**
+             * @brief SO_REUSEADDR. Listeners only.
+             */
+            bool reuse_address_ = true;
+
+            /**
+             * @brief The numeric address to listen on, such as "127.0.0.1" or "::1". Empty for
+             *        every address. Listeners only.
+             */
+            std::string bind_address_ = {};
+
+            /**
+             * @brief Whether a listener applies these options to each stream it accepts as well.
+             *        Linux already copies some, but not all, from the listener.
+             */
+            bool inherit_ = false;
+    };
+
+    namespace details {
+
+        /**
+         * @brief Apply `_options` to a socket, skipping those that do not apply to a listener
+         *        or a stream.
+         *
+         * @return 0 on success, or the errno of the first option that could not be set.
+         */
+        [[nodiscard]] int
+        apply_socket_options(int _fd, const socket_options& _options, bool _listener) noexcept;
+
+        /**
+         * @brief Fill out the address a listener binds to.
+         *
+         * @return 0 on success, or EINVAL if `_family` is not supported or the bind address is
+         *         not a numeric address of that family.
+         */
+        [[nodiscard]] int
+        make_bind_address(
+            int                      _family,
+            std::uint16_t            _port,
+            const std::string&       _address,
+            struct sockaddr_storage& _out) noexcept;
+
+    }   // namespace details
+
+}   // namespace zab
+
+#endif /* ZAB_SOCKET_OPTIONS_HPP_ */
@@ -0,0 +1,198 @@
+/*
+ *  MMM"""AMV       db      `7MM"""Yp,
+ *  M'   AMV       ;MM:       MM    Yb
+ *  '   AMV       ,V^MM.      MM    dP
+ *     AMV       ,M  `MM      MM"""bg.
+ *    AMV   ,    AbmmmqMA     MM    `Y
+ *   AMV   ,M   A'     VML    MM    ,9
+ *  AMVmmmmMM .AMA.   .AMMA..JMMmmmd9
+ *
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021 Donald-Rupin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ *  @file splice.hpp
+ *
+ */
+
+#ifndef ZAB_SPLICE_HPP_
+#define ZAB_SPLICE_HPP_
+
+#include <cstddef>
+
+#include "zab/async_file.hpp"
+#include "zab/engine.hpp"
+#include "zab/memory_type.hpp"
+#include "zab/simple_future.hpp"
+#include "zab/tcp_stream.hpp"
+
+namespace zab {
+
+    /**
+     * @brief The default capacity of the pipe data is spliced through.
+     */
+    inline constexpr std::size_t kSplicePipeSize = 64 * 1024;
+
+    /**
+     * @brief What a splice() relay moved in each direction before it ended.
+     */
+    struct splice_result {
+
+            /**
+             * @brief The amount moved from the first stream to the second.
+             */
+            long long to_second_ = 0;
+
+            /**
+             * @brief The amount moved from the second stream to the first.
+             */
+            long long to_first_ = 0;
+
+            /**
+             * @brief The errno of the first error in either direction, or 0 if both ended
+             *        cleanly.
+             */
+            int error_ = 0;
+    };
+
+    namespace details {
+
+        /**
+         * @brief Relay between two connected sockets, see splice(). The errno of the first
+         *        failure on each socket is written to `_first_error` and `_second_error`.
+         */
+        guaranteed_future<splice_result>
+        splice_descriptors(
+            engine*     _engine,
+            int         _first,
+            int         _second,
+            std::size_t _pipe_size,
+            int&        _first_error,
+            int&        _second_error);
+
+        /**
+         * @brief Send part of a file to a connected socket, see send_file(). The errno of any
+         *        failure is written to `_error`.
+         */
+        guaranteed_future<long long>
+        send_descriptor(
+            engine*     _engine,
+            int         _file,
+            int         _socket,
+            std::size_t _offset,
+            std::size_t _length,
+            std::size_t _pipe_size,
+            int&        _error);
+
+    }   // namespace details
+
+    /**
+     * @brief Relay data both ways between two streams until both directions have ended. The
+     *        data is spliced through a pipe in the kernel and never copied in to user space.
+     *
+     * @details When one stream stops sending, the other is shut down for writing once
+     *          everything before that has been passed on, and the opposite direction carries
+     *          on until it ends as well. If either direction fails, both streams are shut down
+     *          completely so that the other direction ends too. Shutting a stream down is
+     *          also how to stop a relay early.
+     *
+     *          Splicing in to a socket cannot pass MSG_NOSIGNAL. The SIGPIPE it raises when
+     *          the peer has gone is blocked in engine workers, so the relay fails with EPIPE.
+     *
+     *          Nothing else should read from or write to either stream while the relay runs.
+     *
+     * @param _first One of the streams.
+     * @param _second The other stream.
+     * @param _pipe_size The capacity to ask for each direction's pipe, and so the most moved
+     *                   per splice.
+     * @co_return splice_result The amounts moved each way. The `last_error()` of each stream
+     *                          that failed is set.
+     */
+    template <MemoryType First, MemoryType Second>
+    [[nodiscard]] guaranteed_future<splice_result>
+    splice(
+        tcp_stream<First>&  _first,
+        tcp_stream<Second>& _second,
+        std::size_t         _pipe_size = kSplicePipeSize)
+    {
+        int  first_error  = 0;
+        int  second_error = 0;
+        auto result       = co_await details::splice_descriptors(
+            _first.get_engine(),
+            _first.descriptor(),
+            _second.descriptor(),
+            _pipe_size,
+            first_error,
+            second_error);
+
+        if (first_error) [[unlikely]] { _first.set_error(first_error); }
+        if (second_error) [[unlikely]] { _second.set_error(second_error); }
+
+        co_return result;
+    }
+
+    /**
+     * @brief Send `_length` bytes of `_file` from `_offset` to `_stream`, spliced through a pipe
+     *        so that the file is never read in to user space.
+     *
+     * @details The data moves a pipe's capacity at a time, so memory use does not depend on
+     *          the length sent. The position of `_file` is left untouched.
+     *
+     *          As with splice(), sending to a socket whose peer has gone fails with EPIPE
+     *          rather than raising SIGPIPE, as long as it runs in an engine worker.
+     *
+     * @param _file The file to send from.
+     * @param _stream The stream to send to.
+     * @param _offset The offset in to the file to start from.
+     * @param _length The amount to send.
+     * @param _pipe_size The capacity to ask for the pipe, and so the most moved per splice.
+     * @co_return long long The amount sent, which is less than `_length` if the file ended
+     *                      first or an error occurred, or -1 if an error occurred before any
+     *                      was sent. On error `_stream.last_error()` is set.
+     */
+    template <MemoryType FileType, MemoryType StreamType>
+    [[nodiscard]] guaranteed_future<long long>
+    send_file(
+        async_file<FileType>&   _file,
+        tcp_stream<StreamType>& _stream,
+        std::size_t             _offset,
+        std::size_t             _length,
+        std::size_t             _pipe_size = kSplicePipeSize)
+    {
+        int  error = 0;
+        auto sent  = co_await details::send_descriptor(
+            _stream.get_engine(),
+            _file.descriptor(),
+            _stream.descriptor(),
+            _offset,
+            _length,
+            _pipe_size,
+            error);
+
+        if (error) [[unlikely]] { _stream.set_error(error); }
+
+        co_return sent;
+    }
+
+}   // namespace zab
+
+#endif /* ZAB_SPLICE_HPP_ */
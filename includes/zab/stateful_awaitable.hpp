@@ -102,12 +102,14 @@ namespace zab {
         public:
 
             stateful_awaitable(const stateful_awaitable& _copy)
-                : stateful_awaitable(_copy.functor())
+                : stateful_awaitable(_copy.functor(), _copy.wait_.location())
             { }
 
-            stateful_awaitable(stateful_awaitable&& _move) : stateful_awaitable(_move.functor()) { }
+            stateful_awaitable(stateful_awaitable&& _move)
+                : stateful_awaitable(_move.functor(), _move.wait_.location())
+            { }
 
-            stateful_awaitable(Functor* _functor)
+            stateful_awaitable(Functor* _functor, const std::source_location& _location = {})
                 : generic_awaitable<Functor>(_functor),
                   context_(storage_event{
                       .handle_ = tagged_event{event<>{
@@ -118,7 +120,8 @@ namespace zab {
                                   self->notify();
                               },
                           .context_ = this}},
-                      .result_ = NotifyType{}})
+                      .result_ = NotifyType{}}),
+                  wait_(_location)
             { }
 
             void
@@ -164,6 +167,9 @@ namespace zab {
             await_suspend(std::coroutine_handle<> _awaiter) noexcept
             {
                 underlying_ = tagged_event{_awaiter};
+
+                /* Keyed by the context the io is submitted with. */
+                wait_.begin(this, "suspension_point");
                 return await_suspend();
             }
 
@@ -232,6 +238,7 @@ namespace zab {
             decltype(auto)
             await_resume() noexcept
             {
+                wait_.end();
                 return generic_awaitable<Functor>::await_resume();
             }
 
@@ -272,16 +279,20 @@ namespace zab {
 
         private:
 
-            storage_event<NotifyType> context_;
-            tagged_event              underlying_;
+            storage_event<NotifyType>                                context_;
+            tagged_event                                             underlying_;
+            [[no_unique_address]] introspection::details::wait_scope wait_;
     };
 
     template <typename NotifyType, details::StatefulAwaitable<NotifyType> Functor>
     auto
-    stateful_suspension_point(Functor&& _functor) noexcept
+    stateful_suspension_point(
+        Functor&&            _functor,
+        std::source_location _location = std::source_location::current()) noexcept
     {
         return suspension_point<Functor, stateful_awaitable<NotifyType, Functor>>(
-            std::forward<Functor>(_functor));
+            std::forward<Functor>(_functor),
+            _location);
     }
 
 }   // namespace zab
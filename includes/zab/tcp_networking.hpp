@@ -44,6 +44,7 @@
 #include <memory>
 #include <span>
 #include <stdint.h>
+#include <vector>
 
 #include "zab/async_function.hpp"
 #include "zab/async_mutex.hpp"
@@ -53,8 +54,10 @@
 #include "zab/network_operation.hpp"
 #include "zab/pause.hpp"
 #include "zab/simple_future.hpp"
+#include "zab/socket_options.hpp"
 #include "zab/strong_types.hpp"
 #include "zab/tcp_stream.hpp"
+#include "zab/yield.hpp"
 
 struct sockaddr_storage;
 
@@ -130,16 +133,23 @@ namespace zab {
              * @brief Start listening to connections on a newly created socket.
              *
              * @details This function is essentially creates a new socket using `::socket()`,
-             *          sets SO_REUSEADDR, then calls `::bind()` and `::listen()`.
+             *          applies `_options` (by default just SO_REUSEADDR), then calls `::bind()`
+             *          and `::listen()`.
              *
              * @param _family AF_INET or AF_INET6 for ipv4 and ipv6 respectively.
              * @param _port Which port to listen on.
              * @param _backlog The maximum amount of pending connections to hold.
+             * @param _options The socket options and address to listen with. If
+             *                 `_options.inherit_` is set they are applied to accepted streams.
              * @return true If started successfully.
              * @return false If an error occurs. `last_error()` is set.
              */
             [[nodiscard]] bool
-            listen(int _family, std::uint16_t _port, int _backlog) noexcept;
+            listen(
+                int                   _family,
+                std::uint16_t         _port,
+                int                   _backlog,
+                const socket_options& _options = {}) noexcept;
 
             /**
              * @brief Attempts to accept a connection.
@@ -182,16 +192,214 @@ namespace zab {
                         {
                             std::optional<tcp_stream<DataType>> stream;
                             set_cancel(nullptr);
-                            if (ret.result_ >= 0) { stream.emplace(get_engine(), ret.result_); }
+                            if (ret.result_ < 0) [[unlikely]] { set_error(-ret.result_); }
+                            else if (auto error = inherit(ret.result_)) [[unlikely]]
+                            {
+                                set_error(error);
+                            }
                             else
                             {
-                                set_error(-ret.result_);
+                                stream.emplace(get_engine(), ret.result_);
                             }
 
                             return stream;
                         }
                     });
             }
+
+        private:
+
+            /**
+             * @brief Apply the inherited options, if any, to an accepted socket. Closes it if
+             *        they cannot be.
+             *
+             * @return 0 on success, or the errno of the failure.
+             */
+            int
+            inherit(int _fd) noexcept;
+
+            std::optional<socket_options> inherited_;
+    };
+
+    /**
+     * @brief      A listener with one `SO_REUSEPORT` socket per worker, so that each event loop
+     *             accepts and serves its own connections.
+     *
+     * @details    The kernel spreads incoming connections over the sockets by hashing the
+     *             connection, or by the cpu the connection arrived on when steering is enabled.
+     *             Connections are never handed between threads.
+     */
+    class sharded_acceptor {
+
+        public:
+
+            /**
+             * @brief How connections are assigned to shards.
+             */
+            enum class steering {
+                /**
+                 * @brief The kernel hashes each connection to a shard.
+                 */
+                kNone,
+
+                /**
+                 * @brief Each socket sets SO_INCOMING_CPU to its worker's cpu, a hint for the
+                 *        kernel to prefer it for connections arriving on that cpu.
+                 */
+                kIncomingCpu,
+
+                /**
+                 * @brief Attach a classic BPF program (SO_ATTACH_REUSEPORT_CBPF) that picks the
+                 *        shard of the worker placed on the cpu the connection arrived on. Only
+                 *        useful when workers are pinned. Connections arriving on other cpus are
+                 *        hashed.
+                 */
+                kCpuProgram
+            };
+
+            /**
+             * @brief      Constructs a new instance with no sockets.
+             *
+             * @param      _engine  The engine whose workers will accept.
+             */
+            sharded_acceptor(engine* _engine);
+
+            sharded_acceptor(const sharded_acceptor&) = delete;
+
+            sharded_acceptor(sharded_acceptor&& _move) = default;
+
+            ~sharded_acceptor() = default;
+
+            /**
+             * @brief Create, bind and listen on one socket per worker.
+             *
+             * @details If `_port` is 0, the port the first socket is given is used for the rest.
+             *
+             * @param _family AF_INET or AF_INET6 for ipv4 and ipv6 respectively.
+             * @param _port Which port to listen on.
+             * @param _backlog The maximum amount of pending connections each socket holds.
+             * @param _steering How connections are assigned to shards.
+             * @param _options The socket options and address every socket listens with. Steering
+             *                 by cpu takes the place of `_options.incoming_cpu_`.
+             * @return true If every socket is listening.
+             * @return false If an error occurs. `last_error()` is set and no sockets are kept.
+             */
+            [[nodiscard]] bool
+            listen(
+                int                   _family,
+                std::uint16_t         _port,
+                int                   _backlog,
+                steering              _steering = steering::kNone,
+                const socket_options& _options  = {}) noexcept;
+
+            /**
+             * @brief The port being listened on.
+             */
+            [[nodiscard]] inline std::uint16_t
+            port() const noexcept
+            {
+                return port_;
+            }
+
+            /**
+             * @brief The number of shards, one per worker once listening.
+             */
+            [[nodiscard]] inline std::size_t
+            size() const noexcept
+            {
+                return shards_.size();
+            }
+
+            /**
+             * @brief The acceptor of a worker. Must only be used in that worker's thread.
+             *
+             * @param _thread The worker.
+             * @return The acceptor.
+             */
+            [[nodiscard]] inline tcp_acceptor&
+            shard(thread_t _thread) noexcept
+            {
+                return shards_[_thread.thread_];
+            }
+
+            /**
+             * @brief The acceptor of the calling worker.
+             *
+             * @return The acceptor.
+             */
+            [[nodiscard]] inline tcp_acceptor&
+            local() noexcept
+            {
+                return shard(engine_->current_id());
+            }
+
+            /**
+             * @brief Get the last error that was set. Clears the error.
+             *
+             * @return int The last error.
+             */
+            [[nodiscard]] inline int
+            last_error() noexcept
+            {
+                auto tmp    = last_error_;
+                last_error_ = 0;
+                return tmp;
+            }
+
+            /**
+             * @brief Accept on every shard in its own worker, calling `_handler` with each
+             *        stream in the thread that accepted it.
+             *
+             * @details Each worker stops accepting once its acceptor fails, for example when
+             *          `close()` is called.
+             *
+             * @tparam DataType The type of memory the produced tcp_streams will use.
+             * @param _handler Called with each `tcp_stream<DataType>`. Copied per worker.
+             */
+            template <MemoryType DataType = std::byte, typename Handler>
+            void
+            serve(Handler _handler) noexcept
+            {
+                for (std::uint16_t i = 0; i < shards_.size(); ++i)
+                {
+                    accept_loop<DataType>(thread_t{i}, _handler);
+                }
+            }
+
+            /**
+             * @brief Cancel any pending accepts and close every socket, each in its own worker.
+             *
+             * @co_return void Once every shard is closed.
+             */
+            simple_future<>
+            close() noexcept;
+
+        private:
+
+            template <MemoryType DataType, typename Handler>
+            async_function<>
+            accept_loop(thread_t _thread, Handler _handler) noexcept
+            {
+                co_await yield(engine_, _thread);
+
+                auto&                   acceptor = shards_[_thread.thread_];
+                struct sockaddr_storage address;
+                while (true)
+                {
+                    socklen_t length = sizeof(address);
+                    auto      stream =
+                        co_await acceptor.accept<DataType>((struct sockaddr*) &address, &length);
+
+                    if (!stream) { break; }
+
+                    _handler(std::move(*stream));
+                }
+            }
+
+            engine*                   engine_;
+            std::vector<tcp_acceptor> shards_;
+            std::uint16_t             port_       = 0;
+            int                       last_error_ = 0;
     };
 
     /**
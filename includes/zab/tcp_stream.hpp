@@ -38,11 +38,15 @@
 #ifndef ZAB_TCP_STREAM_HPP_
 #define ZAB_TCP_STREAM_HPP_
 
+#include <algorithm>
 #include <cstdint>
 #include <limits>
 #include <memory>
 #include <span>
 #include <stdint.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <vector>
 
 #include "zab/async_function.hpp"
 #include "zab/async_mutex.hpp"
@@ -51,11 +55,87 @@
 #include "zab/event_loop.hpp"
 #include "zab/memory_type.hpp"
 #include "zab/network_operation.hpp"
+#include "zab/probes.hpp"
 #include "zab/simple_future.hpp"
+#include "zab/socket_options.hpp"
 #include "zab/stateful_awaitable.hpp"
 #include "zab/strong_types.hpp"
 namespace zab {
 
+    namespace details {
+
+        /**
+         * @brief The part of a set of buffers that a vectored operation has still to transfer.
+         */
+        class io_vectors {
+
+            public:
+
+                template <typename Span>
+                explicit io_vectors(std::span<const Span> _buffers)
+                {
+                    vectors_.reserve(_buffers.size());
+                    for (const auto& buffer : _buffers)
+                    {
+                        if (buffer.size())
+                        {
+                            vectors_.push_back(
+                                iovec{(void*) buffer.data(), buffer.size_bytes()});
+                        }
+                    }
+                }
+
+                /**
+                 * @brief Whether everything has been transferred.
+                 */
+                [[nodiscard]] inline bool
+                empty() const noexcept
+                {
+                    return first_ == vectors_.size();
+                }
+
+                /**
+                 * @brief Mark `_amount` bytes from the front as transferred.
+                 */
+                inline void
+                consume(std::size_t _amount) noexcept
+                {
+                    while (_amount && first_ < vectors_.size())
+                    {
+                        auto& front = vectors_[first_];
+                        if (_amount < front.iov_len)
+                        {
+                            front.iov_base = (std::byte*) front.iov_base + _amount;
+                            front.iov_len -= _amount;
+                            return;
+                        }
+
+                        _amount -= front.iov_len;
+                        ++first_;
+                    }
+                }
+
+                /**
+                 * @brief Point `_message` at what is left, at most IOV_MAX buffers at a time.
+                 */
+                inline void
+                prepare(struct msghdr& _message) noexcept
+                {
+                    static constexpr std::size_t kMaxVectors = 1024;
+
+                    _message            = {};
+                    _message.msg_iov    = vectors_.data() + first_;
+                    _message.msg_iovlen = std::min(vectors_.size() - first_, kMaxVectors);
+                }
+
+            private:
+
+                std::vector<struct iovec> vectors_;
+                std::size_t               first_ = 0;
+        };
+
+    }   // namespace details
+
     /**
      * @brief This class represents the a duplex network stream for writing and reading
      *        data.
@@ -73,7 +153,7 @@ namespace zab {
              * @brief The maximum a write_some operation will write to a stream.
              *
              */
-            static constexpr auto kMaxWrite = std::numeric_limits<std::uint16_t>::max();
+            static constexpr auto kMaxWrite = std::numeric_limits<int>::max() - 2;
 
             /**
              * @brief The maximum a read_some operation will write to a stream.
@@ -221,6 +301,34 @@ namespace zab {
                 return net_op_.descriptor();
             }
 
+            /**
+             * @brief Get the engine the stream uses.
+             *
+             * @return engine*
+             */
+            [[nodiscard]] inline engine*
+            get_engine() noexcept
+            {
+                return net_op_.get_engine();
+            }
+
+            /**
+             * @brief Apply the options that apply to a stream. Those only for listeners, and the
+             *        bind address, are ignored.
+             *
+             * @param _options The options to apply.
+             * @return true If every option was set.
+             * @return false If an error occurs. `last_error()` is set.
+             */
+            [[nodiscard]] bool
+            set_options(const socket_options& _options) noexcept
+            {
+                auto error = details::apply_socket_options(descriptor(), _options, false);
+                if (error) [[unlikely]] { net_op_.set_error(error); }
+
+                return !error;
+            }
+
             /**
              * @brief Get the last error.
              *
@@ -363,6 +471,7 @@ namespace zab {
                         else if constexpr (is_resume<T>())
                         {
                             net_op_.clear_cancel();
+                            ZAB_PROBE(tcp_read, net_op_.descriptor(), ret.result_);
                             if (ret.result_ > 0) { return ret.result_; }
                             else
                             {
@@ -397,6 +506,7 @@ namespace zab {
                         if constexpr (is_ready<T>()) { return so_far == (ssize_t) _data.size(); }
                         if constexpr (is_notify<int, T>())
                         {
+                            ZAB_PROBE(tcp_read, net_op_.descriptor(), _handle);
                             if (_handle > 0)
                             {
                                 so_far += _handle;
@@ -434,6 +544,64 @@ namespace zab {
                     });
             }
 
+            /**
+             * @brief Read into every buffer in turn with `::recvmsg()`. Blocks until they are all
+             *        full, the stream is closed or an error occurs.
+             *
+             * @param _buffers The buffers to read into.
+             * @param _flags Any flags to pass to recvmsg. MSG_WAITALL is always set additionally.
+             * @co_return long long The amount of bytes read, or -1 if an error occurred before
+             *                      any were.
+             */
+            [[nodiscard]] auto
+            read_v(std::span<const std::span<DataType>> _buffers, int _flags = 0) noexcept
+            {
+                return stateful_suspension_point<int>(
+                    [this,
+                     so_far  = 0ll,
+                     vectors = details::io_vectors(_buffers),
+                     message = msghdr{},
+                     _flags]<typename T>(T _handle) mutable noexcept
+                    {
+                        if constexpr (is_ready<T>()) { return vectors.empty(); }
+                        if constexpr (is_notify<int, T>())
+                        {
+                            ZAB_PROBE(tcp_read, net_op_.descriptor(), _handle);
+                            if (_handle > 0)
+                            {
+                                so_far += _handle;
+                                vectors.consume(_handle);
+                                return notify_ctl::kReady;
+                            }
+                            else
+                            {
+                                net_op_.set_error(-_handle);
+                                return notify_ctl::kResume;
+                            }
+                        }
+                        else if constexpr (is_stateful_suspend<int, T>())
+                        {
+                            vectors.prepare(message);
+
+                            net_op_.set_cancel(_handle);
+                            net_op_.get_engine()->get_event_loop().recv_msg(
+                                _handle,
+                                net_op_.descriptor(),
+                                &message,
+                                _flags | MSG_WAITALL);
+                        }
+                        else if constexpr (is_resume<T>())
+                        {
+                            net_op_.clear_cancel();
+                            if (so_far > 0) { return so_far; }
+                            else
+                            {
+                                return -1ll;
+                            }
+                        }
+                    });
+            }
+
             /**
              * @brief Attempt to write up to `_data.size() - _offset` bytes from the span at the
              *        given offset.
@@ -475,6 +643,7 @@ namespace zab {
                         else if constexpr (is_resume<T>())
                         {
                             write_cancel_ = nullptr;
+                            ZAB_PROBE(tcp_write, net_op_.descriptor(), ret.result_);
                             if (ret.result_ > 0) { return ret.result_; }
                             else
                             {
@@ -517,6 +686,7 @@ namespace zab {
                         if constexpr (is_ready<T>()) { return so_far == (ssize_t) _data.size(); }
                         if constexpr (is_notify<int, T>())
                         {
+                            ZAB_PROBE(tcp_write, net_op_.descriptor(), _handle);
                             if (_handle > 0)
                             {
                                 so_far += _handle;
@@ -531,7 +701,7 @@ namespace zab {
                         else if constexpr (is_stateful_suspend<int, T>())
                         {
                             auto amount_to_write =
-                                std::min<std::size_t>(_data.size() - so_far - _offset, kMaxRead);
+                                std::min<std::size_t>(_data.size() - so_far - _offset, kMaxWrite);
 
                             write_cancel_ = _handle;
                             net_op_.get_engine()->get_event_loop().send(
@@ -554,6 +724,67 @@ namespace zab {
                     });
             }
 
+            /**
+             * @brief Write every buffer in turn with `::sendmsg()`, such as a header and a body
+             *        without copying them together. Blocks until everything is written or an
+             *        error occurs.
+             *
+             * @param _buffers The buffers to write from.
+             * @param _flags Any flags to pass to sendmsg. MSG_NOSIGNAL is the default.
+             * @co_return long long The amount of bytes written, or -1 if an error occurred before
+             *                      any were.
+             */
+            [[nodiscard]] auto
+            write_v(
+                std::span<const std::span<const DataType>> _buffers,
+                int                                        _flags = MSG_NOSIGNAL) noexcept
+            {
+                return stateful_suspension_point<int>(
+                    [this,
+                     so_far  = 0ll,
+                     vectors = details::io_vectors(_buffers),
+                     message = msghdr{},
+                     _flags]<typename T>(T _handle) mutable noexcept
+                    {
+                        if constexpr (is_ready<T>()) { return vectors.empty(); }
+                        if constexpr (is_notify<int, T>())
+                        {
+                            ZAB_PROBE(tcp_write, net_op_.descriptor(), _handle);
+                            if (_handle > 0)
+                            {
+                                so_far += _handle;
+                                vectors.consume(_handle);
+                                return notify_ctl::kReady;
+                            }
+                            else
+                            {
+                                net_op_.set_error(-_handle);
+                                return notify_ctl::kResume;
+                            }
+                        }
+                        else if constexpr (is_stateful_suspend<int, T>())
+                        {
+                            vectors.prepare(message);
+
+                            write_cancel_ = _handle;
+                            net_op_.get_engine()->get_event_loop().send_msg(
+                                _handle,
+                                net_op_.descriptor(),
+                                &message,
+                                _flags);
+                        }
+                        else if constexpr (is_resume<T>())
+                        {
+                            write_cancel_ = nullptr;
+                            if (so_far > 0) { return so_far; }
+                            else
+                            {
+                                return -1ll;
+                            }
+                        }
+                    });
+            }
+
         private:
 
             /**
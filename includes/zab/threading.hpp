@@ -0,0 +1,204 @@
+/*
+ *  MMM"""AMV       db      `7MM"""Yp,
+ *  M'   AMV       ;MM:       MM    Yb
+ *  '   AMV       ,V^MM.      MM    dP
+ *     AMV       ,M  `MM      MM"""bg.
+ *    AMV   ,    AbmmmqMA     MM    `Y
+ *   AMV   ,M   A'     VML    MM    ,9
+ *  AMVmmmmMM .AMA.   .AMMA..JMMmmmd9
+ *
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021 Donald-Rupin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ *  @file threading.hpp
+ *
+ */
+
+#ifndef ZAB_THREADING_HPP_
+#define ZAB_THREADING_HPP_
+
+#include <atomic>
+#include <mutex>
+#include <type_traits>
+
+#include "zab/spin_lock.hpp"
+
+namespace zab {
+
+#ifdef ZAB_SINGLE_THREADED
+    /**
+     * @brief Set when zab is compiled with `ZAB_SINGLE_THREADED`. The engine is limited to one
+     *        worker and the synchronisation primitives use plain loads and stores.
+     */
+    inline constexpr bool kSingleThreaded = true;
+#else
+    inline constexpr bool kSingleThreaded = false;
+#endif
+
+    namespace details {
+
+        /**
+         * @brief A drop in replacement for `std::atomic<T>` for when only one thread will ever
+         *        access the value. Memory orders are accepted and ignored.
+         *
+         * @tparam T The type to hold.
+         */
+        template <typename T>
+        class plain_atomic {
+
+            public:
+
+                constexpr plain_atomic() noexcept = default;
+
+                constexpr plain_atomic(T _value) noexcept : value_(_value) { }
+
+                plain_atomic(const plain_atomic&) = delete;
+
+                plain_atomic&
+                operator=(const plain_atomic&) = delete;
+
+                T
+                operator=(T _value) noexcept
+                {
+                    value_ = _value;
+                    return _value;
+                }
+
+                operator T() const noexcept
+                {
+                    return value_;
+                }
+
+                T
+                load(std::memory_order = std::memory_order_seq_cst) const noexcept
+                {
+                    return value_;
+                }
+
+                void
+                store(T _value, std::memory_order = std::memory_order_seq_cst) noexcept
+                {
+                    value_ = _value;
+                }
+
+                T
+                exchange(T _value, std::memory_order = std::memory_order_seq_cst) noexcept
+                {
+                    T old  = value_;
+                    value_ = _value;
+                    return old;
+                }
+
+                bool
+                compare_exchange_strong(
+                    T& _expected,
+                    T  _desired,
+                    std::memory_order = std::memory_order_seq_cst,
+                    std::memory_order = std::memory_order_seq_cst) noexcept
+                {
+                    if (value_ == _expected)
+                    {
+                        value_ = _desired;
+                        return true;
+                    }
+
+                    _expected = value_;
+                    return false;
+                }
+
+                bool
+                compare_exchange_weak(
+                    T&                _expected,
+                    T                 _desired,
+                    std::memory_order _success = std::memory_order_seq_cst,
+                    std::memory_order _failure = std::memory_order_seq_cst) noexcept
+                {
+                    return compare_exchange_strong(_expected, _desired, _success, _failure);
+                }
+
+                T
+                fetch_add(T _value, std::memory_order = std::memory_order_seq_cst) noexcept
+                    requires std::is_integral_v<T>
+                {
+                    T old = value_;
+                    value_ += _value;
+                    return old;
+                }
+
+                T
+                fetch_sub(T _value, std::memory_order = std::memory_order_seq_cst) noexcept
+                    requires std::is_integral_v<T>
+                {
+                    T old = value_;
+                    value_ -= _value;
+                    return old;
+                }
+
+            private:
+
+                T value_{};
+        };
+
+        /**
+         * @brief A mutex that does nothing. Satisfies Lockable.
+         */
+        struct null_mutex {
+
+                inline void
+                lock() noexcept
+                { }
+
+                inline bool
+                try_lock() noexcept
+                {
+                    return true;
+                }
+
+                inline void
+                unlock() noexcept
+                { }
+        };
+
+    }   // namespace details
+
+    /**
+     * @brief The atomic type used by zab's primitives. `std::atomic<T>` unless compiled with
+     *        `ZAB_SINGLE_THREADED`.
+     */
+    template <typename T>
+    using atomic =
+        std::conditional_t<kSingleThreaded, details::plain_atomic<T>, std::atomic<T>>;
+
+    /**
+     * @brief The blocking mutex used by zab's primitives.
+     */
+    using mutex = std::conditional_t<kSingleThreaded, details::null_mutex, std::mutex>;
+
+    /**
+     * @brief The spinning mutex used by zab's primitives.
+     */
+    using spin_mutex = std::conditional_t<kSingleThreaded, details::null_mutex, spin_lock>;
+
+}   // namespace zab
+
+#endif /* ZAB_THREADING_HPP_ */
@@ -40,6 +40,7 @@
 #include <coroutine>
 #include <cstdint>
 #include <map>
+#include <source_location>
 #include <vector>
 
 #include "zab/async_function.hpp"
@@ -90,20 +91,24 @@ namespace zab {
              * @brief Pause the coroutine for _nano_seconds.
              *
              * @param _nano_seconds The amount of nanoseconds to pause for.
+             * @param _location The caller, for the `profiler`.
              * @co_return void Suspends for the given time.
              */
             auto
-            wait(std::uint64_t _nano_seconds) noexcept
+            wait(
+                std::uint64_t        _nano_seconds,
+                std::source_location _location = std::source_location::current()) noexcept
             {
                 return suspension_point(
                     [this, _nano_seconds]<typename T>(T _handle) noexcept
                     {
-                        if constexpr (is_suspend<T>()) { return _nano_seconds == 0; }
+                        if constexpr (is_ready<T>()) { return _nano_seconds == 0; }
                         else if constexpr (is_suspend<T>())
                         {
                             wait(_handle, _nano_seconds);
                         }
-                    });
+                    },
+                    _location);
             }
 
             /**
@@ -111,20 +116,25 @@ namespace zab {
              *
              * @param _nano_seconds The amount of nanoseconds to pause for.
              * @param _thread The thread to resume in.
+             * @param _location The caller, for the `profiler`.
              * @co_return void Suspends for the given time.
              */
             auto
-            wait(std::uint64_t _nano_seconds, thread_t _thread) noexcept
+            wait(
+                std::uint64_t        _nano_seconds,
+                thread_t             _thread,
+                std::source_location _location = std::source_location::current()) noexcept
             {
                 return suspension_point(
                     [this, _nano_seconds, _thread]<typename T>(T _handle) noexcept
                     {
-                        if constexpr (is_suspend<T>()) { return _nano_seconds == 0; }
+                        if constexpr (is_ready<T>()) { return _nano_seconds == 0; }
                         else if constexpr (is_suspend<T>())
                         {
                             wait(_handle, _nano_seconds, _thread);
                         }
-                    });
+                    },
+                    _location);
             }
 
             /**
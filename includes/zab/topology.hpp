@@ -0,0 +1,215 @@
+/*
+ *  MMM"""AMV       db      `7MM"""Yp,
+ *  M'   AMV       ;MM:       MM    Yb
+ *  '   AMV       ,V^MM.      MM    dP
+ *     AMV       ,M  `MM      MM"""bg.
+ *    AMV   ,    AbmmmqMA     MM    `Y
+ *   AMV   ,M   A'     VML    MM    ,9
+ *  AMVmmmmMM .AMA.   .AMMA..JMMmmmd9
+ *
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021 Donald-Rupin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ *  @file topology.hpp
+ *
+ */
+
+#ifndef ZAB_TOPOLOGY_HPP_
+#define ZAB_TOPOLOGY_HPP_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace zab {
+
+    /**
+     * @brief      Where a logical cpu sits in the machine.
+     */
+    struct cpu_info {
+
+            /**
+             * @brief The logical cpu id as used by `sched_setaffinity`.
+             */
+            std::uint16_t cpu_;
+
+            /**
+             * @brief The physical core id within the package.
+             */
+            std::uint16_t core_;
+
+            /**
+             * @brief The physical package (socket) id.
+             */
+            std::uint16_t package_;
+
+            /**
+             * @brief The NUMA node the cpu belongs to.
+             */
+            std::uint16_t node_;
+
+            /**
+             * @brief 0 for the first hardware thread of a core, 1 for its first SMT sibling...
+             */
+            std::uint16_t smt_;
+    };
+
+    /**
+     * @brief      Describes the cpus, cores, sockets and NUMA nodes of the machine.
+     *
+     * @details    Discovered from `/sys/devices/system`, limited to the cpus the process is
+     *             allowed to run on. If sysfs is not available then every allowed cpu is placed on
+     *             its own core in node 0.
+     */
+    class topology {
+
+        public:
+
+            /**
+             * @brief      Discover the topology of the machine.
+             *
+             * @return     The topology.
+             */
+            static topology
+            discover() noexcept;
+
+            /**
+             * @brief      Construct a topology from a list of cpus.
+             *
+             * @param      _cpus  The cpus.
+             */
+            explicit topology(std::vector<cpu_info> _cpus) noexcept;
+
+            /**
+             * @brief      Parse a kernel style cpu list such as "0-3,8,10-11".
+             *
+             * @param[in]  _list  The list.
+             *
+             * @return     The ids in the list. Empty if the list is malformed.
+             */
+            static std::vector<std::uint16_t>
+            parse_cpu_list(std::string_view _list) noexcept;
+
+            /**
+             * @brief      The cpus sorted by id.
+             *
+             * @return     The cpus.
+             */
+            inline const std::vector<cpu_info>&
+            cpus() const noexcept
+            {
+                return cpus_;
+            }
+
+            /**
+             * @brief      The number of NUMA nodes with cpus.
+             *
+             * @return     The number of nodes.
+             */
+            inline std::uint16_t
+            number_of_nodes() const noexcept
+            {
+                return nodes_;
+            }
+
+            /**
+             * @brief      Look up a cpu by id.
+             *
+             * @param[in]  _cpu  The cpu id.
+             *
+             * @return     The cpu if it exists.
+             */
+            std::optional<cpu_info>
+            find(std::uint16_t _cpu) const noexcept;
+
+            /**
+             * @brief      The order to place workers in when no cpu list is given.
+             *
+             * @details    Every physical core is used before any SMT sibling. Within that, cpus
+             *             are grouped by node so that consecutive workers share memory.
+             *
+             * @return     The cpu ids in placement order.
+             */
+            std::vector<std::uint16_t>
+            placement() const noexcept;
+
+        private:
+
+            std::vector<cpu_info> cpus_;
+            std::uint16_t         nodes_;
+    };
+
+    /**
+     * @brief      Prefer allocating pages on a NUMA node for the lifetime of the scope.
+     *
+     * @details    Applies to the calling thread only. Kernel objects created in the scope, such
+     *             as io_uring rings, are placed on the node. The thread's previous policy is
+     *             restored when the scope ends. Does nothing on single node machines or if the
+     *             kernel refuses the policy.
+     */
+    class numa_scope {
+
+        public:
+
+            numa_scope(std::uint16_t _node, std::uint16_t _number_of_nodes) noexcept;
+
+            numa_scope(const numa_scope&) = delete;
+
+            ~numa_scope();
+
+        private:
+
+            /* Room for 1024 nodes, the most the kernel supports. */
+            static constexpr std::size_t kMaskWords = 1024 / (sizeof(unsigned long) * 8);
+
+            bool                                  applied_;
+            int                                   previous_mode_;
+            std::array<unsigned long, kMaskWords> previous_mask_;
+    };
+
+    /**
+     * @brief      Allocate page aligned memory preferring a NUMA node.
+     *
+     * @param[in]  _size  The number of bytes.
+     * @param[in]  _node  The node to prefer.
+     *
+     * @return     The memory or nullptr on failure. Release with `numa_deallocate`.
+     */
+    void*
+    numa_allocate(std::size_t _size, std::uint16_t _node) noexcept;
+
+    /**
+     * @brief      Release memory from `numa_allocate`.
+     *
+     * @param      _ptr   The memory.
+     * @param[in]  _size  The size it was allocated with.
+     */
+    void
+    numa_deallocate(void* _ptr, std::size_t _size) noexcept;
+
+}   // namespace zab
+
+#endif /* ZAB_TOPOLOGY_HPP_ */
@@ -0,0 +1,229 @@
+/*
+ *  MMM"""AMV       db      `7MM"""Yp,
+ *  M'   AMV       ;MM:       MM    Yb
+ *  '   AMV       ,V^MM.      MM    dP
+ *     AMV       ,M  `MM      MM"""bg.
+ *    AMV   ,    AbmmmqMA     MM    `Y
+ *   AMV   ,M   A'     VML    MM    ,9
+ *  AMVmmmmMM .AMA.   .AMMA..JMMmmmd9
+ *
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021 Donald-Rupin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ *  @file tracing.hpp
+ *
+ */
+
+#ifndef ZAB_TRACING_HPP_
+#define ZAB_TRACING_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+
+namespace zab {
+
+#ifdef ZAB_TRACING
+    /**
+     * @brief Set when zab is compiled with `ZAB_TRACING`. Otherwise every trace point compiles
+     *        to nothing.
+     */
+    inline constexpr bool kTracing = true;
+#else
+    inline constexpr bool kTracing = false;
+#endif
+
+    /**
+     * @brief Records coroutine and io events into per thread ring buffers that can be dumped in
+     *        the Chrome `trace_event` JSON format, viewable in Perfetto or chrome://tracing.
+     *
+     * @details Trace points are compiled in with `ZAB_TRACING` and then recorded once
+     *          `tracing::enable()` has been called. While disabled a trace point is a relaxed
+     *          load and a branch.
+     */
+    namespace tracing {
+
+        /**
+         * @brief The default number of records kept per thread.
+         */
+        inline constexpr std::size_t kDefaultCapacity = 1 << 16;
+
+        namespace details {
+
+            enum class kind : std::uint8_t {
+                kBegin,
+                kEnd,
+                kInstant,
+                kComplete
+            };
+
+            extern std::atomic<bool> enabled_;
+
+            void
+            record(kind _kind, const char* _name, const void* _id, std::int64_t _value) noexcept;
+
+        }   // namespace details
+
+        /**
+         * @brief Is tracing currently recording.
+         */
+        inline bool
+        enabled() noexcept
+        {
+            if constexpr (kTracing) { return details::enabled_.load(std::memory_order_relaxed); }
+            else
+            {
+                return false;
+            }
+        }
+
+        /**
+         * @brief Mark the start of a slice of work on this thread, such as resuming a coroutine.
+         *
+         * @param _name A string literal naming the slice.
+         * @param _id The coroutine or operation the slice belongs to.
+         */
+        inline void
+        begin(const char* _name, const void* _id) noexcept
+        {
+            if constexpr (kTracing)
+            {
+                if (enabled()) [[unlikely]]
+                {
+                    details::record(details::kind::kBegin, _name, _id, 0);
+                }
+            }
+        }
+
+        /**
+         * @brief Mark the end of the last slice started on this thread.
+         *
+         * @param _id The coroutine or operation the slice belongs to.
+         */
+        inline void
+        end(const void* _id) noexcept
+        {
+            if constexpr (kTracing)
+            {
+                if (enabled()) [[unlikely]] { details::record(details::kind::kEnd, "", _id, 0); }
+            }
+        }
+
+        /**
+         * @brief Mark a point in time on this thread.
+         *
+         * @param _name A string literal naming the event.
+         * @param _id The coroutine or operation the event belongs to.
+         * @param _value An optional value such as an io result.
+         */
+        inline void
+        instant(const char* _name, const void* _id, std::int64_t _value = 0) noexcept
+        {
+            if constexpr (kTracing)
+            {
+                if (enabled()) [[unlikely]]
+                {
+                    details::record(details::kind::kInstant, _name, _id, _value);
+                }
+            }
+        }
+
+        /**
+         * @brief Mark a coroutine as finished on this thread.
+         *
+         * @details Ends the chain of flow arrows for `_id`, as its address may be reused.
+         *
+         * @param _name A string literal naming the kind of coroutine.
+         * @param _id The coroutine.
+         */
+        inline void
+        complete(const char* _name, const void* _id) noexcept
+        {
+            if constexpr (kTracing)
+            {
+                if (enabled()) [[unlikely]]
+                {
+                    details::record(details::kind::kComplete, _name, _id, 0);
+                }
+            }
+        }
+
+        /**
+         * @brief Start recording.
+         *
+         * @param _capacity The number of records each thread keeps. Rounded up to a power of
+         *                  two. Older records are overwritten. Only applies to threads that have
+         *                  not recorded yet.
+         */
+        void
+        enable(std::size_t _capacity = kDefaultCapacity) noexcept;
+
+        /**
+         * @brief Stop recording. Recorded events are kept.
+         */
+        void
+        disable() noexcept;
+
+        /**
+         * @brief Discard all recorded events. Must not race with recording threads.
+         */
+        void
+        clear() noexcept;
+
+        /**
+         * @brief Name the calling thread in the trace.
+         *
+         * @param _name The name.
+         */
+        void
+        name_thread(std::string _name) noexcept;
+
+        /**
+         * @brief Write all recorded events as Chrome `trace_event` JSON.
+         *
+         * @details Coroutines resumed on a different thread from their last resumption are
+         *          linked with flow arrows. Call while threads are not recording, or accept that
+         *          records being overwritten during the dump may be torn.
+         *
+         * @param _out The stream to write to.
+         */
+        void
+        dump(std::ostream& _out) noexcept;
+
+        /**
+         * @brief Write all recorded events as Chrome `trace_event` JSON to a file.
+         *
+         * @param _path The file to write.
+         * @return true If the file was written.
+         */
+        bool
+        dump(const std::string& _path) noexcept;
+
+    }   // namespace tracing
+
+}   // namespace zab
+
+#endif /* ZAB_TRACING_HPP_ */
@@ -0,0 +1,534 @@
+/*
+ *  MMM"""AMV       db      `7MM"""Yp,
+ *  M'   AMV       ;MM:       MM    Yb
+ *  '   AMV       ,V^MM.      MM    dP
+ *     AMV       ,M  `MM      MM"""bg.
+ *    AMV   ,    AbmmmqMA     MM    `Y
+ *   AMV   ,M   A'     VML    MM    ,9
+ *  AMVmmmmMM .AMA.   .AMMA..JMMmmmd9
+ *
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021 Donald-Rupin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ *  @file udp_networking.hpp
+ *
+ */
+
+#ifndef ZAB_UDP_NETWORKING_HPP_
+#define ZAB_UDP_NETWORKING_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <sys/socket.h>
+#include <vector>
+
+#include "zab/engine.hpp"
+#include "zab/event_loop.hpp"
+#include "zab/network_operation.hpp"
+#include "zab/simple_future.hpp"
+
+struct sockaddr_storage;
+
+namespace zab {
+
+    /**
+     * @brief A datagram delivered by `udp_socket::receive()`. The views are only valid until the
+     *        handler returns.
+     */
+    struct datagram {
+
+            std::span<const std::byte> data_;
+            const struct sockaddr*     source_;
+            socklen_t                  source_length_;
+
+            /**
+             * @brief Non zero if UDP_GRO coalesced several datagrams of this size into `data_`.
+             *        The last one may be shorter.
+             */
+            std::uint16_t segment_size_;
+
+            /**
+             * @brief The datagram did not fit into the buffer.
+             */
+            bool truncated_;
+    };
+
+    /**
+     * @brief      A pool of equally sized buffers handed to the kernel, so that a multishot
+     *             receive can pick its own buffer for each datagram.
+     *
+     * @details    The buffers are provided to the event loop of the thread that calls
+     *             `provide()` and can only be used by operations on that thread. Each buffer
+     *             must be large enough for `udp_socket::kReceiveOverhead` plus the payload.
+     */
+    class buffer_group {
+
+        public:
+
+            /**
+             * @brief Construct a new buffer group. The buffers are not usable until `provide()`
+             *        is awaited.
+             *
+             * @param _engine The engine to use.
+             * @param _count The number of buffers.
+             * @param _size The size of each buffer.
+             */
+            buffer_group(engine* _engine, std::uint16_t _count, std::uint32_t _size);
+
+            /**
+             * @brief The kernel holds pointers into the group, so it cannot be copied or moved.
+             *
+             */
+            buffer_group(const buffer_group&) = delete;
+
+            /**
+             * @brief Hand every buffer to the event loop of the current thread.
+             *
+             * @co_return true if the buffers were provided.
+             */
+            [[nodiscard]] guaranteed_future<bool>
+            provide() noexcept;
+
+            /**
+             * @brief Take back the buffers the kernel still holds. Must be awaited on the thread
+             *        that provided them, once no operation is using the group.
+             *
+             */
+            [[nodiscard]] simple_future<>
+            release() noexcept;
+
+            /**
+             * @brief Give a buffer back to the kernel once its contents are no longer needed.
+             *        Buffers that could not be given back earlier are retried first.
+             *
+             * @param _id The id of the buffer.
+             */
+            void
+            recycle(std::uint16_t _id) noexcept;
+
+            /**
+             * @brief Retry giving back the buffers whose recycle failed, for example because the
+             *        submission queue was full. A `udp_socket` calls this before it rearms.
+             *
+             */
+            void
+            retry_recycles() noexcept;
+
+            /**
+             * @brief The memory of a buffer.
+             *
+             * @param _id The id of the buffer.
+             */
+            inline std::span<std::byte>
+            buffer(std::uint16_t _id) noexcept
+            {
+                return std::span<std::byte>(storage_).subspan((std::size_t) _id * size_, size_);
+            }
+
+            /**
+             * @brief The id of the group.
+             */
+            inline std::uint16_t
+            group() const noexcept
+            {
+                return group_;
+            }
+
+            /**
+             * @brief The number of buffers in the group.
+             */
+            inline std::uint16_t
+            count() const noexcept
+            {
+                return count_;
+            }
+
+            /**
+             * @brief The size of each buffer.
+             */
+            inline std::uint32_t
+            size() const noexcept
+            {
+                return size_;
+            }
+
+        private:
+
+            struct recycle_op {
+                    event_loop::io_event event_;
+                    buffer_group*        group_;
+                    std::uint16_t        id_;
+            };
+
+            static void
+            recycled(void* _op) noexcept;
+
+            bool
+            give_back(std::uint16_t _id) noexcept;
+
+            engine*                    engine_;
+            event_loop*                loop_;
+            std::vector<std::byte>     storage_;
+            std::uint32_t              size_;
+            std::uint16_t              count_;
+            std::uint16_t              group_;
+            std::vector<recycle_op>    recycles_;
+            std::vector<std::uint16_t> unreturned_;
+    };
+
+    namespace details {
+
+        /**
+         * @brief The state of a multishot receive that lives in the receiving coroutine.
+         */
+        struct receive_state {
+
+                receive_state(buffer_group& _buffers) noexcept;
+
+                event_loop::io_event event_;
+                struct msghdr        message_;
+                buffer_group*        buffers_;
+                std::size_t          received_;
+                std::uint16_t        buffer_id_;
+                bool                 armed_;
+                int                  error_;
+        };
+
+        /**
+         * @brief The message header of a send that lives in the awaitable.
+         */
+        struct send_state {
+
+                void
+                prepare(
+                    std::span<const std::byte> _data,
+                    const struct sockaddr*     _address,
+                    socklen_t                  _length,
+                    std::uint16_t              _segment_size) noexcept;
+
+                struct msghdr message_;
+                struct iovec  vector_;
+                alignas(struct cmsghdr) char control_[CMSG_SPACE(sizeof(std::uint16_t))];
+        };
+
+    }   // namespace details
+
+    /**
+     * @brief      This class allows for asynchronous datagram socket operations.
+     *
+     * @details    Besides the plain recvmsg(2) and sendmsg(2) equivalents, `receive()` keeps a
+     *             single multishot recvmsg armed that fills buffers from a `buffer_group`, and
+     *             `send_to()` can hand many datagrams to the kernel at once with UDP_SEGMENT.
+     *             With `set_gro(true)` the kernel may likewise coalesce received datagrams.
+     */
+    class udp_socket : public network_operation {
+
+        public:
+
+            /**
+             * @brief The bytes at the start of each `buffer_group` buffer that `receive()` uses
+             *        for the message header, the source address and control data.
+             */
+            static constexpr std::size_t kReceiveOverhead = 4 * sizeof(std::uint32_t) +
+                                                            sizeof(struct sockaddr_storage) +
+                                                            CMSG_SPACE(sizeof(int));
+
+            /**
+             * @brief      Constructs a new instance in an empty state.
+             *
+             *             If this constructor is used, use of the socket will result in
+             *             undefined behavior until `register_engine` is called with a valid
+             *             engine.
+             */
+            udp_socket() = default;
+
+            /**
+             * @brief      Constructs a new instance in an empty state but with an engine
+             *             registered.
+             *
+             * @param      _engine  The engine to register.
+             *
+             */
+            udp_socket(engine* _engine);
+
+            /**
+             * @brief Copy constructor is deleted.
+             *
+             */
+            udp_socket(const udp_socket&) = delete;
+
+            /**
+             * @brief Moves a udp_socket leaving it in an empty state and no engine registered.
+             *
+             * @param _move The udp_socket to move.
+             */
+            udp_socket(udp_socket&& _move) = default;
+
+            /**
+             * @brief      Moves a udp_socket leaving it in an empty state and with no engine.
+             *
+             * @param      _move  The socket to move.
+             *
+             * @return     The result of the assignment.
+             */
+            udp_socket&
+            operator=(udp_socket&& _move) = default;
+
+            /**
+             * @brief      Destroys the socket, closing it.
+             *
+             */
+            ~udp_socket() = default;
+
+            /**
+             * @brief Bind to a port on every address, creating the socket if there is none.
+             *
+             * @param _family AF_INET or AF_INET6 for ipv4 and ipv6 respectively.
+             * @param _port Which port to bind to, or 0 for any. See `port()`.
+             * @return true If bound successfully.
+             * @return false If an error occurs. `last_error()` is set.
+             */
+            [[nodiscard]] bool
+            bind(int _family, std::uint16_t _port) noexcept;
+
+            /**
+             * @brief Set the default destination, creating the socket if there is none. Only
+             *        datagrams from this address are received afterwards.
+             *
+             * @param _address The address of the peer.
+             * @param _length The length of _address.
+             * @return true If successful.
+             * @return false If an error occurs. `last_error()` is set.
+             */
+            [[nodiscard]] bool
+            connect(const struct sockaddr* _address, socklen_t _length) noexcept;
+
+            /**
+             * @brief Allow the kernel to coalesce received datagrams (UDP_GRO). See
+             *        `datagram::segment_size_` and `segment_size()`.
+             *
+             * @return false If an error occurs. `last_error()` is set.
+             */
+            [[nodiscard]] bool
+            set_gro(bool _enabled) noexcept;
+
+            /**
+             * @brief The local port the socket is bound to, or 0 on error.
+             *
+             */
+            [[nodiscard]] std::uint16_t
+            port() noexcept;
+
+            /**
+             * @brief The UDP_GRO segment size in the control data of a received message, or 0 if
+             *        the datagrams were not coalesced.
+             *
+             */
+            [[nodiscard]] static std::uint16_t
+            segment_size(const struct msghdr& _message) noexcept;
+
+            /**
+             * @brief Receive a message.
+             *
+             * @details This function always suspends and is cancelable using `cancel()`.
+             *
+             * @param _message The message header to receive into.
+             * @param _flags The flags to apply to the receive. See `::recvmsg()`.
+             * @co_return The number of bytes received or -1 on error. `last_error()` is set.
+             */
+            [[nodiscard]] auto
+            recv_msg(struct msghdr* _message, int _flags = 0) noexcept
+            {
+                return suspension_point(
+                    [this, ret = net_op{}, _message, _flags]<typename T>(
+                        T _handle) mutable noexcept
+                    {
+                        if constexpr (is_suspend<T>())
+                        {
+                            ret.handle_ = _handle;
+                            set_cancel(&ret);
+                            get_engine()->get_event_loop().recv_msg(
+                                &ret,
+                                descriptor(),
+                                _message,
+                                _flags);
+                        }
+                        else if constexpr (is_resume<T>()) { return settle(ret); }
+                    });
+            }
+
+            /**
+             * @brief Send a message.
+             *
+             * @details This function always suspends and is cancelable using `cancel()`.
+             *
+             * @param _message The message header to send.
+             * @param _flags The flags to apply to the send. See `::sendmsg()`.
+             * @co_return The number of bytes sent or -1 on error. `last_error()` is set.
+             */
+            [[nodiscard]] auto
+            send_msg(const struct msghdr* _message, int _flags = 0) noexcept
+            {
+                return suspension_point(
+                    [this, ret = net_op{}, _message, _flags]<typename T>(
+                        T _handle) mutable noexcept
+                    {
+                        if constexpr (is_suspend<T>())
+                        {
+                            ret.handle_ = _handle;
+                            set_cancel(&ret);
+                            get_engine()->get_event_loop().send_msg(
+                                &ret,
+                                descriptor(),
+                                _message,
+                                _flags);
+                        }
+                        else if constexpr (is_resume<T>()) { return settle(ret); }
+                    });
+            }
+
+            /**
+             * @brief Send one datagram, or with a `_segment_size` many datagrams of that size
+             *        in a single call (UDP_SEGMENT). The last one may be shorter.
+             *
+             * @details This function always suspends and is cancelable using `cancel()`.
+             *
+             * @param _data The payload.
+             * @param _address The destination, or nullptr if connected.
+             * @param _length The length of _address.
+             * @param _segment_size The size to split _data into, or 0 to send it whole.
+             * @co_return The number of bytes sent or -1 on error. `last_error()` is set.
+             */
+            [[nodiscard]] auto
+            send_to(
+                std::span<const std::byte> _data,
+                const struct sockaddr*     _address      = nullptr,
+                socklen_t                  _length       = 0,
+                std::uint16_t              _segment_size = 0) noexcept
+            {
+                return suspension_point(
+                    [this,
+                     ret   = net_op{},
+                     state = details::send_state{},
+                     _data,
+                     _address,
+                     _length,
+                     _segment_size]<typename T>(T _handle) mutable noexcept
+                    {
+                        if constexpr (is_suspend<T>())
+                        {
+                            ret.handle_ = _handle;
+                            set_cancel(&ret);
+                            state.prepare(_data, _address, _length, _segment_size);
+                            get_engine()->get_event_loop().send_msg(
+                                &ret,
+                                descriptor(),
+                                &state.message_,
+                                0);
+                        }
+                        else if constexpr (is_resume<T>()) { return settle(ret); }
+                    });
+            }
+
+            /**
+             * @brief Receive datagrams into buffers of `_buffers` with a multishot recvmsg, and
+             *        call `_handler(const datagram&)` for each of them.
+             *
+             * @details The buffer is given back to the kernel when the handler returns. The
+             *          receive is rearmed whenever the kernel stops it, for example when it ran
+             *          out of buffers, and continues until an error occurs or `cancel()` is
+             *          awaited. `_buffers` must have been provided on the current thread.
+             *
+             * @param _buffers The buffers to receive into.
+             * @param _handler Called with every datagram.
+             * @co_return The error that stopped the receive, ECANCELED if canceled.
+             */
+            template <typename Handler>
+            guaranteed_future<int>
+            receive(buffer_group& _buffers, Handler _handler) noexcept
+            {
+                details::receive_state state(_buffers);
+                stopped_ = false;
+                do
+                {
+                    /* A cancel made while nothing was armed, such as from the handler. */
+                    if (stopped_ && !state.armed_)
+                    {
+                        state.error_ = ECANCELED;
+                        set_error(state.error_);
+                        break;
+                    }
+
+                    co_await suspension_point(
+                        [this, &state]<typename T>(T _handle) noexcept
+                        {
+                            if constexpr (is_suspend<T>())
+                            {
+                                state.event_.handle_ = _handle;
+                                if (!state.armed_) { arm(state); }
+                            }
+                        });
+
+                    if (auto message = complete(state))
+                    {
+                        _handler(std::as_const(*message));
+                        _buffers.recycle(state.buffer_id_);
+                    }
+
+                } while (!state.error_);
+
+                co_return state.error_;
+            }
+
+            /**
+             * @brief Cancel the current operation. A `receive()` stops even if it is between
+             *        multishot operations, such as when canceled from its handler.
+             *
+             * @co_return void Resumes once the operation has been cancelled or an error occurs.
+             */
+            [[nodiscard]] auto
+            cancel() noexcept
+            {
+                stopped_ = true;
+                return network_operation::cancel();
+            }
+
+        private:
+
+            int
+            settle(const net_op& _op) noexcept;
+
+            void
+            arm(details::receive_state& _state) noexcept;
+
+            std::optional<datagram>
+            complete(details::receive_state& _state) noexcept;
+
+            bool stopped_ = false;
+    };
+
+}   // namespace zab
+
+#endif /* ZAB_UDP_NETWORKING_HPP_ */
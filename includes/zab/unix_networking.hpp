@@ -0,0 +1,449 @@
+/*
+ *  MMM"""AMV       db      `7MM"""Yp,
+ *  M'   AMV       ;MM:       MM    Yb
+ *  '   AMV       ,V^MM.      MM    dP
+ *     AMV       ,M  `MM      MM"""bg.
+ *    AMV   ,    AbmmmqMA     MM    `Y
+ *   AMV   ,M   A'     VML    MM    ,9
+ *  AMVmmmmMM .AMA.   .AMMA..JMMmmmd9
+ *
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021 Donald-Rupin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ *  @file unix_networking.hpp
+ *
+ */
+
+#ifndef ZAB_UNIX_NETWORKING_HPP_
+#define ZAB_UNIX_NETWORKING_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "zab/engine.hpp"
+#include "zab/event_loop.hpp"
+#include "zab/memory_type.hpp"
+#include "zab/network_operation.hpp"
+#include "zab/tcp_stream.hpp"
+
+namespace zab {
+
+    /**
+     * @brief A Unix domain socket connection. It is read and written exactly like a tcp_stream.
+     *
+     * @details For SOCK_SEQPACKET sockets each `read_some()` returns one message and each
+     *          `write_some()` sends one. `read()` and `write()` may span several messages.
+     */
+    template <MemoryType DataType = std::byte>
+    using unix_stream = tcp_stream<DataType>;
+
+    namespace details {
+
+        /**
+         * @brief Fill out a sockaddr_un for a path. A path starting with '\0' names a socket in
+         *        the abstract namespace.
+         *
+         * @return false If the path is empty or too long.
+         */
+        [[nodiscard]] bool
+        make_unix_address(
+            std::string_view    _path,
+            struct sockaddr_un& _address,
+            socklen_t&          _length) noexcept;
+
+        /**
+         * @brief The message header of a descriptor passing operation that lives in the
+         *        awaitable.
+         */
+        struct descriptor_message {
+
+                static constexpr std::size_t kMaxDescriptors = 64;
+
+                void
+                prepare_send(std::span<const std::byte> _data, std::span<const int> _fds) noexcept;
+
+                void
+                prepare_receive(std::span<std::byte> _data) noexcept;
+
+                /**
+                 * @brief Copy the received descriptors into `_fds`, closing any that do not fit.
+                 *
+                 * @return The number of descriptors copied.
+                 */
+                std::size_t
+                take(std::span<int> _fds) noexcept;
+
+                struct msghdr message_;
+                struct iovec  vector_;
+                alignas(struct cmsghdr) char control_[CMSG_SPACE(sizeof(int) * kMaxDescriptors)];
+        };
+
+    }   // namespace details
+
+    /**
+     * @brief The result of `receive_descriptors()`.
+     */
+    struct received_descriptors {
+
+            /**
+             * @brief The amount of data bytes received or -1 if an error occurred.
+             */
+            int bytes_;
+
+            /**
+             * @brief The number of descriptors written to the output span.
+             */
+            std::size_t count_;
+    };
+
+    /**
+     * @brief      This class allows for asynchronous Unix domain server socket operations.
+     *
+     * @details    The methods of the class are essentially asynchronous equivalents to
+     *             socket(2), bind(2), listen(2) and accept(2) for AF_UNIX sockets.
+     */
+    class unix_acceptor : public network_operation {
+
+        public:
+
+            /**
+             * @brief      Constructs a new instance in an empty state.
+             *
+             *             If this constructor is used, use of `listen` and `accept`,
+             *             will result in undefined behavior until `register_engine`
+             *             is called with a valid engine.
+             */
+            unix_acceptor() = default;
+
+            /**
+             * @brief      Constructs a new instance in an empty state but with an engine
+             *             registered.
+             *
+             * @param      _engine  The engine to register.
+             *
+             */
+            unix_acceptor(engine* _engine);
+
+            /**
+             * @brief Copy constructor is deleted.
+             *
+             */
+            unix_acceptor(const unix_acceptor&) = delete;
+
+            /**
+             * @brief Moves a unix_acceptor leaving it in an empty state and no engine registered.
+             *
+             * @param _move The unix_acceptor to move.
+             */
+            unix_acceptor(unix_acceptor&& _move) = default;
+
+            /**
+             * @brief      Moves a unix_acceptor leaving it in an empty state and with no engine.
+             *
+             * @param      _move  The acceptor to move.
+             *
+             * @return     The result of the assignment.
+             */
+            unix_acceptor&
+            operator=(unix_acceptor&& _move) = default;
+
+            /**
+             * @brief      Destroys the acceptor, closing its socket. A socket file is left in
+             *             place.
+             *
+             */
+            ~unix_acceptor() = default;
+
+            /**
+             * @brief Start listening to connections on a newly created socket.
+             *
+             * @details This function creates a new socket using `::socket()`, then calls
+             *          `::bind()` and `::listen()`. A socket file that already exists at
+             *          `_path` is not removed and fails with EADDRINUSE.
+             *
+             * @param _path The path to listen on. A leading '\0' names an abstract socket.
+             * @param _backlog The maximum amount of pending connections to hold.
+             * @param _type SOCK_STREAM or SOCK_SEQPACKET.
+             * @return true If started successfully.
+             * @return false If an error occurs. `last_error()` is set.
+             */
+            [[nodiscard]] bool
+            listen(std::string_view _path, int _backlog, int _type = SOCK_STREAM) noexcept;
+
+            /**
+             * @brief Attempts to accept a connection.
+             *
+             * @details This function always suspends.
+             *
+             *          This function is cancelable using the `cancel()` function.
+             *
+             * @tparam DataType The type of memory the produced unix_stream will use.
+             * @param _flags The flags to apply to the accept call. The default is SOCK_CLOEXEC. See
+             *               `::accept4()`
+             * @co_return unix_stream<DataType> if no error occurs, or std::nullopt.
+             */
+            template <MemoryType DataType = std::byte>
+            [[nodiscard]] auto
+            accept(int _flags = SOCK_CLOEXEC) noexcept
+            {
+                return suspension_point(
+                    [this, ret = event_loop::io_event{}, _flags]<typename T>(
+                        T _handle) mutable noexcept
+                    {
+                        if constexpr (is_suspend<T>())
+                        {
+                            ret.handle_ = _handle;
+                            set_cancel(&ret);
+                            get_engine()
+                                ->get_event_loop()
+                                .accept(&ret, descriptor(), nullptr, nullptr, _flags);
+                        }
+                        else if constexpr (is_resume<T>())
+                        {
+                            std::optional<unix_stream<DataType>> stream;
+                            set_cancel(nullptr);
+                            if (ret.result_ >= 0) { stream.emplace(get_engine(), ret.result_); }
+                            else
+                            {
+                                set_error(-ret.result_);
+                            }
+
+                            return stream;
+                        }
+                    });
+            }
+    };
+
+    /**
+     * @brief A free function for connecting to a Unix domain server.
+     *
+     * @details This function suspends only if there is no error on socket creation.
+     *
+     *          This function is equivelent to calling `::socket()` and `::connect()`.
+     *
+     * @tparam DataType The memory type of the stream.
+     * @param _engine The engine to use. It is expected that the caller is currently in an engines
+     *                thread.
+     * @param _path The path of the server. A leading '\0' names an abstract socket.
+     * @param _type SOCK_STREAM or SOCK_SEQPACKET.
+     * @param cancel_token_ An option `cancel_token_` that can be passed in that can be used to the
+     *                      cancel the operation.  If a io_handle* is passed it it will
+     *                      be set before suspension.
+     * @param _sock_flags Flags to apply to the socket during socket creation. SOCK_CLOEXEC is the
+     *                    default.
+     * @co_return unix_stream A stream is always returned to take ownership of the connector
+     *                        socket. If an error occurred the streams last_error is set.
+     */
+    template <MemoryType DataType = std::byte>
+    [[nodiscard]] inline auto
+    unix_connect(
+        engine*                _engine,
+        std::string_view       _path,
+        int                    _type         = SOCK_STREAM,
+        event_loop::io_event** cancel_token_ = nullptr,
+        int                    _sock_flags   = SOCK_CLOEXEC)
+    {
+        network_operation  net_op(_engine);
+        struct sockaddr_un address;
+        socklen_t          length = 0;
+
+        if (!details::make_unix_address(_path, address, length)) { net_op.set_error(EINVAL); }
+        else if (int sd = ::socket(AF_UNIX, _type | _sock_flags, 0); sd >= 0)
+        {
+            net_op.set_descriptor(sd);
+        }
+        else
+        {
+            net_op.set_error(errno);
+        }
+
+        return suspension_point(
+            [net_op = std::move(net_op),
+             ret    = event_loop::io_event{},
+             address,
+             length,
+             cancel_token_]<typename T>(T _handle) mutable noexcept
+            {
+                if constexpr (is_ready<T>()) { return net_op.peek_error() != 0; }
+                else if constexpr (is_suspend<T>())
+                {
+                    ret.handle_ = _handle;
+                    if (cancel_token_) { *cancel_token_ = &ret; }
+
+                    net_op.get_engine()->get_event_loop().connect(
+                        &ret,
+                        net_op.descriptor(),
+                        (struct sockaddr*) &address,
+                        length);
+                }
+                else if constexpr (is_resume<T>())
+                {
+                    if (!net_op.peek_error() && ret.result_ == 0)
+                    {
+                        auto ds = net_op.descriptor();
+                        net_op.clear_descriptor();
+                        return unix_stream<DataType>(net_op.get_engine(), ds);
+                    }
+                    else
+                    {
+                        unix_stream<DataType> stream(
+                            net_op.get_engine(),
+                            network_operation::kNoDescriptor);
+                        stream.set_error(net_op.peek_error() ? net_op.last_error() : -ret.result_);
+
+                        return stream;
+                    }
+                }
+            });
+    }
+
+    /**
+     * @brief Send descriptors over a Unix domain socket (SCM_RIGHTS) along with some data.
+     *
+     * @details This function always suspends. The descriptors stay open in the sender. At least
+     *          one byte of data must be sent with them.
+     *
+     * @param _stream The connected stream.
+     * @param _data The data to send with the descriptors.
+     * @param _fds The descriptors, at most `details::descriptor_message::kMaxDescriptors`.
+     * @param cancel_token_ An optional ptr that will be set to the cancelation handle.
+     * @co_return int The amount of data bytes sent or -1 if an error occurred. The streams
+     *                last_error is set.
+     */
+    template <MemoryType DataType>
+    [[nodiscard]] inline auto
+    send_descriptors(
+        unix_stream<DataType>&    _stream,
+        std::span<const DataType> _data,
+        std::span<const int>      _fds,
+        event_loop::io_event**    cancel_token_ = nullptr) noexcept
+    {
+        return suspension_point(
+            [&_stream,
+             ret     = event_loop::io_event{},
+             message = details::descriptor_message{},
+             _data,
+             _fds,
+             cancel_token_]<typename T>(T _handle) mutable noexcept
+            {
+                if constexpr (is_suspend<T>())
+                {
+                    ret.handle_ = _handle;
+                    if (cancel_token_) { *cancel_token_ = &ret; }
+
+                    if (_fds.size() > details::descriptor_message::kMaxDescriptors || _data.empty())
+                    {
+                        ret.result_ = -EINVAL;
+                        return false;
+                    }
+
+                    message.prepare_send(
+                        std::span<const std::byte>((const std::byte*) _data.data(), _data.size()),
+                        _fds);
+
+                    _stream.get_engine()->get_event_loop().send_msg(
+                        &ret,
+                        _stream.descriptor(),
+                        &message.message_,
+                        MSG_NOSIGNAL);
+
+                    return true;
+                }
+                else if constexpr (is_resume<T>())
+                {
+                    if (cancel_token_) { *cancel_token_ = nullptr; }
+                    if (ret.result_ >= 0) { return ret.result_; }
+
+                    _stream.set_error(-ret.result_);
+                    return -1;
+                }
+            });
+    }
+
+    /**
+     * @brief Receive data and any descriptors sent with it over a Unix domain socket.
+     *
+     * @details This function always suspends. The received descriptors are owned by the caller
+     *          and are opened with FD_CLOEXEC. Descriptors that do not fit in `_fds` are closed.
+     *
+     * @param _stream The connected stream.
+     * @param _data The buffer to receive data into.
+     * @param _fds Where to write the received descriptors.
+     * @param cancel_token_ An optional ptr that will be set to the cancelation handle.
+     * @co_return received_descriptors The amount of data received, -1 on error with the streams
+     *                                 last_error set, and the number of descriptors.
+     */
+    template <MemoryType DataType>
+    [[nodiscard]] inline auto
+    receive_descriptors(
+        unix_stream<DataType>& _stream,
+        std::span<DataType>    _data,
+        std::span<int>         _fds,
+        event_loop::io_event** cancel_token_ = nullptr) noexcept
+    {
+        return suspension_point(
+            [&_stream,
+             ret     = event_loop::io_event{},
+             message = details::descriptor_message{},
+             _data,
+             _fds,
+             cancel_token_]<typename T>(T _handle) mutable noexcept
+            {
+                if constexpr (is_suspend<T>())
+                {
+                    ret.handle_ = _handle;
+                    if (cancel_token_) { *cancel_token_ = &ret; }
+
+                    message.prepare_receive(
+                        std::span<std::byte>((std::byte*) _data.data(), _data.size()));
+
+                    _stream.get_engine()->get_event_loop().recv_msg(
+                        &ret,
+                        _stream.descriptor(),
+                        &message.message_,
+                        MSG_CMSG_CLOEXEC);
+                }
+                else if constexpr (is_resume<T>())
+                {
+                    if (cancel_token_) { *cancel_token_ = nullptr; }
+                    if (ret.result_ >= 0)
+                    {
+                        return received_descriptors{
+                            .bytes_ = ret.result_,
+                            .count_ = message.take(_fds)};
+                    }
+
+                    _stream.set_error(-ret.result_);
+                    return received_descriptors{.bytes_ = -1, .count_ = 0};
+                }
+            });
+    }
+
+}   // namespace zab
+
+#endif /* ZAB_UNIX_NETWORKING_HPP_ */
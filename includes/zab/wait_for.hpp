@@ -38,7 +38,6 @@
 #define ZAB_WAIT_FOR_HPP_
 
 #include <algorithm>
-#include <atomic>
 #include <functional>
 #include <initializer_list>
 #include <iostream>
@@ -55,6 +54,7 @@
 #include "zab/reusable_future.hpp"
 #include "zab/simple_future.hpp"
 #include "zab/stateful_awaitable.hpp"
+#include "zab/threading.hpp"
 #include "zab/yield.hpp"
 
 namespace zab {
@@ -227,7 +227,7 @@ namespace zab {
 
                     result_type              results_;
                     waiter_type              waiters_;
-                    std::atomic<std::size_t> counter_;
+                    atomic<std::size_t> counter_;
 
                     tagged_event event_;
             };
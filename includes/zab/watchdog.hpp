@@ -0,0 +1,247 @@
+/*
+ *  MMM"""AMV       db      `7MM"""Yp,
+ *  M'   AMV       ;MM:       MM    Yb
+ *  '   AMV       ,V^MM.      MM    dP
+ *     AMV       ,M  `MM      MM"""bg.
+ *    AMV   ,    AbmmmqMA     MM    `Y
+ *   AMV   ,M   A'     VML    MM    ,9
+ *  AMVmmmmMM .AMA.   .AMMA..JMMmmmd9
+ *
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021 Donald-Rupin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ *  @file watchdog.hpp
+ *
+ */
+
+#ifndef ZAB_WATCHDOG_HPP_
+#define ZAB_WATCHDOG_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <stop_token>
+#include <thread>
+#include <vector>
+
+#include "zab/strong_types.hpp"
+
+namespace zab {
+
+    class engine;
+
+    /**
+     * @brief A single step of an event loop that ran for longer than the watchdog threshold.
+     */
+    struct stall_report {
+
+            /**
+             * @brief The event loop that is stalled.
+             */
+            thread_t loop_;
+
+            /**
+             * @brief How long the step had been running when it was sampled.
+             */
+            std::chrono::nanoseconds duration_;
+
+            /**
+             * @brief The address of the coroutine (or event context) being resumed. This is the
+             *        `id` of the matching "resume" slice when tracing is enabled.
+             */
+            const void* coroutine_;
+    };
+
+    namespace details {
+
+        /**
+         * @brief Published by an event loop around every event it runs so that another thread can
+         *        see how long the current one has been running.
+         *
+         * @details Always uses real atomics, since the reader is the watchdog thread even when
+         *          zab is built single threaded. Writes are bracketed by an odd sequence number,
+         *          so a reader can tell that its copy of a step is torn and retry.
+         */
+        class step_monitor {
+
+            public:
+
+                struct sample {
+                        std::uint64_t sequence_;
+                        std::uint64_t started_;
+                        const void*   coroutine_;
+                };
+
+                /**
+                 * @brief Mark the start of a step. Only called by the owning loop.
+                 *
+                 * @param _coroutine The identity of what is being resumed.
+                 * @param _now The steady clock in nanoseconds.
+                 */
+                inline void
+                begin(const void* _coroutine, std::uint64_t _now) noexcept
+                {
+                    auto sequence = open();
+                    coroutine_.store(_coroutine, std::memory_order_relaxed);
+                    started_.store(_now, std::memory_order_relaxed);
+                    sequence_.store(sequence + 2, std::memory_order_release);
+                }
+
+                /**
+                 * @brief Mark the end of a step. Only called by the owning loop.
+                 */
+                inline void
+                end() noexcept
+                {
+                    auto sequence = open();
+                    started_.store(0, std::memory_order_relaxed);
+                    sequence_.store(sequence + 2, std::memory_order_release);
+                }
+
+                /**
+                 * @brief Read the current step from any thread.
+                 *
+                 * @return The step, with `started_` 0 if the loop is between steps or kept
+                 *         changing it while it was read.
+                 */
+                inline sample
+                read() const noexcept
+                {
+                    for (int i = 0; i < kRetries; ++i)
+                    {
+                        auto before = sequence_.load(std::memory_order_acquire);
+                        if (before & 1) { continue; }
+
+                        auto started   = started_.load(std::memory_order_relaxed);
+                        auto coroutine = coroutine_.load(std::memory_order_relaxed);
+
+                        std::atomic_thread_fence(std::memory_order_acquire);
+                        if (before == sequence_.load(std::memory_order_relaxed))
+                        {
+                            return sample{
+                                .sequence_  = before,
+                                .started_   = started,
+                                .coroutine_ = coroutine};
+                        }
+                    }
+
+                    return sample{.sequence_ = 0, .started_ = 0, .coroutine_ = nullptr};
+                }
+
+            private:
+
+                /**
+                 * @brief Mark the step as being written.
+                 *
+                 * @return The sequence before the write.
+                 */
+                inline std::uint64_t
+                open() noexcept
+                {
+                    auto sequence = sequence_.load(std::memory_order_relaxed);
+                    sequence_.store(sequence + 1, std::memory_order_relaxed);
+                    std::atomic_thread_fence(std::memory_order_release);
+                    return sequence;
+                }
+
+                static constexpr int kRetries = 16;
+
+                std::atomic<std::uint64_t> sequence_  = 0;
+                std::atomic<std::uint64_t> started_   = 0;
+                std::atomic<const void*>   coroutine_ = nullptr;
+        };
+
+    }   // namespace details
+
+    /**
+     * @brief A background thread that samples every event loop and reports any single step (one
+     *        coroutine resumption) that runs for longer than a threshold.
+     *
+     * @details A step that blocks (a synchronous syscall, a heavy cpu loop) stalls every other
+     *          coroutine on the same loop. Each stalled step is reported once, while it is still
+     *          running. Loops only publish their steps once `event_loop::enable_step_monitoring`
+     *          has been called, which `engine` does when `configs::stall_threshold_` is set.
+     */
+    class watchdog {
+
+        public:
+
+            using handler = std::function<void(const stall_report&)>;
+
+            /**
+             * @brief Construct a watchdog, it does not run until `start()`.
+             *
+             * @param _engine The engine whose loops are watched.
+             * @param _threshold Steps running longer than this are reported.
+             * @param _handler Called from the watchdog thread for each report. Defaults to
+             *                 `print_report`.
+             */
+            watchdog(engine* _engine, std::chrono::nanoseconds _threshold, handler _handler = {});
+
+            ~watchdog();
+
+            watchdog(const watchdog&) = delete;
+
+            watchdog&
+            operator=(const watchdog&) = delete;
+
+            /**
+             * @brief Start sampling.
+             */
+            void
+            start();
+
+            /**
+             * @brief Stop sampling and join the thread.
+             */
+            void
+            stop();
+
+            /**
+             * @brief The default handler, writes the report to std::cerr.
+             *
+             * @param _report The report.
+             */
+            static void
+            print_report(const stall_report& _report);
+
+        private:
+
+            void
+            run(std::stop_token _stop_token);
+
+            engine*                     engine_;
+            std::chrono::nanoseconds    threshold_;
+            handler                     handler_;
+            std::vector<std::uint64_t>  reported_;
+            std::mutex                  mtx_;
+            std::condition_variable_any cv_;
+            std::jthread                thread_;
+    };
+
+}   // namespace zab
+
+#endif /* ZAB_WATCHDOG_HPP_ */
@@ -0,0 +1,217 @@
+/*
+ *  MMM"""AMV       db      `7MM"""Yp,
+ *  M'   AMV       ;MM:       MM    Yb
+ *  '   AMV       ,V^MM.      MM    dP
+ *     AMV       ,M  `MM      MM"""bg.
+ *    AMV   ,    AbmmmqMA     MM    `Y
+ *   AMV   ,M   A'     VML    MM    ,9
+ *  AMVmmmmMM .AMA.   .AMMA..JMMmmmd9
+ *
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021 Donald-Rupin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ *  @file write_queue.hpp
+ *
+ */
+
+#ifndef ZAB_WRITE_QUEUE_HPP_
+#define ZAB_WRITE_QUEUE_HPP_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "zab/async_function.hpp"
+#include "zab/event.hpp"
+#include "zab/generic_awaitable.hpp"
+#include "zab/memory_type.hpp"
+#include "zab/tcp_stream.hpp"
+#include "zab/yield.hpp"
+
+namespace zab {
+
+    /**
+     * @brief An optional queue in front of a tcp_stream that gathers the writes made during
+     *        one turn of the event loop into a single `::sendmsg()`.
+     *
+     * @details Pipelined servers often have many coroutines each writing a small response to
+     *          the same stream. Rather than each becoming its own send, the first write in a
+     *          turn schedules a flush for the next turn and every write queued before then is
+     *          sent with it. Writes queued while a flush is in flight form the next batch.
+     *
+     *          Buffers are written in the order they were queued. The queue, the stream and
+     *          the writers must all live in the same thread, and the queue must outlive any
+     *          write queued on it. Mixing queued writes with direct writes on the stream
+     *          gives no ordering guarantees between the two.
+     *
+     * @tparam DataType The MemoryType of the underlying stream.
+     */
+    template <MemoryType DataType = std::byte>
+    class write_queue {
+
+        public:
+
+            /**
+             * @brief Construct a write queue in front of `_stream`.
+             *
+             * @param _stream The stream to write to. Must outlive the queue.
+             * @param _flags Any flags to pass to sendmsg. MSG_NOSIGNAL is the default.
+             */
+            explicit write_queue(tcp_stream<DataType>& _stream, int _flags = MSG_NOSIGNAL)
+                : stream_(_stream), flags_(_flags)
+            { }
+
+            write_queue(const write_queue&) = delete;
+
+            write_queue&
+            operator=(const write_queue&) = delete;
+
+            /**
+             * @brief Queue `_data` to be written in the next flush. The buffer must stay valid
+             *        until the write resumes.
+             *
+             * @param _data The buffer to write from.
+             * @co_return long long The amount of `_data` written, which is less than its size
+             *                      only if an error occurred part way through, or -1 if an
+             *                      error occurred before any of it was written.
+             */
+            [[nodiscard]] auto
+            write(std::span<const DataType> _data) noexcept
+            {
+                return suspension_point(
+                    [this,
+                     entry = queued_write{
+                         .data_   = _data,
+                         .handle_ = {},
+                         .result_ = 0}]<typename T>(T _handle) mutable noexcept
+                    {
+                        if constexpr (is_ready<T>()) { return entry.data_.empty(); }
+                        else if constexpr (is_suspend<T>())
+                        {
+                            entry.handle_ = _handle;
+                            pending_.push_back(&entry);
+
+                            if (!flushing_)
+                            {
+                                flushing_ = true;
+                                flush();
+                            }
+                        }
+                        else if constexpr (is_resume<T>())
+                        {
+                            return entry.result_;
+                        }
+                    });
+            }
+
+            /**
+             * @brief The amount of writes waiting for the next flush.
+             */
+            [[nodiscard]] std::size_t
+            pending() const noexcept
+            {
+                return pending_.size();
+            }
+
+            /**
+             * @brief The amount of flushes, and so batched sends, performed so far.
+             */
+            [[nodiscard]] std::uint64_t
+            flushes() const noexcept
+            {
+                return flushes_;
+            }
+
+        private:
+
+            struct queued_write {
+                    std::span<const DataType> data_;
+                    tagged_event              handle_;
+                    long long                 result_ = 0;
+            };
+
+            /**
+             * @brief Send everything queued, starting in the next turn of the event loop.
+             *
+             * @details The writers of a batch are resumed in the order they queued once the
+             *          batch is written. Anything they queue in response is sent as the
+             *          following batch.
+             */
+            async_function<>
+            flush() noexcept
+            {
+                co_await yield(stream_.get_engine());
+
+                while (pending_.size())
+                {
+                    batch_.swap(pending_);
+
+                    buffers_.clear();
+                    for (const auto* entry : batch_)
+                    {
+                        buffers_.push_back(entry->data_);
+                    }
+
+                    ++flushes_;
+                    auto written = co_await stream_.write_v(buffers_, flags_);
+
+                    /* Hand each writer its own portion of what was written. */
+                    if (written < 0) { written = 0; }
+                    for (auto* entry : batch_)
+                    {
+                        auto size = (long long) entry->data_.size();
+                        if (written >= size) { entry->result_ = size; }
+                        else if (written > 0) { entry->result_ = written; }
+                        else
+                        {
+                            entry->result_ = -1;
+                        }
+
+                        written -= std::min(written, size);
+                    }
+
+                    for (auto* entry : batch_)
+                    {
+                        execute_event(entry->handle_);
+                    }
+
+                    batch_.clear();
+                }
+
+                flushing_ = false;
+            }
+
+            tcp_stream<DataType>&                  stream_;
+            std::vector<queued_write*>             pending_;
+            std::vector<queued_write*>             batch_;
+            std::vector<std::span<const DataType>> buffers_;
+            std::uint64_t                          flushes_  = 0;
+            int                                    flags_;
+            bool                                   flushing_ = false;
+    };
+
+}   // namespace zab
+
+#endif /* ZAB_WRITE_QUEUE_HPP_ */
@@ -0,0 +1,147 @@
+/*
+ *  MMM"""AMV       db      `7MM"""Yp,
+ *  M'   AMV       ;MM:       MM    Yb
+ *  '   AMV       ,V^MM.      MM    dP
+ *     AMV       ,M  `MM      MM"""bg.
+ *    AMV   ,    AbmmmqMA     MM    `Y
+ *   AMV   ,M   A'     VML    MM    ,9
+ *  AMVmmmmMM .AMA.   .AMMA..JMMmmmd9
+ *
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021 Donald-Rupin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ *  @file arena.cpp
+ *
+ */
+
+#include "zab/arena.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <memory>
+#include <new>
+
+namespace zab {
+
+    thread_local arena* arena::current_ = nullptr;
+
+    arena::arena(std::size_t _chunk_size) noexcept
+        : chunk_size_(_chunk_size), chunks_(nullptr), head_(nullptr), end_(nullptr), used_(0)
+    { }
+
+    arena::~arena()
+    {
+        release();
+
+        if (chunks_) { ::operator delete(chunks_); }
+    }
+
+    void
+    arena::release() noexcept
+    {
+        if (!chunks_) { return; }
+
+        /* Keep the oldest chunk around for reuse. */
+        auto* current = chunks_;
+        while (current->next_)
+        {
+            auto* tmp = current;
+            current   = current->next_;
+            ::operator delete(tmp);
+        }
+
+        chunks_ = current;
+        head_   = reinterpret_cast<std::byte*>(chunks_ + 1);
+        end_    = reinterpret_cast<std::byte*>(chunks_) + chunks_->size_;
+        used_   = 0;
+    }
+
+    void*
+    arena::do_allocate(std::size_t _bytes, std::size_t _alignment)
+    {
+        void*       ptr   = head_;
+        std::size_t space = end_ - head_;
+
+        if (head_ && std::align(_alignment, _bytes, ptr, space)) [[likely]]
+        {
+            head_ = static_cast<std::byte*>(ptr) + _bytes;
+            used_ += _bytes;
+            return ptr;
+        }
+
+        return allocate_chunk(_bytes, _alignment);
+    }
+
+    void*
+    arena::allocate_chunk(std::size_t _bytes, std::size_t _alignment)
+    {
+        const auto size = std::max(chunk_size_, sizeof(chunk) + _bytes + _alignment);
+
+        auto* new_chunk = static_cast<chunk*>(::operator new(size));
+        new_chunk->size_ = size;
+
+        new_chunk->next_ = chunks_;
+        chunks_          = new_chunk;
+
+        void*       ptr   = new_chunk + 1;
+        std::size_t space = size - sizeof(chunk);
+        std::align(_alignment, _bytes, ptr, space);
+
+        head_ = static_cast<std::byte*>(ptr) + _bytes;
+        end_  = reinterpret_cast<std::byte*>(new_chunk) + size;
+        used_ += _bytes;
+
+        return ptr;
+    }
+
+    void*
+    arena::allocate_frame(std::size_t _size)
+    {
+        auto* source = current_;
+
+        std::byte* memory;
+        if (source)
+        {
+            memory = static_cast<std::byte*>(
+                source->allocate(_size + kFrameHeader, __STDCPP_DEFAULT_NEW_ALIGNMENT__));
+        }
+        else
+        {
+            memory = static_cast<std::byte*>(::operator new(_size + kFrameHeader));
+        }
+
+        *reinterpret_cast<arena**>(memory) = source;
+
+        return memory + kFrameHeader;
+    }
+
+    void
+    arena::deallocate_frame(void* _frame, std::size_t _size) noexcept
+    {
+        auto* memory = static_cast<std::byte*>(_frame) - kFrameHeader;
+
+        /* Arena memory is released wholesale, so only heap frames are freed here. */
+        if (!*reinterpret_cast<arena**>(memory)) { ::operator delete(memory, _size + kFrameHeader); }
+    }
+
+}   // namespace zab
@@ -0,0 +1,195 @@
+/*
+ *  MMM"""AMV       db      `7MM"""Yp,
+ *  M'   AMV       ;MM:       MM    Yb
+ *  '   AMV       ,V^MM.      MM    dP
+ *     AMV       ,M  `MM      MM"""bg.
+ *    AMV   ,    AbmmmqMA     MM    `Y
+ *   AMV   ,M   A'     VML    MM    ,9
+ *  AMVmmmmMM .AMA.   .AMMA..JMMmmmd9
+ *
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021 Donald-Rupin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ *  @file buffered_reader.cpp
+ *
+ */
+
+#include "zab/buffered_reader.hpp"
+
+#include <cstddef>
+#include <cstring>
+#include <span>
+#include <string_view>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define ZAB_SCAN_X86
+#include <immintrin.h>
+#endif
+
+namespace zab::details {
+
+    namespace {
+
+        /**
+         * @brief Whether `_delimiter` is at `_data`, given its first byte already matched.
+         */
+        inline bool
+        matches(const std::byte* _data, std::span<const std::byte> _delimiter) noexcept
+        {
+            return _delimiter.size() < 2 ||
+                   !std::memcmp(_data + 1, _delimiter.data() + 1, _delimiter.size() - 1);
+        }
+
+#ifdef ZAB_SCAN_X86
+
+        /* Both vector versions compare a block against the first byte of the delimiter and the
+         * block that many bytes on against its last byte. Only positions where both match are
+         * checked in full, which for short delimiters such as "\r\n" is all of them. */
+
+        std::size_t
+        find_sse2(std::span<const std::byte> _data, std::span<const std::byte> _delimiter) noexcept
+        {
+            static constexpr std::size_t kWidth = 16;
+
+            const auto* data  = _data.data();
+            const auto  last  = _delimiter.size() - 1;
+            const auto  first = _mm_set1_epi8((char) _delimiter.front());
+            const auto  back  = _mm_set1_epi8((char) _delimiter.back());
+
+            std::size_t i = 0;
+            for (; i + last + kWidth <= _data.size(); i += kWidth)
+            {
+                auto head = _mm_loadu_si128((const __m128i*) (data + i));
+                auto tail = _mm_loadu_si128((const __m128i*) (data + i + last));
+
+                unsigned mask = _mm_movemask_epi8(
+                    _mm_and_si128(_mm_cmpeq_epi8(head, first), _mm_cmpeq_epi8(tail, back)));
+
+                while (mask)
+                {
+                    auto bit = __builtin_ctz(mask);
+                    if (matches(data + i + bit, _delimiter)) { return i + bit; }
+
+                    mask &= mask - 1;
+                }
+            }
+
+            return i + find_delimiter_scalar(_data.subspan(i), _delimiter);
+        }
+
+        __attribute__((target("avx2"))) std::size_t
+        find_avx2(std::span<const std::byte> _data, std::span<const std::byte> _delimiter) noexcept
+        {
+            static constexpr std::size_t kWidth = 32;
+
+            const auto* data  = _data.data();
+            const auto  last  = _delimiter.size() - 1;
+            const auto  first = _mm256_set1_epi8((char) _delimiter.front());
+            const auto  back  = _mm256_set1_epi8((char) _delimiter.back());
+
+            std::size_t i = 0;
+            for (; i + last + kWidth <= _data.size(); i += kWidth)
+            {
+                auto head = _mm256_loadu_si256((const __m256i*) (data + i));
+                auto tail = _mm256_loadu_si256((const __m256i*) (data + i + last));
+
+                unsigned mask = _mm256_movemask_epi8(_mm256_and_si256(
+                    _mm256_cmpeq_epi8(head, first),
+                    _mm256_cmpeq_epi8(tail, back)));
+
+                while (mask)
+                {
+                    auto bit = __builtin_ctz(mask);
+                    if (matches(data + i + bit, _delimiter)) { return i + bit; }
+
+                    mask &= mask - 1;
+                }
+            }
+
+            /* The remainder is less than two blocks of the narrower version. */
+            return i + find_sse2(_data.subspan(i), _delimiter);
+        }
+
+#endif
+
+        using scan_function = std::size_t (*)(
+            std::span<const std::byte>,
+            std::span<const std::byte>) noexcept;
+
+        struct scanner {
+
+                scan_function    scan_;
+                std::string_view name_;
+        };
+
+        scanner
+        select_scanner() noexcept
+        {
+#ifdef ZAB_SCAN_X86
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx2")) { return {&find_avx2, "avx2"}; }
+
+            return {&find_sse2, "sse2"};
+#else
+            return {&find_delimiter_scalar, "scalar"};
+#endif
+        }
+
+        const scanner kScanner = select_scanner();
+
+    }   // namespace
+
+    std::size_t
+    find_delimiter_scalar(
+        std::span<const std::byte> _data,
+        std::span<const std::byte> _delimiter) noexcept
+    {
+        if (_delimiter.empty()) { return 0; }
+
+        for (std::size_t i = 0; i + _delimiter.size() <= _data.size(); ++i)
+        {
+            if (_data[i] == _delimiter.front() && matches(_data.data() + i, _delimiter))
+            {
+                return i;
+            }
+        }
+
+        return _data.size();
+    }
+
+    std::size_t
+    find_delimiter(std::span<const std::byte> _data, std::span<const std::byte> _delimiter) noexcept
+    {
+        if (_delimiter.empty()) { return 0; }
+        if (_data.size() < _delimiter.size()) { return _data.size(); }
+
+        return kScanner.scan_(_data, _delimiter);
+    }
+
+    std::string_view
+    delimiter_scan_name() noexcept
+    {
+        return kScanner.name_;
+    }
+
+}   // namespace zab::details
@@ -39,11 +39,16 @@
 #include <fstream>
 #include <iterator>
 #include <latch>
+#include <pthread.h>
 #include <sched.h>
+#include <signal.h>
 #include <string>
 #include <thread>
 
 #include "zab/async_function.hpp"
+#include "zab/probes.hpp"
+#include "zab/threading.hpp"
+#include "zab/tracing.hpp"
 #include "zab/yield.hpp"
 
 namespace zab {
@@ -57,17 +62,76 @@ namespace zab {
 
             _func();
         }
+
+        /**
+         * @brief Blocks SIGPIPE in the current thread for the lifetime of the scope.
+         *
+         * @details A splice in to a socket cannot pass MSG_NOSIGNAL, so a peer that resets would
+         *          otherwise raise SIGPIPE and kill the process. Blocked, the splice just fails
+         *          with EPIPE. Any SIGPIPE raised meanwhile is discarded before the previous mask
+         *          is restored.
+         */
+        class sigpipe_block {
+
+            public:
+
+                sigpipe_block() noexcept
+                {
+                    ::sigemptyset(&pipe_);
+                    ::sigaddset(&pipe_, SIGPIPE);
+                    ::pthread_sigmask(SIG_BLOCK, &pipe_, &previous_);
+                }
+
+                sigpipe_block(const sigpipe_block&) = delete;
+
+                ~sigpipe_block()
+                {
+                    if (::sigismember(&previous_, SIGPIPE)) { return; }
+
+                    struct timespec immediately = {};
+                    while (::sigtimedwait(&pipe_, nullptr, &immediately) == SIGPIPE) { }
+
+                    ::pthread_sigmask(SIG_SETMASK, &previous_, nullptr);
+                }
+
+            private:
+
+                sigset_t pipe_;
+                sigset_t previous_;
+        };
+
     }   // namespace
 
     thread_local thread_t engine::this_thead_ = thread_t{};
 
     engine::engine(configs _configs)
-        : event_loop_(validate(_configs)), sig_handler_(this), configs_(_configs)
+        : event_loop_(validate(_configs)), sig_handler_(this), configs_(_configs),
+          topology_(topology::discover())
     {
-        event_loop_[0].initialise();
-        for (auto i = 1ul; i < event_loop_.size(); ++i)
+        auto placement = configs_.cpus_.empty() ? topology_.placement() : configs_.cpus_;
+
+        for (std::uint16_t i = 0; i < event_loop_.size(); ++i)
+        {
+            auto cpu  = placement[(i + configs_.affinity_offset_) % placement.size()];
+            auto info = topology_.find(cpu);
+
+            worker_cpus_.push_back(cpu);
+            worker_nodes_.push_back(info ? info->node_ : 0);
+        }
+
+        /* Create each ring on the node its worker will run on. */
+        for (std::uint16_t i = 0; i < event_loop_.size(); ++i)
         {
-            event_loop_[i].initialise(event_loop_[0].io_fd());
+            numa_scope scope(worker_nodes_[i], topology_.number_of_nodes());
+
+            if (configs_.track_latency_) { event_loop_[i].enable_latency_tracking(); }
+            if (configs_.stall_threshold_.count()) { event_loop_[i].enable_step_monitoring(); }
+
+            if (!i) { event_loop_[0].initialise(); }
+            else
+            {
+                event_loop_[i].initialise(event_loop_[0].io_fd());
+            }
         }
     }
 
@@ -76,7 +140,10 @@ namespace zab {
     {
         auto cores = core_count();
 
-        if (_configs.opt_ == configs::kAny) { _configs.threads_ = cores; }
+        if (_configs.opt_ == configs::kAny)
+        {
+            _configs.threads_ = _configs.cpus_.empty() ? cores : _configs.cpus_.size();
+        }
         else if (_configs.opt_ == configs::kAtLeast)
         {
             _configs.threads_ = std::max(cores, _configs.threads_);
@@ -84,6 +151,9 @@ namespace zab {
 
         if (!_configs.threads_) { _configs.threads_ = 1; }
 
+        /* The primitives are not thread safe in this mode. */
+        if constexpr (kSingleThreaded) { _configs.threads_ = 1; }
+
         return _configs.threads_;
     }
 
@@ -116,70 +186,127 @@ namespace zab {
     void
     engine::set_worker_affinity(thread_t _thread_id) noexcept
     {
-        if (_thread_id < threads_.size())
+        auto cpu = worker_cpu(_thread_id);
+
+        /* Without an explicit cpu list, never move a worker outside the mask it inherited. */
+        if (configs_.cpus_.empty())
         {
-            auto      count = core_count();
-            cpu_set_t cpuset;
-            CPU_ZERO(&cpuset);
-            CPU_SET((_thread_id.thread_ + configs_.affinity_offset_) % (count), &cpuset);
-            int rc = pthread_setaffinity_np(
-                threads_[_thread_id.thread_].native_handle(),
-                sizeof(cpu_set_t),
-                &cpuset);
-            if (rc != 0) { std::cerr << "Error calling pthread_setaffinity_np: " << rc << "\n"; }
+            cpu_set_t allowed;
+            CPU_ZERO(&allowed);
+            if (::sched_getaffinity(0, sizeof(allowed), &allowed) || !CPU_ISSET(cpu, &allowed))
+            {
+                return;
+            }
         }
+
+        cpu_set_t cpuset;
+        CPU_ZERO(&cpuset);
+        CPU_SET(cpu, &cpuset);
+        int rc = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset);
+        if (rc != 0) { std::cerr << "Error calling pthread_setaffinity_np: " << rc << "\n"; }
     }
 
     void
     engine::start() noexcept
     {
+        const std::uint16_t first = configs_.use_caller_thread_ ? 1 : 0;
+
         /* The main thread can just use the first one. */
         /* There will be no race since this thread will block until */
         /* the other threads start.  */
-        this_thead_ = thread_t{0};
+        auto previous = this_thead_;
+        this_thead_   = thread_t{0};
+
+        cpu_set_t caller_cpus;
+        if (first) { pthread_getaffinity_np(pthread_self(), sizeof(cpu_set_t), &caller_cpus); }
 
-        std::latch lat(configs_.threads_ + 1);
+        /* When the caller is worker 0 it arrives from `run_worker` instead. */
+        std::latch lat(configs_.threads_ + 1 - first);
 
         {
             std::scoped_lock lck(mtx_);
+            caller_stop_ = std::stop_source{};
+
             for (std::uint16_t i = 0; i < configs_.threads_; ++i)
             {
                 timers_.emplace_back(this);
+            }
+
+            for (std::uint16_t i = first; i < configs_.threads_; ++i)
+            {
                 threads_.emplace_back(
                     [this, &lat, i](auto _stop_token)
-                    {
-                        this_thead_ = thread_t{i};
-                        std::stop_callback callback(
-                            _stop_token,
-                            event_loop_[i].get_stop_function());
-
-                        lat.arrive_and_wait();
-
-                        if (i == signal_handler::kSignalThread) { sig_handler_.run(); }
-                        timers_[i].run();
-
-                        event_loop_[i].run(_stop_token);
-                    });
+                    { run_worker(thread_t{i}, _stop_token, lat); });
             }
         }
 
-        lat.arrive_and_wait();
+        if (configs_.stall_threshold_.count())
+        {
+            watchdog_ =
+                std::make_unique<watchdog>(this, configs_.stall_threshold_, configs_.stall_handler_);
+            watchdog_->start();
+        }
+
+        if (first) { run_worker(thread_t{0}, caller_stop_.get_token(), lat); }
+        else
+        {
+            lat.arrive_and_wait();
+        }
 
         for (auto& t : threads_)
         {
             if (t.joinable()) { t.join(); }
         }
 
+        if (watchdog_)
+        {
+            watchdog_->stop();
+            watchdog_.reset();
+        }
+
+        if (first)
+        {
+            this_thead_ = previous;
+            if (configs_.affinity_set_)
+            {
+                pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &caller_cpus);
+            }
+        }
+
         std::scoped_lock lck(mtx_);
         threads_.clear();
         timers_.clear();
     }
 
+    void
+    engine::run_worker(thread_t _thread, std::stop_token _stop_token, std::latch& _latch) noexcept
+    {
+        this_thead_ = _thread;
+        if (configs_.affinity_set_) { set_worker_affinity(_thread); }
+
+        sigpipe_block block;
+
+        if constexpr (kTracing)
+        {
+            tracing::name_thread("zab worker " + std::to_string(_thread.thread_));
+        }
+
+        std::stop_callback callback(_stop_token, event_loop_[_thread.thread_].get_stop_function());
+
+        _latch.arrive_and_wait();
+
+        if (_thread == signal_handler::kSignalThread) { sig_handler_.run(); }
+        timers_[_thread.thread_].run();
+
+        event_loop_[_thread.thread_].run(_stop_token);
+    }
+
     void
     engine::stop() noexcept
     {
         sig_handler_.stop();
         std::scoped_lock lck(mtx_);
+        caller_stop_.request_stop();
         for (auto& t : threads_)
         {
             t.request_stop();
@@ -198,14 +325,48 @@ namespace zab {
         thread_resume(_handle, this_thead_);
     }
 
+    event_loop_metrics
+    engine::metrics() const noexcept
+    {
+        event_loop_metrics total;
+        for (const auto& el : event_loop_)
+        {
+            total += el.metrics();
+        }
+
+        return total;
+    }
+
+    event_loop_latency
+    engine::latency() const noexcept
+    {
+        event_loop_latency total;
+        for (const auto& el : event_loop_)
+        {
+            total += el.latency();
+        }
+
+        return total;
+    }
+
     thread_t
     engine::get_any_thread()
     {
+        /* Prefer workers that share a NUMA node with the caller, if they are pinned there. */
+        bool local = configs_.affinity_set_ && topology_.number_of_nodes() > 1 &&
+                     this_thead_.thread_ < worker_nodes_.size();
+
         thread_t      thread;
         std::uint16_t current  = 0;
         std::size_t   min_size = std::numeric_limits<std::size_t>::max();
         for (const auto& el : event_loop_)
         {
+            if (local && worker_nodes_[current] != worker_nodes_[this_thead_.thread_])
+            {
+                ++current;
+                continue;
+            }
+
             auto es = el.event_size();
             if (!es)
             {
@@ -231,6 +392,8 @@ namespace zab {
 
         assert(_thread.thread_ < event_loop_.size());
 
+        ZAB_PROBE(thread_resume, _thread.thread_);
+
         event_loop_[_thread.thread_].dispatch_user_event(_handle);
     }
 
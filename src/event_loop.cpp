@@ -48,11 +48,19 @@
 #include <memory>
 #include <mutex>
 #include <optional>
+#include <span>
+#include <string_view>
 #include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <thread>
 #include <unistd.h>
 #include <utility>
 
+#include "zab/arena.hpp"
+#include "zab/introspection.hpp"
+#include "zab/probes.hpp"
 #include "zab/strong_types.hpp"
+#include "zab/tracing.hpp"
 
 namespace zab {
 
@@ -60,7 +68,12 @@ namespace zab {
 
         template <typename FunctionCallType, FunctionCallType Function, typename... Args>
         inline void
-        do_op_impl(event_loop::io_event* _cancel_token, struct io_uring* _ring, Args&&... _args)
+        do_op_impl(
+            details::loop_counters& _counters,
+            std::string_view        _name,
+            event_loop::io_event*   _cancel_token,
+            struct io_uring*        _ring,
+            Args&&... _args)
         {
             auto* sqe = io_uring_get_sqe(_ring);
 
@@ -69,15 +82,51 @@ namespace zab {
                 (*Function)(sqe, std::forward<Args>(_args)...);
 
                 io_uring_sqe_set_data(sqe, _cancel_token);
+
+                if constexpr (kTracing || introspection::kEnabled)
+                {
+                    /* Name it "read" rather than "&io_uring_prep_read". */
+                    constexpr std::string_view kPrefix = "&io_uring_prep_";
+                    if (_name.starts_with(kPrefix)) { _name.remove_prefix(kPrefix.size()); }
+
+                    tracing::instant(_name.data(), _cancel_token);
+                    introspection::relabel(event_address(_cancel_token->handle_), _name.data());
+                }
             }
             else
             {
+                _counters.sq_full_.add();
                 _cancel_token->result_ = -ENOMEM;
                 execute_event(_cancel_token->handle_);
             }
         }
 
-#define do_op(function, ...) do_op_impl<decltype(function), function>(__VA_ARGS__)
+        /**
+         * @brief A multishot recvmsg that selects its buffers from `_group`.
+         */
+        inline void
+        prep_recvmsg_select(
+            struct io_uring_sqe* _sqe,
+            int                  _fd,
+            struct msghdr*       _message,
+            unsigned             _flags,
+            std::uint16_t        _group) noexcept
+        {
+            io_uring_prep_recvmsg_multishot(_sqe, _fd, _message, _flags);
+            _sqe->flags |= IOSQE_BUFFER_SELECT;
+            _sqe->buf_group = _group;
+        }
+
+        inline std::uint64_t
+        now_ns() noexcept
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now().time_since_epoch())
+                .count();
+        }
+
+#define do_op(function, ...) \
+    do_op_impl<decltype(function), function>(counters_, #function, __VA_ARGS__)
     }   // namespace
 
     event_loop::event_loop() : ring_(std::make_unique<io_uring>()), use_space_handle_(nullptr) { }
@@ -156,7 +205,22 @@ namespace zab {
     void
     event_loop::submit_pending_events() noexcept
     {
-        io_uring_submit(ring_.get());
+        submit();
+    }
+
+    void
+    event_loop::submit() noexcept
+    {
+        auto ready = io_uring_sq_ready(ring_.get());
+        auto rc    = io_uring_submit(ring_.get());
+
+        ZAB_PROBE(loop_submit, ready, rc);
+
+        if (ready)
+        {
+            counters_.submit_syscalls_.add();
+            if (rc > 0) { counters_.sqes_submitted_.add(rc); }
+        }
     }
 
     void
@@ -325,6 +389,110 @@ namespace zab {
             _flags);
     }
 
+    void
+    event_loop::recv_msg(
+        io_event*      _cancel_token,
+        int            _sockfd,
+        struct msghdr* _message,
+        int            _flags) noexcept
+    {
+        return do_op(
+            &io_uring_prep_recvmsg,
+            _cancel_token,
+            ring_.get(),
+            _sockfd,
+            _message,
+            (unsigned) _flags);
+    }
+
+    void
+    event_loop::recv_msg_multishot(
+        io_event*      _cancel_token,
+        int            _sockfd,
+        struct msghdr* _message,
+        int            _flags,
+        std::uint16_t  _group) noexcept
+    {
+        return do_op_impl<decltype(&prep_recvmsg_select), &prep_recvmsg_select>(
+            counters_,
+            "recvmsg_multishot",
+            _cancel_token,
+            ring_.get(),
+            _sockfd,
+            _message,
+            (unsigned) _flags,
+            _group);
+    }
+
+    void
+    event_loop::send_msg(
+        io_event*            _cancel_token,
+        int                  _sockfd,
+        const struct msghdr* _message,
+        int                  _flags) noexcept
+    {
+        return do_op(
+            &io_uring_prep_sendmsg,
+            _cancel_token,
+            ring_.get(),
+            _sockfd,
+            _message,
+            (unsigned) _flags);
+    }
+
+    void
+    event_loop::splice(
+        io_event*    _cancel_token,
+        int          _fd_in,
+        std::int64_t _off_in,
+        int          _fd_out,
+        std::int64_t _off_out,
+        unsigned     _length,
+        unsigned     _flags) noexcept
+    {
+        return do_op(
+            &io_uring_prep_splice,
+            _cancel_token,
+            ring_.get(),
+            _fd_in,
+            _off_in,
+            _fd_out,
+            _off_out,
+            _length,
+            _flags);
+    }
+
+    void
+    event_loop::provide_buffers(
+        io_event*            _cancel_token,
+        std::span<std::byte> _buffers,
+        int                  _size,
+        int                  _count,
+        std::uint16_t        _group,
+        std::uint16_t        _first_id) noexcept
+    {
+        return do_op(
+            &io_uring_prep_provide_buffers,
+            _cancel_token,
+            ring_.get(),
+            (void*) _buffers.data(),
+            _size,
+            _count,
+            (int) _group,
+            (int) _first_id);
+    }
+
+    void
+    event_loop::remove_buffers(io_event* _cancel_token, int _count, std::uint16_t _group) noexcept
+    {
+        return do_op(
+            &io_uring_prep_remove_buffers,
+            _cancel_token,
+            ring_.get(),
+            _count,
+            (int) _group);
+    }
+
     void
     event_loop::accept(
         io_event*        _cancel_token,
@@ -359,6 +527,7 @@ namespace zab {
         auto* sqe = io_uring_get_sqe(ring_.get());
         if (!sqe) [[unlikely]]
         {
+            counters_.sq_full_.add();
             _cancel_token->result_ = -ENOMEM;
             execute_event(_cancel_token->handle_);
         }
@@ -366,6 +535,7 @@ namespace zab {
         {
             io_uring_prep_cancel(sqe, reinterpret_cast<std::uintptr_t>(_key), 0);
             io_uring_sqe_set_data(sqe, _cancel_token);
+            tracing::instant("cancel", _cancel_token);
         }
     }
 
@@ -384,14 +554,21 @@ namespace zab {
     void
     event_loop::wake(event_loop& _from) noexcept
     {
-        do_op(
-            &io_uring_prep_write,
-            (io_event*) nullptr,
+        auto& done   = _from.wake_event_;
+        done.result_ = 0;
+
+        do_op_impl<decltype(&io_uring_prep_write), &io_uring_prep_write>(
+            _from.counters_,
+            "wake",
+            &done,
             _from.ring_.get(),
             user_space_event_fd_,
             (const char*) &item,
             sizeof(item),
             0);
+
+        /* A full submission queue fails the write before it returns. */
+        if (done.result_ < 0) [[unlikely]] { wake(); }
     }
 
     void
@@ -407,31 +584,59 @@ namespace zab {
     void
     event_loop::dispatch_user_event(user_event _handle) noexcept
     {
-        bool notify = false;
+        std::uint64_t queued_at = track_latency_ ? now_ns() : 0;
+
+        bool        notify = false;
+        std::size_t depth  = 0;
         {
             std::scoped_lock lck(mtx_);
-            handles_[kWriteIndex].emplace_back(_handle);
-            notify = handles_[kWriteIndex].size() == 1;
+            handles_[kWriteIndex].emplace_back(queued_event{_handle, queued_at});
+            depth  = handles_[kWriteIndex].size();
+            notify = depth == 1;
             size_.fetch_add(1, std::memory_order_relaxed);
+
+            counters_.user_events_dispatched_.add();
+            if (notify && std::this_thread::get_id() != owner_.load(std::memory_order_relaxed))
+            {
+                counters_.cross_thread_wakes_.add();
+            }
         }
 
+        ZAB_PROBE(user_event, depth, static_cast<int>(notify));
+
         if (notify) { wake(); }
     }
 
     void
     event_loop::run(std::stop_token _st) noexcept
     {
+        using clock = std::chrono::steady_clock;
+
+        owner_.store(std::this_thread::get_id(), std::memory_order_relaxed);
+
         run_user_space(_st);
 
-        io_uring_submit(ring_.get());
+        submit();
 
         static constexpr auto kMaxBatch = 16;
         io_uring_cqe*         completions[kMaxBatch];
         io_event*             to_resume[kMaxBatch];
+        int                   results[kMaxBatch];
+        std::uint32_t         flags[kMaxBatch];
 
-        while (!_st.stop_requested() &&
-               !io_uring_wait_cqe(ring_.get(), (io_uring_cqe**) &completions))
+        auto busy_start = clock::now();
+        while (!_st.stop_requested())
         {
+            if (!io_uring_cq_ready(ring_.get())) { counters_.wait_syscalls_.add(); }
+
+            auto idle_start = clock::now();
+            counters_.busy_ns_.add((idle_start - busy_start).count());
+
+            if (io_uring_wait_cqe(ring_.get(), (io_uring_cqe**) &completions)) { break; }
+
+            busy_start = clock::now();
+            counters_.idle_ns_.add((busy_start - idle_start).count());
+
             std::uint32_t amount;
             while ((
                 amount =
@@ -441,20 +646,45 @@ namespace zab {
                 for (std::uint32_t i = 0; i < amount; ++i)
                 {
                     to_resume[i] = static_cast<io_event*>(io_uring_cqe_get_data(completions[i]));
-                    to_resume[i]->result_ = completions[i]->res;
+                    results[i]   = completions[i]->res;
+                    flags[i]     = completions[i]->flags;
                 }
 
                 io_uring_cq_advance(ring_.get(), amount);
+                counters_.cqes_reaped_.add(amount);
+                ZAB_PROBE(loop_reaped, amount);
+
+                std::uint64_t reaped_at = track_latency_ ? now_ns() : 0;
 
                 /* Resume them*/
                 for (std::uint32_t i = 0; i < amount; ++i)
                 {
+                    if (track_latency_) { completion_delay_.record(now_ns() - reaped_at); }
+
+                    /* A multishot event can appear more than once in a batch. */
+                    to_resume[i]->result_ = results[i];
+                    completion_flags_     = flags[i];
+
+                    tracing::instant("complete", to_resume[i], to_resume[i]->result_);
+
+                    if (monitor_steps_)
+                    {
+                        steps_.begin(event_address(to_resume[i]->handle_), now_ns());
+                    }
+
                     execute_event(to_resume[i]->handle_);
+
+                    if (monitor_steps_) { steps_.end(); }
+
+                    /* Do not leak an arena into unrelated events. */
+                    arena::install(nullptr);
                 }
 
-                io_uring_submit(ring_.get());
+                submit();
             }
         }
+
+        counters_.busy_ns_.add((clock::now() - busy_start).count());
     }
 
     async_function<>
@@ -469,10 +699,18 @@ namespace zab {
                 size_.store(0, std::memory_order_relaxed);
             }
 
-            for (auto handle : handles_[kReadIndex])
+            for (auto [handle, queued_at] : handles_[kReadIndex])
             {
+                if (track_latency_) { queue_delay_.record(now_ns() - queued_at); }
+
+                if (monitor_steps_) { steps_.begin(event_address(handle), now_ns()); }
+
                 execute_event(handle);
+                arena::install(nullptr);
+
+                if (monitor_steps_) { steps_.end(); }
             }
+            counters_.user_events_executed_.add(handles_[kReadIndex].size());
             handles_[kReadIndex].clear();
 
             auto result = co_await read(
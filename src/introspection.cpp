@@ -0,0 +1,261 @@
+/*
+ *  MMM"""AMV       db      `7MM"""Yp,
+ *  M'   AMV       ;MM:       MM    Yb
+ *  '   AMV       ,V^MM.      MM    dP
+ *     AMV       ,M  `MM      MM"""bg.
+ *    AMV   ,    AbmmmqMA     MM    `Y
+ *   AMV   ,M   A'     VML    MM    ,9
+ *  AMVmmmmMM .AMA.   .AMMA..JMMmmmd9
+ *
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021 Donald-Rupin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ *  @file introspection.cpp
+ *
+ */
+
+#include "zab/introspection.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+
+#include "zab/engine.hpp"
+#include "zab/signal_handler.hpp"
+#include "zab/spin_lock.hpp"
+
+namespace zab::introspection {
+
+    namespace {
+
+        struct entry {
+                const char*          kind_;
+                const void*          object_;
+                std::uint64_t        since_;
+                std::source_location location_;
+        };
+
+        /**
+         * @brief Waits are spread over shards so that loops registering at the same time rarely
+         *        contend.
+         */
+        struct shard {
+                spin_lock                              lock_;
+                std::unordered_map<const void*, entry> waits_;
+        };
+
+        static constexpr std::size_t kShards = 64;
+
+        std::array<shard, kShards>&
+        get_shards() noexcept
+        {
+            static std::array<shard, kShards> shards;
+            return shards;
+        }
+
+        inline shard&
+        shard_for(const void* _waiter) noexcept
+        {
+            /* Coroutine frames are at least 16 byte aligned. */
+            return get_shards()[(reinterpret_cast<std::uintptr_t>(_waiter) >> 4) % kShards];
+        }
+
+        inline std::uint64_t
+        now_ns() noexcept
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now().time_since_epoch())
+                .count();
+        }
+
+    }   // namespace
+
+    namespace details {
+
+        void
+        begin(
+            const void*                 _waiter,
+            const char*                 _kind,
+            const void*                 _object,
+            const std::source_location& _location) noexcept
+        {
+            auto& s = shard_for(_waiter);
+
+            std::scoped_lock lck(s.lock_);
+            s.waits_.insert_or_assign(
+                _waiter,
+                entry{
+                    .kind_     = _kind,
+                    .object_   = _object,
+                    .since_    = now_ns(),
+                    .location_ = _location});
+        }
+
+        void
+        relabel(const void* _waiter, const char* _kind, const void* _object) noexcept
+        {
+            auto& s = shard_for(_waiter);
+
+            std::scoped_lock lck(s.lock_);
+            if (auto it = s.waits_.find(_waiter); it != s.waits_.end())
+            {
+                it->second.kind_   = _kind;
+                it->second.object_ = _object;
+            }
+        }
+
+        void
+        end(const void* _waiter) noexcept
+        {
+            auto& s = shard_for(_waiter);
+
+            std::unique_lock lck(s.lock_);
+            auto             it = s.waits_.find(_waiter);
+            if (it == s.waits_.end()) { return; }
+
+            auto finished = it->second;
+            s.waits_.erase(it);
+            lck.unlock();
+
+            if constexpr (kProfiling)
+            {
+                auto now = now_ns();
+                profiler::details::record(
+                    finished.kind_,
+                    finished.location_,
+                    now > finished.since_ ? now - finished.since_ : 0);
+            }
+        }
+
+    }   // namespace details
+
+    std::size_t
+    waiting() noexcept
+    {
+        std::size_t total = 0;
+        for (auto& s : get_shards())
+        {
+            std::scoped_lock lck(s.lock_);
+            total += s.waits_.size();
+        }
+
+        return total;
+    }
+
+    std::vector<wait_group>
+    snapshot(std::chrono::nanoseconds _threshold)
+    {
+        std::map<std::pair<std::string_view, const void*>, wait_group> groups;
+
+        auto now = now_ns();
+        for (auto& s : get_shards())
+        {
+            std::scoped_lock lck(s.lock_);
+            for (const auto& [_, e] : s.waits_)
+            {
+                auto age = std::chrono::nanoseconds(now > e.since_ ? now - e.since_ : 0);
+
+                auto [it, inserted] = groups.try_emplace(
+                    std::make_pair(std::string_view(e.kind_), e.object_),
+                    wait_group{
+                        .kind_           = e.kind_,
+                        .object_         = e.object_,
+                        .count_          = 0,
+                        .over_threshold_ = 0,
+                        .oldest_         = std::chrono::nanoseconds(0)});
+
+                auto& group = it->second;
+                ++group.count_;
+                if (age > _threshold) { ++group.over_threshold_; }
+                group.oldest_ = std::max(group.oldest_, age);
+            }
+        }
+
+        std::vector<wait_group> result;
+        result.reserve(groups.size());
+        for (auto& [_, group] : groups)
+        {
+            result.push_back(group);
+        }
+
+        std::stable_sort(
+            result.begin(),
+            result.end(),
+            [](const auto& _lhs, const auto& _rhs) { return _lhs.count_ > _rhs.count_; });
+
+        return result;
+    }
+
+    void
+    dump(std::ostream& _out, std::chrono::nanoseconds _threshold)
+    {
+        auto groups = snapshot(_threshold);
+
+        std::size_t total = 0;
+        for (const auto& group : groups)
+        {
+            total += group.count_;
+        }
+
+        auto as_ms = [](std::chrono::nanoseconds _ns)
+        { return std::chrono::duration_cast<std::chrono::milliseconds>(_ns).count(); };
+
+        _out << "zab::introspection " << total << " suspended\n";
+        for (const auto& group : groups)
+        {
+            _out << "    " << group.count_ << " on " << group.kind_;
+            if (group.object_) { _out << " " << group.object_; }
+
+            _out << ", " << group.over_threshold_ << " for >" << as_ms(_threshold)
+                 << "ms, oldest " << as_ms(group.oldest_) << "ms\n";
+        }
+
+        _out.flush();
+    }
+
+    bool
+    dump_on_signal(
+        engine*                  _engine,
+        int                      _signal,
+        std::ostream&            _out,
+        std::chrono::nanoseconds _threshold)
+    {
+        return _engine->get_signal_handler().handle(
+            _signal,
+            signal_handler::kSignalThread,
+            [&_out, _threshold](int) noexcept { dump(_out, _threshold); });
+    }
+
+    bool
+    dump_on_signal(engine* _engine, int _signal)
+    {
+        return dump_on_signal(_engine, _signal, std::cerr);
+    }
+
+}   // namespace zab::introspection
@@ -0,0 +1,243 @@
+/*
+ *  MMM"""AMV       db      `7MM"""Yp,
+ *  M'   AMV       ;MM:       MM    Yb
+ *  '   AMV       ,V^MM.      MM    dP
+ *     AMV       ,M  `MM      MM"""bg.
+ *    AMV   ,    AbmmmqMA     MM    `Y
+ *   AMV   ,M   A'     VML    MM    ,9
+ *  AMVmmmmMM .AMA.   .AMMA..JMMmmmd9
+ *
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021 Donald-Rupin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ *  @file profiler.cpp
+ *
+ */
+
+#include "zab/profiler.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <sstream>
+#include <string_view>
+#include <tuple>
+#include <unordered_map>
+
+namespace zab::profiler {
+
+    namespace {
+
+        struct site_key {
+                const char*         kind_;
+                const char*         file_;
+                std::uint_least32_t line_;
+                std::uint_least32_t column_;
+
+                bool
+                operator==(const site_key&) const noexcept = default;
+        };
+
+        struct site_hash {
+                std::size_t
+                operator()(const site_key& _key) const noexcept
+                {
+                    auto h = std::hash<const void*>{}(_key.kind_);
+                    h ^= std::hash<const void*>{}(_key.file_) + 0x9e3779b9 + (h << 6) + (h >> 2);
+                    h ^= (std::size_t(_key.line_) << 16 | _key.column_) + 0x9e3779b9 + (h << 6) +
+                         (h >> 2);
+                    return h;
+                }
+        };
+
+        struct site_entry {
+                const char*       function_;
+                latency_histogram suspended_;
+        };
+
+        /**
+         * @brief The sites recorded by one thread. Only that thread inserts, the lock is only
+         *        contended while merging.
+         */
+        struct table {
+                std::mutex                                                           mtx_;
+                std::unordered_map<site_key, std::unique_ptr<site_entry>, site_hash> sites_;
+        };
+
+        struct registry {
+                std::mutex                          mtx_;
+                std::vector<std::shared_ptr<table>> tables_;
+        };
+
+        registry&
+        get_registry() noexcept
+        {
+            static registry reg;
+            return reg;
+        }
+
+        thread_local std::shared_ptr<table> local_table;
+
+        table&
+        this_table() noexcept
+        {
+            if (!local_table) [[unlikely]]
+            {
+                local_table = std::make_shared<table>();
+
+                auto&            reg = get_registry();
+                std::scoped_lock lck(reg.mtx_);
+                reg.tables_.push_back(local_table);
+            }
+
+            return *local_table;
+        }
+
+    }   // namespace
+
+    namespace details {
+
+        void
+        record(
+            const char*                 _kind,
+            const std::source_location& _location,
+            std::uint64_t               _nanoseconds) noexcept
+        {
+            auto& t = this_table();
+
+            site_key key{
+                .kind_   = _kind,
+                .file_   = _location.file_name(),
+                .line_   = _location.line(),
+                .column_ = _location.column()};
+
+            std::scoped_lock lck(t.mtx_);
+
+            auto& entry = t.sites_[key];
+            if (!entry)
+            {
+                entry            = std::make_unique<site_entry>();
+                entry->function_ = _location.function_name();
+            }
+
+            entry->suspended_.record(_nanoseconds);
+        }
+
+    }   // namespace details
+
+    std::vector<site_profile>
+    merge()
+    {
+        using merge_key =
+            std::tuple<std::string_view, std::string_view, std::uint_least32_t, std::uint_least32_t>;
+
+        std::map<merge_key, site_profile> merged;
+
+        std::vector<std::shared_ptr<table>> tables;
+        {
+            auto&            reg = get_registry();
+            std::scoped_lock lck(reg.mtx_);
+            tables = reg.tables_;
+        }
+
+        for (auto& t : tables)
+        {
+            std::scoped_lock lck(t->mtx_);
+            for (const auto& [key, entry] : t->sites_)
+            {
+                auto [it, inserted] = merged.try_emplace(
+                    merge_key{key.kind_, key.file_, key.line_, key.column_},
+                    site_profile{
+                        .kind_      = key.kind_,
+                        .file_      = key.file_,
+                        .line_      = key.line_,
+                        .function_  = entry->function_,
+                        .suspended_ = {}});
+
+                it->second.suspended_ += entry->suspended_.snapshot();
+            }
+        }
+
+        std::vector<site_profile> result;
+        result.reserve(merged.size());
+        for (auto& [_, profile] : merged)
+        {
+            result.push_back(std::move(profile));
+        }
+
+        std::stable_sort(
+            result.begin(),
+            result.end(),
+            [](const auto& _lhs, const auto& _rhs) { return _lhs.total() > _rhs.total(); });
+
+        return result;
+    }
+
+    void
+    print(std::ostream& _out)
+    {
+        auto sites = merge();
+
+        auto as_us = [](std::chrono::nanoseconds _ns)
+        { return std::chrono::duration_cast<std::chrono::microseconds>(_ns).count(); };
+
+        _out << std::left << std::setw(20) << "kind" << std::right << std::setw(10) << "count"
+             << std::setw(14) << "total us" << std::setw(10) << "mean us" << std::setw(10)
+             << "p99 us" << std::setw(10) << "max us"
+             << "  site\n";
+
+        for (const auto& site : sites)
+        {
+            std::stringstream where;
+            if (site.line_) { where << site.file_ << ":" << site.line_ << " " << site.function_; }
+            else
+            {
+                where << "<unknown>";
+            }
+
+            _out << std::left << std::setw(20) << site.kind_ << std::right << std::setw(10)
+                 << site.suspended_.count() << std::setw(14) << as_us(site.total())
+                 << std::setw(10) << as_us(site.suspended_.mean()) << std::setw(10)
+                 << as_us(site.suspended_.percentile(99)) << std::setw(10)
+                 << as_us(site.suspended_.max()) << "  " << where.str() << "\n";
+        }
+
+        _out.flush();
+    }
+
+    void
+    reset() noexcept
+    {
+        auto&            reg = get_registry();
+        std::scoped_lock lck(reg.mtx_);
+        for (auto& t : reg.tables_)
+        {
+            std::scoped_lock table_lck(t->mtx_);
+            t->sites_.clear();
+        }
+    }
+
+}   // namespace zab::profiler
@@ -0,0 +1,151 @@
+/*
+ *  MMM"""AMV       db      `7MM"""Yp,
+ *  M'   AMV       ;MM:       MM    Yb
+ *  '   AMV       ,V^MM.      MM    dP
+ *     AMV       ,M  `MM      MM"""bg.
+ *    AMV   ,    AbmmmqMA     MM    `Y
+ *   AMV   ,M   A'     VML    MM    ,9
+ *  AMVmmmmMM .AMA.   .AMMA..JMMmmmd9
+ *
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021 Donald-Rupin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ *  @file socket_options.cpp
+ *
+ */
+
+#include "zab/socket_options.hpp"
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+/* Older libc headers lack it. */
+#ifndef SO_PREFER_BUSY_POLL
+#define SO_PREFER_BUSY_POLL 69
+#endif
+
+namespace zab::details {
+
+    namespace {
+
+        inline int
+        set(int _fd, int _level, int _name, const std::optional<int>& _value) noexcept
+        {
+            if (!_value) { return 0; }
+
+            int value = *_value;
+            return ::setsockopt(_fd, _level, _name, &value, sizeof(value)) ? errno : 0;
+        }
+
+        inline int
+        set(int _fd, int _level, int _name, const std::optional<bool>& _value) noexcept
+        {
+            if (!_value) { return 0; }
+
+            return set(_fd, _level, _name, std::optional<int>((int) *_value));
+        }
+
+    }   // namespace
+
+    int
+    apply_socket_options(int _fd, const socket_options& _options, bool _listener) noexcept
+    {
+        int error = 0;
+        if (_listener)
+        {
+            int reuse = _options.reuse_address_;
+            if (::setsockopt(_fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse))) [[unlikely]]
+            {
+                return errno;
+            }
+
+            if ((error = set(_fd, IPPROTO_TCP, TCP_DEFER_ACCEPT, _options.defer_accept_)) ||
+                (error = set(_fd, IPPROTO_TCP, TCP_FASTOPEN, _options.fast_open_))) [[unlikely]]
+            {
+                return error;
+            }
+        }
+        else if ((error = set(_fd, IPPROTO_TCP, TCP_QUICKACK, _options.quick_ack_))) [[unlikely]]
+        {
+            return error;
+        }
+
+        if ((error = set(_fd, IPPROTO_TCP, TCP_NODELAY, _options.no_delay_)) ||
+            (error = set(_fd, SOL_SOCKET, SO_BUSY_POLL, _options.busy_poll_)) ||
+            (error = set(_fd, SOL_SOCKET, SO_PREFER_BUSY_POLL, _options.prefer_busy_poll_)) ||
+            (error = set(_fd, SOL_SOCKET, SO_SNDBUF, _options.send_buffer_)) ||
+            (error = set(_fd, SOL_SOCKET, SO_RCVBUF, _options.receive_buffer_)) ||
+            (error = set(_fd, IPPROTO_TCP, TCP_NOTSENT_LOWAT, _options.not_sent_lowat_)) ||
+            (error = set(_fd, SOL_SOCKET, SO_INCOMING_CPU, _options.incoming_cpu_))) [[unlikely]]
+        {
+            return error;
+        }
+
+        return 0;
+    }
+
+    int
+    make_bind_address(
+        int                      _family,
+        std::uint16_t            _port,
+        const std::string&       _address,
+        struct sockaddr_storage& _out) noexcept
+    {
+        ::memset(&_out, 0, sizeof(_out));
+
+        if (_family == AF_INET)
+        {
+            struct sockaddr_in* in4 = (struct sockaddr_in*) &_out;
+            in4->sin_family         = AF_INET;
+            in4->sin_port           = ::htons(_port);
+            in4->sin_addr.s_addr    = INADDR_ANY;
+
+            if (_address.size() && ::inet_pton(AF_INET, _address.c_str(), &in4->sin_addr) != 1)
+            {
+                return EINVAL;
+            }
+        }
+        else if (_family == AF_INET6)
+        {
+            struct sockaddr_in6* in6 = (struct sockaddr_in6*) &_out;
+            in6->sin6_family         = AF_INET6;
+            in6->sin6_port           = ::htons(_port);
+            in6->sin6_addr           = in6addr_any;
+
+            if (_address.size() && ::inet_pton(AF_INET6, _address.c_str(), &in6->sin6_addr) != 1)
+            {
+                return EINVAL;
+            }
+        }
+        else
+        {
+            return EINVAL;
+        }
+
+        return 0;
+    }
+
+}   // namespace zab::details
@@ -0,0 +1,256 @@
+/*
+ *  MMM"""AMV       db      `7MM"""Yp,
+ *  M'   AMV       ;MM:       MM    Yb
+ *  '   AMV       ,V^MM.      MM    dP
+ *     AMV       ,M  `MM      MM"""bg.
+ *    AMV   ,    AbmmmqMA     MM    `Y
+ *   AMV   ,M   A'     VML    MM    ,9
+ *  AMVmmmmMM .AMA.   .AMMA..JMMmmmd9
+ *
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021 Donald-Rupin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ *  @file splice.cpp
+ *
+ */
+
+#include "zab/splice.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "zab/event_loop.hpp"
+#include "zab/wait_for.hpp"
+
+namespace zab {
+
+    namespace {
+
+        /**
+         * @brief A pipe to splice through, closed when it goes out of scope.
+         */
+        class splice_pipe {
+
+            public:
+
+                explicit splice_pipe(std::size_t _size) noexcept
+                {
+                    int fds[2];
+                    if (::pipe2(fds, O_CLOEXEC)) [[unlikely]]
+                    {
+                        error_ = errno;
+                        return;
+                    }
+
+                    read_  = fds[0];
+                    write_ = fds[1];
+
+                    /* Asking for more than the system allows just leaves the default. */
+                    ::fcntl(write_, F_SETPIPE_SZ, (int) _size);
+                    auto size = ::fcntl(write_, F_GETPIPE_SZ);
+                    size_     = size > 0 ? (std::size_t) size : kSplicePipeSize;
+                }
+
+                splice_pipe(const splice_pipe&) = delete;
+
+                ~splice_pipe()
+                {
+                    if (read_ >= 0) { ::close(read_); }
+                    if (write_ >= 0) { ::close(write_); }
+                }
+
+                int         read_  = -1;
+                int         write_ = -1;
+                std::size_t size_  = 0;
+                int         error_ = 0;
+        };
+
+        struct direction {
+
+                long long bytes_     = 0;
+                int       error_     = 0;
+                bool      to_failed_ = false;
+        };
+
+        /**
+         * @brief Move `_amount` that is sitting in `_pipe` on to `_to`, adding what was moved to
+         *        `_moved`.
+         *
+         * @co_return int 0 or the errno of the failure.
+         */
+        guaranteed_future<int>
+        drain(
+            event_loop&        _loop,
+            const splice_pipe& _pipe,
+            int                _to,
+            long long          _amount,
+            long long&         _moved)
+        {
+            while (_amount)
+            {
+                auto moved = co_await _loop.splice(
+                    _pipe.read_,
+                    -1,
+                    _to,
+                    -1,
+                    (unsigned) _amount,
+                    SPLICE_F_MOVE);
+
+                /* Nothing written to a socket means it can take no more. */
+                if (moved <= 0) [[unlikely]] { co_return moved ? -moved : EPIPE; }
+
+                _amount -= moved;
+                _moved += moved;
+            }
+
+            co_return 0;
+        }
+
+        /**
+         * @brief Relay one way from `_from` to `_to` until `_from` ends or either fails.
+         */
+        guaranteed_future<direction>
+        relay(engine* _engine, int _from, int _to, std::size_t _pipe_size)
+        {
+            auto& loop = _engine->get_event_loop();
+
+            direction   result;
+            splice_pipe pipe(_pipe_size);
+            result.error_ = pipe.error_;
+
+            while (!result.error_)
+            {
+                auto filled = co_await loop.splice(
+                    _from,
+                    -1,
+                    pipe.write_,
+                    -1,
+                    (unsigned) pipe.size_,
+                    SPLICE_F_MOVE);
+
+                if (filled <= 0)
+                {
+                    result.error_ = -filled;
+                    break;
+                }
+
+                result.error_     = co_await drain(loop, pipe, _to, filled, result.bytes_);
+                result.to_failed_ = result.error_;
+            }
+
+            if (!result.error_) { ::shutdown(_to, SHUT_WR); }
+            else
+            {
+                /* Wake the other direction so the relay as a whole ends. */
+                ::shutdown(_from, SHUT_RDWR);
+                ::shutdown(_to, SHUT_RDWR);
+            }
+
+            co_return result;
+        }
+
+    }   // namespace
+
+    namespace details {
+
+        guaranteed_future<splice_result>
+        splice_descriptors(
+            engine*     _engine,
+            int         _first,
+            int         _second,
+            std::size_t _pipe_size,
+            int&        _first_error,
+            int&        _second_error)
+        {
+            auto [forward, backward] = co_await wait_for(
+                relay(_engine, _first, _second, _pipe_size),
+                relay(_engine, _second, _first, _pipe_size));
+
+            if (forward.error_) [[unlikely]]
+            {
+                (forward.to_failed_ ? _second_error : _first_error) = forward.error_;
+            }
+
+            if (backward.error_) [[unlikely]]
+            {
+                auto& error = backward.to_failed_ ? _first_error : _second_error;
+                if (!error) { error = backward.error_; }
+            }
+
+            co_return splice_result{
+                .to_second_ = forward.bytes_,
+                .to_first_  = backward.bytes_,
+                .error_     = forward.error_ ? forward.error_ : backward.error_};
+        }
+
+        guaranteed_future<long long>
+        send_descriptor(
+            engine*     _engine,
+            int         _file,
+            int         _socket,
+            std::size_t _offset,
+            std::size_t _length,
+            std::size_t _pipe_size,
+            int&        _error)
+        {
+            auto& loop = _engine->get_event_loop();
+
+            long long   sent = 0;
+            splice_pipe pipe(_pipe_size);
+            _error = pipe.error_;
+
+            while (!_error && (std::size_t) sent < _length)
+            {
+                auto chunk  = std::min<std::size_t>(pipe.size_, _length - sent);
+                auto filled = co_await loop.splice(
+                    _file,
+                    (std::int64_t) (_offset + sent),
+                    pipe.write_,
+                    -1,
+                    (unsigned) chunk,
+                    SPLICE_F_MOVE);
+
+                /* The file ended early. */
+                if (!filled) { break; }
+
+                if (filled < 0) [[unlikely]]
+                {
+                    _error = -filled;
+                    break;
+                }
+
+                _error = co_await drain(loop, pipe, _socket, filled, sent);
+            }
+
+            if (_error && !sent) [[unlikely]] { co_return -1ll; }
+
+            co_return sent;
+        }
+    }   // namespace details
+
+}   // namespace zab
@@ -39,9 +39,11 @@
 
 #include <cstdint>
 #include <cstring>
+#include <linux/filter.h>
 #include <netinet/in.h>
 #include <sys/socket.h>
 #include <unistd.h>
+#include <vector>
 
 #include "zab/event_loop.hpp"
 #include "zab/first_of.hpp"
@@ -56,10 +58,15 @@ namespace zab {
     {
         using std::swap;
         swap(static_cast<network_operation&>(_first), static_cast<network_operation&>(_second));
+        swap(_first.inherited_, _second.inherited_);
     }
 
     bool
-    tcp_acceptor::listen(int _family, std::uint16_t _port, int _backlog) noexcept
+    tcp_acceptor::listen(
+        int                   _family,
+        std::uint16_t         _port,
+        int                   _backlog,
+        const socket_options& _options) noexcept
     {
         if (descriptor() < 0)
         {
@@ -74,36 +81,17 @@ namespace zab {
             set_descriptor(acc);
         }
 
-        unsigned long on = 1;
-        if (::setsockopt(descriptor(), SOL_SOCKET, SO_REUSEADDR, (char*) &on, sizeof(on)) != 0)
-            [[unlikely]]
+        if (auto error = details::apply_socket_options(descriptor(), _options, true)) [[unlikely]]
         {
-            set_error(errno);
+            set_error(error);
             return false;
         }
 
-        _port = ::htons(_port);
-
         struct sockaddr_storage add;
-        ::memset(&add, 0, sizeof(add));
-
-        if (_family == AF_INET)
-        {
-            struct sockaddr_in* in4 = (struct sockaddr_in*) &add;
-            in4->sin_family         = AF_INET;
-            in4->sin_port           = _port;
-            in4->sin_addr.s_addr    = INADDR_ANY;
-        }
-        else if (_family == AF_INET6)
-        {
-            struct sockaddr_in6* in6 = (struct sockaddr_in6*) &add;
-            in6->sin6_family         = AF_INET6;
-            in6->sin6_port           = _port;
-            in6->sin6_addr           = in6addr_any;
-        }
-        else
+        if (auto error = details::make_bind_address(_family, _port, _options.bind_address_, add))
+            [[unlikely]]
         {
-            set_error(EINVAL);
+            set_error(error);
             return false;
         }
 
@@ -119,7 +107,190 @@ namespace zab {
             return false;
         }
 
+        if (_options.inherit_) { inherited_ = _options; }
+        else
+        {
+            inherited_.reset();
+        }
+
+        return true;
+    }
+
+    int
+    tcp_acceptor::inherit(int _fd) noexcept
+    {
+        if (!inherited_) { return 0; }
+
+        auto error = details::apply_socket_options(_fd, *inherited_, false);
+        if (error) [[unlikely]] { ::close(_fd); }
+
+        return error;
+    }
+
+    namespace {
+
+        /**
+         * @brief Close the sockets of a failed listen without needing an event loop.
+         */
+        void
+        abandon(std::vector<tcp_acceptor>& _shards) noexcept
+        {
+            for (auto& shard : _shards)
+            {
+                if (shard.descriptor() >= 0)
+                {
+                    ::close(shard.descriptor());
+                    shard.clear_descriptor();
+                }
+            }
+
+            _shards.clear();
+        }
+
+        /**
+         * @brief Return the index of the shard whose worker is on the current cpu. Out of range
+         *        indexes make the kernel fall back to hashing.
+         */
+        bool
+        attach_cpu_program(engine* _engine, int _sd, std::uint16_t _shards) noexcept
+        {
+            std::vector<struct sock_filter> code;
+            code.push_back(
+                BPF_STMT(BPF_LD | BPF_W | BPF_ABS, (std::uint32_t) (SKF_AD_OFF + SKF_AD_CPU)));
+
+            for (std::uint16_t i = 0; i < _shards; ++i)
+            {
+                code.push_back(
+                    BPF_JUMP(
+                        BPF_JMP | BPF_JEQ | BPF_K,
+                        (std::uint32_t) _engine->worker_cpu(thread_t{i}),
+                        0,
+                        1));
+                code.push_back(BPF_STMT(BPF_RET | BPF_K, i));
+            }
+
+            code.push_back(BPF_STMT(BPF_RET | BPF_K, 0xffffffff));
+
+            struct sock_fprog program;
+            program.len    = (unsigned short) code.size();
+            program.filter = code.data();
+
+            return ::setsockopt(
+                       _sd,
+                       SOL_SOCKET,
+                       SO_ATTACH_REUSEPORT_CBPF,
+                       &program,
+                       sizeof(program)) == 0;
+        }
+
+    }   // namespace
+
+    sharded_acceptor::sharded_acceptor(engine* _engine) : engine_(_engine) { }
+
+    bool
+    sharded_acceptor::listen(
+        int                   _family,
+        std::uint16_t         _port,
+        int                   _backlog,
+        steering              _steering,
+        const socket_options& _options) noexcept
+    {
+        const auto workers = engine_->number_of_workers();
+
+        std::vector<tcp_acceptor> shards;
+        shards.reserve(workers);
+
+        auto options = _options;
+        if (_steering == steering::kIncomingCpu) { options.incoming_cpu_.reset(); }
+
+        /* Sockets join the reuseport group in the order they listen, so shard i is index i. */
+        for (std::uint16_t i = 0; i < workers; ++i)
+        {
+            auto& shard = shards.emplace_back(engine_);
+
+            auto sd = ::socket(_family, SOCK_STREAM | SOCK_CLOEXEC, 0);
+            if (sd < 0) [[unlikely]]
+            {
+                last_error_ = errno;
+                abandon(shards);
+                return false;
+            }
+
+            shard.set_descriptor(sd);
+
+            int on = 1;
+            if (::setsockopt(sd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on)) != 0) [[unlikely]]
+            {
+                last_error_ = errno;
+                abandon(shards);
+                return false;
+            }
+
+            if (_steering == steering::kIncomingCpu)
+            {
+                int cpu = engine_->worker_cpu(thread_t{i});
+                if (::setsockopt(sd, SOL_SOCKET, SO_INCOMING_CPU, &cpu, sizeof(cpu)) != 0)
+                    [[unlikely]]
+                {
+                    last_error_ = errno;
+                    abandon(shards);
+                    return false;
+                }
+            }
+
+            if (!shard.listen(_family, _port, _backlog, options)) [[unlikely]]
+            {
+                last_error_ = shard.last_error();
+                abandon(shards);
+                return false;
+            }
+
+            if (!_port)
+            {
+                struct sockaddr_storage add;
+                socklen_t               length = sizeof(add);
+                if (::getsockname(sd, (struct sockaddr*) &add, &length) != 0) [[unlikely]]
+                {
+                    last_error_ = errno;
+                    abandon(shards);
+                    return false;
+                }
+
+                _port = ::ntohs(
+                    _family == AF_INET ? ((struct sockaddr_in*) &add)->sin_port
+                                       : ((struct sockaddr_in6*) &add)->sin6_port);
+            }
+        }
+
+        if (_steering == steering::kCpuProgram &&
+            !attach_cpu_program(engine_, shards.front().descriptor(), workers)) [[unlikely]]
+        {
+            last_error_ = errno;
+            abandon(shards);
+            return false;
+        }
+
+        shards_ = std::move(shards);
+        port_   = _port;
+
         return true;
     }
 
+    simple_future<>
+    sharded_acceptor::close() noexcept
+    {
+        auto home = engine_->current_id();
+
+        for (std::uint16_t i = 0; i < shards_.size(); ++i)
+        {
+            co_await yield(engine_, thread_t{i});
+
+            if (shards_[i].get_cancel()) { co_await shards_[i].cancel(); }
+
+            co_await shards_[i].close();
+        }
+
+        co_await yield(engine_, home);
+    }
+
 }   // namespace zab
@@ -43,6 +43,8 @@
 #include "zab/engine.hpp"
 #include "zab/event.hpp"
 #include "zab/event_loop.hpp"
+#include "zab/introspection.hpp"
+#include "zab/probes.hpp"
 #include "zab/yield.hpp"
 
 namespace zab {
@@ -127,6 +129,9 @@ namespace zab {
                             engine_->thread_resume(handle, thread);
                         }
 
+                        engine_->get_event_loop().count_timer_fires(it->second.size());
+                        ZAB_PROBE(timer_fire, it->second.size(), current_);
+
                         it = waiting_.erase(it);
                     }
 
@@ -137,6 +142,7 @@ namespace zab {
                         ::memset((char*) &new_value, 0, sizeof(new_value));
 
                         /* disarm timer */
+                        ZAB_PROBE(timer_rearm, 0);
                         auto rc = timerfd_settime(
                             timer_fd_,
                             0, /* relative */
@@ -167,6 +173,8 @@ namespace zab {
     void
     timer_service::change_timer(std::uint64_t _nano_seconds) noexcept
     {
+        ZAB_PROBE(timer_rearm, _nano_seconds);
+
         struct itimerspec new_value;
 
         new_value.it_value.tv_sec  = _nano_seconds / kNanoInSeconds;
@@ -199,6 +207,8 @@ namespace zab {
         std::uint64_t _nano_seconds,
         thread_t      _thread) noexcept
     {
+        introspection::relabel(event_address(_handle), "timer", this);
+
         const std::uint64_t sleep_mark = current_ + _nano_seconds;
 
         bool change_rate = false;
@@ -208,7 +218,7 @@ namespace zab {
         {
             auto [_it_, _s_] = waiting_.emplace(
                 sleep_mark,
-                std::vector<std::pair<tagged_event, thread_t>>{{_handle, engine_->current_id()}});
+                std::vector<std::pair<tagged_event, thread_t>>{{_handle, _thread}});
 
             if (_it_ == waiting_.begin()) { change_rate = true; }
         }
@@ -0,0 +1,335 @@
+/*
+ *  MMM"""AMV       db      `7MM"""Yp,
+ *  M'   AMV       ;MM:       MM    Yb
+ *  '   AMV       ,V^MM.      MM    dP
+ *     AMV       ,M  `MM      MM"""bg.
+ *    AMV   ,    AbmmmqMA     MM    `Y
+ *   AMV   ,M   A'     VML    MM    ,9
+ *  AMVmmmmMM .AMA.   .AMMA..JMMmmmd9
+ *
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021 Donald-Rupin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ *  @file topology.cpp
+ *
+ */
+
+#include "zab/topology.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <climits>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <linux/mempolicy.h>
+#include <map>
+#include <sched.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <thread>
+#include <tuple>
+#include <unistd.h>
+#include <utility>
+
+namespace zab {
+
+    namespace {
+
+        constexpr std::string_view kCpuPath  = "/sys/devices/system/cpu/";
+        constexpr std::string_view kNodePath = "/sys/devices/system/node/";
+
+        std::string
+        read_line(const std::string& _path) noexcept
+        {
+            std::ifstream file(_path);
+            std::string   line;
+            std::getline(file, line);
+            return line;
+        }
+
+        std::optional<std::uint16_t>
+        read_id(const std::string& _path) noexcept
+        {
+            auto          line  = read_line(_path);
+            std::uint16_t value = 0;
+            auto [ptr, ec]      = std::from_chars(line.data(), line.data() + line.size(), value);
+            if (ec != std::errc{} || ptr == line.data()) { return std::nullopt; }
+
+            return value;
+        }
+
+        std::vector<std::uint16_t>
+        allowed_cpus() noexcept
+        {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            if (::sched_getaffinity(0, sizeof(set), &set)) { return {}; }
+
+            std::vector<std::uint16_t> result;
+            for (std::uint16_t cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+            {
+                if (CPU_ISSET(cpu, &set)) { result.push_back(cpu); }
+            }
+
+            return result;
+        }
+
+        std::vector<unsigned long>
+        node_mask(std::uint16_t _node) noexcept
+        {
+            static constexpr auto      kBits = sizeof(unsigned long) * CHAR_BIT;
+            std::vector<unsigned long> mask(_node / kBits + 1, 0);
+            mask[_node / kBits] |= 1ul << (_node % kBits);
+            return mask;
+        }
+
+        unsigned long
+        max_node(const std::vector<unsigned long>& _mask) noexcept
+        {
+            /* The kernel reads one bit less than it is told to. */
+            return _mask.size() * sizeof(unsigned long) * CHAR_BIT + 1;
+        }
+
+    }   // namespace
+
+    topology::topology(std::vector<cpu_info> _cpus) noexcept : cpus_(std::move(_cpus)), nodes_(1)
+    {
+        std::sort(
+            cpus_.begin(),
+            cpus_.end(),
+            [](const auto& _lhs, const auto& _rhs) { return _lhs.cpu_ < _rhs.cpu_; });
+
+        /* Rank hardware threads within their core. */
+        std::map<std::pair<std::uint16_t, std::uint16_t>, std::uint16_t> siblings;
+        for (auto& c : cpus_)
+        {
+            c.smt_ = siblings[{c.package_, c.core_}]++;
+            nodes_ = std::max<std::uint16_t>(nodes_, c.node_ + 1);
+        }
+    }
+
+    topology
+    topology::discover() noexcept
+    {
+        auto online  = parse_cpu_list(read_line(std::string(kCpuPath) + "online"));
+        auto allowed = allowed_cpus();
+
+        /* Leave out cpus a taskset, cpuset or container has taken away from the process. */
+        if (online.empty()) { online = std::move(allowed); }
+        else if (!allowed.empty())
+        {
+            std::vector<std::uint16_t> usable;
+            std::set_intersection(
+                online.begin(),
+                online.end(),
+                allowed.begin(),
+                allowed.end(),
+                std::back_inserter(usable));
+
+            if (!usable.empty()) { online = std::move(usable); }
+        }
+
+        if (online.empty())
+        {
+            auto count = std::max(1u, std::thread::hardware_concurrency());
+            for (std::uint16_t i = 0; i < count; ++i)
+            {
+                online.push_back(i);
+            }
+        }
+
+        std::vector<cpu_info> cpus;
+        cpus.reserve(online.size());
+        for (auto cpu : online)
+        {
+            auto base = std::string(kCpuPath) + "cpu" + std::to_string(cpu) + "/topology/";
+
+            cpus.push_back(cpu_info{
+                .cpu_     = cpu,
+                .core_    = read_id(base + "core_id").value_or(cpu),
+                .package_ = read_id(base + "physical_package_id").value_or(0),
+                .node_    = 0,
+                .smt_     = 0});
+        }
+
+        std::error_code ec;
+        for (const auto& entry : std::filesystem::directory_iterator(kNodePath, ec))
+        {
+            auto name = entry.path().filename().string();
+            if (!name.starts_with("node")) { continue; }
+
+            std::uint16_t node = 0;
+            auto [ptr, err] = std::from_chars(name.data() + 4, name.data() + name.size(), node);
+            if (err != std::errc{} || ptr != name.data() + name.size()) { continue; }
+
+            for (auto cpu : parse_cpu_list(read_line(entry.path().string() + "/cpulist")))
+            {
+                auto it = std::find_if(
+                    cpus.begin(),
+                    cpus.end(),
+                    [cpu](const auto& _info) { return _info.cpu_ == cpu; });
+
+                if (it != cpus.end()) { it->node_ = node; }
+            }
+        }
+
+        return topology(std::move(cpus));
+    }
+
+    std::vector<std::uint16_t>
+    topology::parse_cpu_list(std::string_view _list) noexcept
+    {
+        std::vector<std::uint16_t> result;
+
+        while (!_list.empty() && (_list.back() == '\n' || _list.back() == ' '))
+        {
+            _list.remove_suffix(1);
+        }
+
+        while (!_list.empty())
+        {
+            auto comma = _list.find(',');
+            auto range = _list.substr(0, comma);
+            _list      = comma == std::string_view::npos ? std::string_view{}
+                                                         : _list.substr(comma + 1);
+
+            std::uint16_t first = 0;
+            auto [ptr, ec]      = std::from_chars(range.data(), range.data() + range.size(), first);
+            if (ec != std::errc{} || ptr == range.data()) { return {}; }
+
+            std::uint16_t last = first;
+            if (ptr != range.data() + range.size())
+            {
+                if (*ptr != '-') { return {}; }
+
+                auto [end, ec2] = std::from_chars(ptr + 1, range.data() + range.size(), last);
+                if (ec2 != std::errc{} || end != range.data() + range.size() || last < first)
+                {
+                    return {};
+                }
+            }
+
+            for (std::uint32_t i = first; i <= last; ++i)
+            {
+                result.push_back(i);
+            }
+        }
+
+        return result;
+    }
+
+    std::optional<cpu_info>
+    topology::find(std::uint16_t _cpu) const noexcept
+    {
+        auto it = std::lower_bound(
+            cpus_.begin(),
+            cpus_.end(),
+            _cpu,
+            [](const auto& _info, std::uint16_t _id) { return _info.cpu_ < _id; });
+
+        if (it == cpus_.end() || it->cpu_ != _cpu) { return std::nullopt; }
+
+        return *it;
+    }
+
+    std::vector<std::uint16_t>
+    topology::placement() const noexcept
+    {
+        auto ordered = cpus_;
+        std::stable_sort(
+            ordered.begin(),
+            ordered.end(),
+            [](const auto& _lhs, const auto& _rhs)
+            {
+                return std::tie(_lhs.smt_, _lhs.node_, _lhs.package_, _lhs.core_) <
+                       std::tie(_rhs.smt_, _rhs.node_, _rhs.package_, _rhs.core_);
+            });
+
+        std::vector<std::uint16_t> result;
+        result.reserve(ordered.size());
+        std::transform(
+            ordered.begin(),
+            ordered.end(),
+            std::back_inserter(result),
+            [](const auto& _info) { return _info.cpu_; });
+
+        return result;
+    }
+
+    numa_scope::numa_scope(std::uint16_t _node, std::uint16_t _number_of_nodes) noexcept
+        : applied_(false), previous_mode_(MPOL_DEFAULT), previous_mask_{}
+    {
+        if (_number_of_nodes <= 1) { return; }
+
+        /* Remember any policy set by the operator, such as `numactl --membind`, to restore. */
+        if (::syscall(
+                SYS_get_mempolicy,
+                &previous_mode_,
+                previous_mask_.data(),
+                previous_mask_.size() * sizeof(unsigned long) * CHAR_BIT,
+                nullptr,
+                0))
+        {
+            return;
+        }
+
+        auto mask = node_mask(_node);
+        applied_  = !::syscall(SYS_set_mempolicy, MPOL_PREFERRED, mask.data(), max_node(mask));
+    }
+
+    numa_scope::~numa_scope()
+    {
+        /* The saved mask is empty for MPOL_DEFAULT, which is what the kernel expects. */
+        if (applied_)
+        {
+            ::syscall(
+                SYS_set_mempolicy,
+                previous_mode_,
+                previous_mask_.data(),
+                previous_mask_.size() * sizeof(unsigned long) * CHAR_BIT + 1);
+        }
+    }
+
+    void*
+    numa_allocate(std::size_t _size, std::uint16_t _node) noexcept
+    {
+        void* ptr =
+            ::mmap(nullptr, _size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (ptr == MAP_FAILED) { return nullptr; }
+
+        /* Best effort, the memory is still usable if the kernel has no NUMA support. */
+        auto mask = node_mask(_node);
+        ::syscall(SYS_mbind, ptr, _size, MPOL_PREFERRED, mask.data(), max_node(mask), 0);
+
+        return ptr;
+    }
+
+    void
+    numa_deallocate(void* _ptr, std::size_t _size) noexcept
+    {
+        if (_ptr) { ::munmap(_ptr, _size); }
+    }
+
+}   // namespace zab
@@ -0,0 +1,312 @@
+/*
+ *  MMM"""AMV       db      `7MM"""Yp,
+ *  M'   AMV       ;MM:       MM    Yb
+ *  '   AMV       ,V^MM.      MM    dP
+ *     AMV       ,M  `MM      MM"""bg.
+ *    AMV   ,    AbmmmqMA     MM    `Y
+ *   AMV   ,M   A'     VML    MM    ,9
+ *  AMVmmmmMM .AMA.   .AMMA..JMMmmmd9
+ *
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021 Donald-Rupin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ *  @file tracing.cpp
+ *
+ */
+
+#include "zab/tracing.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+namespace zab::tracing {
+
+    namespace details {
+
+        std::atomic<bool> enabled_ = false;
+
+    }   // namespace details
+
+    namespace {
+
+        struct entry {
+                std::uint64_t timestamp_;
+                const char*   name_;
+                const void*   id_;
+                std::int64_t  value_;
+                details::kind kind_;
+        };
+
+        /**
+         * @brief A single producer ring of entries. Old entries are overwritten.
+         */
+        struct ring {
+
+                ring(std::size_t _capacity, long _tid)
+                    : entries_(_capacity), mask_(_capacity - 1), tid_(_tid)
+                { }
+
+                inline void
+                push(const entry& _entry) noexcept
+                {
+                    auto head              = head_.load(std::memory_order_relaxed);
+                    entries_[head & mask_] = _entry;
+                    head_.store(head + 1, std::memory_order_release);
+                }
+
+                std::vector<entry>         entries_;
+                std::size_t                mask_;
+                std::atomic<std::uint64_t> head_ = 0;
+                long                       tid_;
+                std::string                name_;
+        };
+
+        struct registry {
+                std::mutex                         mtx_;
+                std::vector<std::shared_ptr<ring>> rings_;
+                std::atomic<std::size_t>           capacity_ = kDefaultCapacity;
+        };
+
+        registry&
+        get_registry() noexcept
+        {
+            static registry reg;
+            return reg;
+        }
+
+        thread_local std::shared_ptr<ring> local_ring;
+        thread_local std::string           local_name;
+
+        ring&
+        this_ring() noexcept
+        {
+            if (!local_ring) [[unlikely]]
+            {
+                auto& reg = get_registry();
+                local_ring =
+                    std::make_shared<ring>(reg.capacity_.load(), (long) ::syscall(SYS_gettid));
+
+                std::scoped_lock lck(reg.mtx_);
+                local_ring->name_ = local_name;
+                reg.rings_.push_back(local_ring);
+            }
+
+            return *local_ring;
+        }
+
+        void
+        write_string(std::ostream& _out, std::string_view _str)
+        {
+            _out << '"';
+            for (char c : _str)
+            {
+                if (c == '"' || c == '\\') { _out << '\\' << c; }
+                else if ((unsigned char) c < 0x20) { _out << ' '; }
+                else
+                {
+                    _out << c;
+                }
+            }
+            _out << '"';
+        }
+
+        void
+        write_timestamp(std::ostream& _out, std::uint64_t _nanoseconds)
+        {
+            /* trace_event timestamps are in microseconds. */
+            _out << _nanoseconds / 1000 << '.' << std::setw(3) << std::setfill('0')
+                 << _nanoseconds % 1000;
+        }
+
+    }   // namespace
+
+    void
+    details::record(kind _kind, const char* _name, const void* _id, std::int64_t _value) noexcept
+    {
+        auto now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now().time_since_epoch())
+                       .count();
+
+        this_ring().push(entry{(std::uint64_t) now, _name, _id, _value, _kind});
+    }
+
+    void
+    enable(std::size_t _capacity) noexcept
+    {
+        get_registry().capacity_.store(std::bit_ceil(std::max<std::size_t>(_capacity, 2)));
+        details::enabled_.store(true, std::memory_order_relaxed);
+    }
+
+    void
+    disable() noexcept
+    {
+        details::enabled_.store(false, std::memory_order_relaxed);
+    }
+
+    void
+    clear() noexcept
+    {
+        auto&            reg = get_registry();
+        std::scoped_lock lck(reg.mtx_);
+        for (auto& r : reg.rings_)
+        {
+            r->head_.store(0, std::memory_order_release);
+        }
+    }
+
+    void
+    name_thread(std::string _name) noexcept
+    {
+        std::scoped_lock lck(get_registry().mtx_);
+        local_name = std::move(_name);
+        if (local_ring) { local_ring->name_ = local_name; }
+    }
+
+    void
+    dump(std::ostream& _out) noexcept
+    {
+        auto&                              reg = get_registry();
+        std::vector<std::shared_ptr<ring>> rings;
+        std::vector<std::string>           names;
+        {
+            std::scoped_lock lck(reg.mtx_);
+            rings = reg.rings_;
+            for (const auto& r : rings)
+            {
+                names.push_back(r->name_);
+            }
+        }
+
+        std::vector<std::pair<long, entry>> events;
+        for (const auto& r : rings)
+        {
+            auto head  = r->head_.load(std::memory_order_acquire);
+            auto count = std::min<std::uint64_t>(head, r->entries_.size());
+            for (auto i = head - count; i < head; ++i)
+            {
+                events.emplace_back(r->tid_, r->entries_[i & r->mask_]);
+            }
+        }
+
+        std::stable_sort(
+            events.begin(),
+            events.end(),
+            [](const auto& _lhs, const auto& _rhs)
+            { return _lhs.second.timestamp_ < _rhs.second.timestamp_; });
+
+        auto base = events.empty() ? 0 : events.front().second.timestamp_;
+        auto pid  = ::getpid();
+
+        bool first  = true;
+        auto header = [&](std::string_view _phase, long _tid, std::uint64_t _timestamp)
+        {
+            _out << (first ? "\n" : ",\n") << "{\"ph\":\"" << _phase << "\",\"pid\":" << pid
+                 << ",\"tid\":" << _tid << ",\"ts\":";
+            write_timestamp(_out, _timestamp - base);
+            first = false;
+        };
+
+        _out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+
+        for (std::size_t i = 0; i < rings.size(); ++i)
+        {
+            if (names[i].empty()) { continue; }
+
+            header("M", rings[i]->tid_, base);
+            _out << ",\"name\":\"thread_name\",\"args\":{\"name\":";
+            write_string(_out, names[i]);
+            _out << "}}";
+        }
+
+        /* The last resumption of each coroutine, to draw flows between threads. */
+        std::map<const void*, std::pair<long, std::uint64_t>> last_begin;
+        std::uint64_t                                         flow_id = 0;
+
+        for (const auto& [tid, e] : events)
+        {
+            switch (e.kind_)
+            {
+                case details::kind::kBegin:
+                {
+                    auto it = last_begin.find(e.id_);
+                    if (it != last_begin.end() && it->second.first != tid)
+                    {
+                        ++flow_id;
+                        header("s", it->second.first, it->second.second);
+                        _out << ",\"name\":\"hop\",\"cat\":\"zab\",\"id\":" << flow_id << "}";
+                        header("f", tid, e.timestamp_);
+                        _out << ",\"name\":\"hop\",\"cat\":\"zab\",\"bp\":\"e\",\"id\":"
+                             << flow_id << "}";
+                    }
+
+                    last_begin[e.id_] = {tid, e.timestamp_};
+
+                    header("B", tid, e.timestamp_);
+                    _out << ",\"name\":";
+                    write_string(_out, e.name_);
+                    _out << ",\"cat\":\"zab\",\"args\":{\"id\":\"" << e.id_ << "\"}}";
+                    break;
+                }
+                case details::kind::kEnd:
+                    header("E", tid, e.timestamp_);
+                    _out << "}";
+                    break;
+                case details::kind::kComplete:
+                    last_begin.erase(e.id_);
+                    [[fallthrough]];
+                case details::kind::kInstant:
+                    header("i", tid, e.timestamp_);
+                    _out << ",\"s\":\"t\",\"name\":";
+                    write_string(_out, e.name_);
+                    _out << ",\"cat\":\"zab\",\"args\":{\"id\":\"" << e.id_
+                         << "\",\"value\":" << e.value_ << "}}";
+                    break;
+            }
+        }
+
+        _out << "\n]}\n";
+        _out.flush();
+    }
+
+    bool
+    dump(const std::string& _path) noexcept
+    {
+        std::ofstream file(_path, std::ios::out | std::ios::trunc);
+        if (!file) { return false; }
+
+        dump(file);
+        return file.good();
+    }
+
+}   // namespace zab::tracing
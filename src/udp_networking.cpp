@@ -0,0 +1,394 @@
+/*
+ *  MMM"""AMV       db      `7MM"""Yp,
+ *  M'   AMV       ;MM:       MM    Yb
+ *  '   AMV       ,V^MM.      MM    dP
+ *     AMV       ,M  `MM      MM"""bg.
+ *    AMV   ,    AbmmmqMA     MM    `Y
+ *   AMV   ,M   A'     VML    MM    ,9
+ *  AMVmmmmMM .AMA.   .AMMA..JMMmmmd9
+ *
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021 Donald-Rupin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ *  @file udp_networking.cpp
+ *
+ */
+
+#include "zab/udp_networking.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <liburing.h>
+#include <netinet/in.h>
+#include <netinet/udp.h>
+#include <sys/socket.h>
+
+#include "zab/event_loop.hpp"
+
+namespace zab {
+
+    static_assert(sizeof(struct io_uring_recvmsg_out) == 4 * sizeof(std::uint32_t));
+
+    namespace {
+
+        /**
+         * @brief Group ids only need to be unique per ring, but handing them out globally keeps
+         *        groups on different threads apart as well.
+         */
+        std::atomic<std::uint16_t> next_group{1};
+
+    }   // namespace
+
+    buffer_group::buffer_group(engine* _engine, std::uint16_t _count, std::uint32_t _size)
+        : engine_(_engine), loop_(nullptr), storage_((std::size_t) _count * _size), size_(_size),
+          count_(_count), group_(next_group.fetch_add(1, std::memory_order_relaxed)),
+          recycles_(_count)
+    {
+        for (std::uint16_t id = 0; id < _count; ++id)
+        {
+            auto& op  = recycles_[id];
+            op.event_ = {.handle_ = event<>{.cb_ = &recycled, .context_ = &op}, .result_ = 0};
+            op.group_ = this;
+            op.id_    = id;
+        }
+
+        /* A buffer is unreturned at most once, so the retry list never reallocates. */
+        unreturned_.reserve(_count);
+    }
+
+    guaranteed_future<bool>
+    buffer_group::provide() noexcept
+    {
+        loop_ = &engine_->get_event_loop();
+        unreturned_.clear();
+
+        auto result = co_await loop_->provide_buffers(storage_, size_, count_, group_, 0);
+
+        co_return result >= 0;
+    }
+
+    simple_future<>
+    buffer_group::release() noexcept
+    {
+        if (loop_) { (void) co_await loop_->remove_buffers(count_, group_); }
+
+        loop_ = nullptr;
+        unreturned_.clear();
+    }
+
+    void
+    buffer_group::recycle(std::uint16_t _id) noexcept
+    {
+        retry_recycles();
+        give_back(_id);
+    }
+
+    void
+    buffer_group::retry_recycles() noexcept
+    {
+        while (!unreturned_.empty())
+        {
+            auto id = unreturned_.back();
+            unreturned_.pop_back();
+
+            /* The submission queue is still full, the rest has to wait as well. */
+            if (!give_back(id)) { break; }
+        }
+    }
+
+    bool
+    buffer_group::give_back(std::uint16_t _id) noexcept
+    {
+        auto& op          = recycles_[_id];
+        op.event_.result_ = 0;
+        loop_->provide_buffers(&op.event_, buffer(_id), size_, 1, group_, _id);
+
+        /* A full submission queue completes the operation before it returns. */
+        return op.event_.result_ >= 0;
+    }
+
+    void
+    buffer_group::recycled(void* _op) noexcept
+    {
+        auto* op = static_cast<recycle_op*>(_op);
+
+        if (op->event_.result_ < 0) [[unlikely]] { op->group_->unreturned_.push_back(op->id_); }
+    }
+
+    namespace details {
+
+        receive_state::receive_state(buffer_group& _buffers) noexcept
+            : event_{}, buffers_(&_buffers), received_(0), buffer_id_(0), armed_(false), error_(0)
+        {
+            ::memset(&message_, 0, sizeof(message_));
+            message_.msg_namelen    = sizeof(struct sockaddr_storage);
+            message_.msg_controllen = CMSG_SPACE(sizeof(int));
+        }
+
+        void
+        send_state::prepare(
+            std::span<const std::byte> _data,
+            const struct sockaddr*     _address,
+            socklen_t                  _length,
+            std::uint16_t              _segment_size) noexcept
+        {
+            ::memset(&message_, 0, sizeof(message_));
+            vector_.iov_base = (void*) _data.data();
+            vector_.iov_len  = _data.size();
+
+            message_.msg_name    = (void*) _address;
+            message_.msg_namelen = _address ? _length : 0;
+            message_.msg_iov     = &vector_;
+            message_.msg_iovlen  = 1;
+
+            if (_segment_size && _data.size() > _segment_size)
+            {
+                message_.msg_control    = control_;
+                message_.msg_controllen = sizeof(control_);
+
+                auto* header       = CMSG_FIRSTHDR(&message_);
+                header->cmsg_level = SOL_UDP;
+                header->cmsg_type  = UDP_SEGMENT;
+                header->cmsg_len   = CMSG_LEN(sizeof(_segment_size));
+                ::memcpy(CMSG_DATA(header), &_segment_size, sizeof(_segment_size));
+            }
+        }
+
+    }   // namespace details
+
+    udp_socket::udp_socket(engine* _engine) : network_operation(_engine) { }
+
+    namespace {
+
+        bool
+        ensure_socket(udp_socket& _socket, int _family) noexcept
+        {
+            if (_socket.descriptor() >= 0) { return true; }
+
+            auto sd = ::socket(_family, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+            if (sd < 0) [[unlikely]]
+            {
+                _socket.set_error(errno);
+                return false;
+            }
+
+            _socket.set_descriptor(sd);
+            return true;
+        }
+
+    }   // namespace
+
+    bool
+    udp_socket::bind(int _family, std::uint16_t _port) noexcept
+    {
+        if (!ensure_socket(*this, _family)) { return false; }
+
+        _port = ::htons(_port);
+
+        struct sockaddr_storage add;
+        ::memset(&add, 0, sizeof(add));
+
+        if (_family == AF_INET)
+        {
+            struct sockaddr_in* in4 = (struct sockaddr_in*) &add;
+            in4->sin_family         = AF_INET;
+            in4->sin_port           = _port;
+            in4->sin_addr.s_addr    = INADDR_ANY;
+        }
+        else if (_family == AF_INET6)
+        {
+            struct sockaddr_in6* in6 = (struct sockaddr_in6*) &add;
+            in6->sin6_family         = AF_INET6;
+            in6->sin6_port           = _port;
+            in6->sin6_addr           = in6addr_any;
+        }
+        else
+        {
+            set_error(EINVAL);
+            return false;
+        }
+
+        if (::bind(descriptor(), (struct sockaddr*) &add, sizeof(add)) != 0) [[unlikely]]
+        {
+            set_error(errno);
+            return false;
+        }
+
+        return true;
+    }
+
+    bool
+    udp_socket::connect(const struct sockaddr* _address, socklen_t _length) noexcept
+    {
+        if (!ensure_socket(*this, _address->sa_family)) { return false; }
+
+        if (::connect(descriptor(), _address, _length) != 0) [[unlikely]]
+        {
+            set_error(errno);
+            return false;
+        }
+
+        return true;
+    }
+
+    bool
+    udp_socket::set_gro(bool _enabled) noexcept
+    {
+        int value = _enabled;
+        if (::setsockopt(descriptor(), SOL_UDP, UDP_GRO, &value, sizeof(value)) != 0)
+            [[unlikely]]
+        {
+            set_error(errno);
+            return false;
+        }
+
+        return true;
+    }
+
+    std::uint16_t
+    udp_socket::port() noexcept
+    {
+        struct sockaddr_storage address;
+        socklen_t               length = sizeof(address);
+        if (::getsockname(descriptor(), (struct sockaddr*) &address, &length) != 0) [[unlikely]]
+        {
+            set_error(errno);
+            return 0;
+        }
+
+        if (address.ss_family == AF_INET6)
+        {
+            return ::ntohs(((struct sockaddr_in6*) &address)->sin6_port);
+        }
+
+        return ::ntohs(((struct sockaddr_in*) &address)->sin_port);
+    }
+
+    std::uint16_t
+    udp_socket::segment_size(const struct msghdr& _message) noexcept
+    {
+        auto* message = const_cast<struct msghdr*>(&_message);
+        for (auto* header = CMSG_FIRSTHDR(message); header; header = CMSG_NXTHDR(message, header))
+        {
+            if (header->cmsg_level == SOL_UDP && header->cmsg_type == UDP_GRO)
+            {
+                int size;
+                ::memcpy(&size, CMSG_DATA(header), sizeof(size));
+                return (std::uint16_t) size;
+            }
+        }
+
+        return 0;
+    }
+
+    int
+    udp_socket::settle(const net_op& _op) noexcept
+    {
+        set_cancel(nullptr);
+        if (_op.result_ >= 0) { return _op.result_; }
+
+        set_error(-_op.result_);
+        return -1;
+    }
+
+    void
+    udp_socket::arm(details::receive_state& _state) noexcept
+    {
+        _state.armed_    = true;
+        _state.received_ = 0;
+        _state.buffers_->retry_recycles();
+        set_cancel(&_state.event_);
+        get_engine()->get_event_loop().recv_msg_multishot(
+            &_state.event_,
+            descriptor(),
+            &_state.message_,
+            0,
+            _state.buffers_->group());
+    }
+
+    std::optional<datagram>
+    udp_socket::complete(details::receive_state& _state) noexcept
+    {
+        auto result = _state.event_.result_;
+        auto flags  = get_engine()->get_event_loop().completion_flags();
+
+        /* An error always ends a multishot operation. */
+        if (result < 0 || !(flags & IORING_CQE_F_MORE))
+        {
+            _state.armed_ = false;
+            set_cancel(nullptr);
+        }
+
+        if (result < 0)
+        {
+            /* Rearm after running out of buffers, unless there never were any. */
+            if (result == -ENOBUFS && _state.received_) { return std::nullopt; }
+
+            _state.error_ = -result;
+            set_error(_state.error_);
+            return std::nullopt;
+        }
+
+        if (!(flags & IORING_CQE_F_BUFFER)) [[unlikely]] { return std::nullopt; }
+
+        ++_state.received_;
+
+        auto id           = (std::uint16_t) (flags >> IORING_CQE_BUFFER_SHIFT);
+        auto buffer       = _state.buffers_->buffer(id).first((std::size_t) result);
+        _state.buffer_id_ = id;
+
+        auto& message = _state.message_;
+        auto  header  = sizeof(struct io_uring_recvmsg_out) + message.msg_namelen +
+                      message.msg_controllen;
+
+        if (buffer.size() < header) [[unlikely]]
+        {
+            _state.buffers_->recycle(id);
+            return std::nullopt;
+        }
+
+        struct io_uring_recvmsg_out out;
+        ::memcpy(&out, buffer.data(), sizeof(out));
+
+        auto* name    = buffer.data() + sizeof(out);
+        auto* control = name + message.msg_namelen;
+        auto* payload = control + message.msg_controllen;
+
+        struct msghdr received;
+        ::memset(&received, 0, sizeof(received));
+        received.msg_control    = control;
+        received.msg_controllen = std::min<std::size_t>(out.controllen, message.msg_controllen);
+
+        return datagram{
+            .data_ = std::span<const std::byte>(
+                payload,
+                std::min<std::size_t>(out.payloadlen, buffer.size() - header)),
+            .source_        = (const struct sockaddr*) name,
+            .source_length_ = std::min<socklen_t>(out.namelen, message.msg_namelen),
+            .segment_size_  = segment_size(received),
+            .truncated_     = (out.flags & MSG_TRUNC) != 0};
+    }
+
+}   // namespace zab
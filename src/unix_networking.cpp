@@ -0,0 +1,183 @@
+/*
+ *  MMM"""AMV       db      `7MM"""Yp,
+ *  M'   AMV       ;MM:       MM    Yb
+ *  '   AMV       ,V^MM.      MM    dP
+ *     AMV       ,M  `MM      MM"""bg.
+ *    AMV   ,    AbmmmqMA     MM    `Y
+ *   AMV   ,M   A'     VML    MM    ,9
+ *  AMVmmmmMM .AMA.   .AMMA..JMMmmmd9
+ *
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021 Donald-Rupin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ *  @file unix_networking.cpp
+ *
+ */
+
+#include "zab/unix_networking.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace zab {
+
+    namespace details {
+
+        bool
+        make_unix_address(
+            std::string_view    _path,
+            struct sockaddr_un& _address,
+            socklen_t&          _length) noexcept
+        {
+            ::memset(&_address, 0, sizeof(_address));
+            _address.sun_family = AF_UNIX;
+
+            /* Abstract names are not nul terminated, paths are. */
+            bool abstract = _path.size() && _path[0] == '\0';
+            if (_path.empty() || _path.size() + !abstract > sizeof(_address.sun_path))
+            {
+                return false;
+            }
+
+            ::memcpy(_address.sun_path, _path.data(), _path.size());
+            _length = offsetof(struct sockaddr_un, sun_path) + _path.size() + !abstract;
+            return true;
+        }
+
+        void
+        descriptor_message::prepare_send(
+            std::span<const std::byte> _data,
+            std::span<const int>       _fds) noexcept
+        {
+            ::memset(&message_, 0, sizeof(message_));
+            vector_.iov_base    = (void*) _data.data();
+            vector_.iov_len     = _data.size();
+            message_.msg_iov    = &vector_;
+            message_.msg_iovlen = 1;
+
+            if (_fds.size())
+            {
+                message_.msg_control    = control_;
+                message_.msg_controllen = CMSG_SPACE(sizeof(int) * _fds.size());
+
+                auto* header       = CMSG_FIRSTHDR(&message_);
+                header->cmsg_level = SOL_SOCKET;
+                header->cmsg_type  = SCM_RIGHTS;
+                header->cmsg_len   = CMSG_LEN(sizeof(int) * _fds.size());
+                ::memcpy(CMSG_DATA(header), _fds.data(), sizeof(int) * _fds.size());
+            }
+        }
+
+        void
+        descriptor_message::prepare_receive(std::span<std::byte> _data) noexcept
+        {
+            ::memset(&message_, 0, sizeof(message_));
+            vector_.iov_base    = _data.data();
+            vector_.iov_len     = _data.size();
+            message_.msg_iov    = &vector_;
+            message_.msg_iovlen = 1;
+
+            /* Leave room for the most that can be sent, so that extras are closed by take(). */
+            message_.msg_control    = control_;
+            message_.msg_controllen = sizeof(control_);
+        }
+
+        std::size_t
+        descriptor_message::take(std::span<int> _fds) noexcept
+        {
+            std::size_t count = 0;
+            if (!message_.msg_control) { return count; }
+
+            for (auto* header = CMSG_FIRSTHDR(&message_); header;
+                 header       = CMSG_NXTHDR(&message_, header))
+            {
+                if (header->cmsg_level != SOL_SOCKET || header->cmsg_type != SCM_RIGHTS)
+                {
+                    continue;
+                }
+
+                auto received = (header->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+                for (std::size_t i = 0; i < received; ++i)
+                {
+                    int fd;
+                    ::memcpy(&fd, CMSG_DATA(header) + i * sizeof(int), sizeof(fd));
+
+                    if (count < _fds.size()) { _fds[count++] = fd; }
+                    else
+                    {
+                        ::close(fd);
+                    }
+                }
+            }
+
+            return count;
+        }
+
+    }   // namespace details
+
+    unix_acceptor::unix_acceptor(engine* _engine) : network_operation(_engine) { }
+
+    bool
+    unix_acceptor::listen(std::string_view _path, int _backlog, int _type) noexcept
+    {
+        struct sockaddr_un address;
+        socklen_t          length;
+        if (!details::make_unix_address(_path, address, length))
+        {
+            set_error(EINVAL);
+            return false;
+        }
+
+        if (descriptor() < 0)
+        {
+            auto acc = ::socket(AF_UNIX, _type | SOCK_CLOEXEC, 0);
+
+            if (acc < 0) [[unlikely]]
+            {
+                set_error(errno);
+                return false;
+            }
+
+            set_descriptor(acc);
+        }
+
+        if (::bind(descriptor(), (struct sockaddr*) &address, length) != 0) [[unlikely]]
+        {
+            set_error(errno);
+            return false;
+        }
+
+        if (::listen(descriptor(), _backlog) != 0) [[unlikely]]
+        {
+            set_error(errno);
+            return false;
+        }
+
+        return true;
+    }
+
+}   // namespace zab
@@ -0,0 +1,138 @@
+/*
+ *  MMM"""AMV       db      `7MM"""Yp,
+ *  M'   AMV       ;MM:       MM    Yb
+ *  '   AMV       ,V^MM.      MM    dP
+ *     AMV       ,M  `MM      MM"""bg.
+ *    AMV   ,    AbmmmqMA     MM    `Y
+ *   AMV   ,M   A'     VML    MM    ,9
+ *  AMVmmmmMM .AMA.   .AMMA..JMMmmmd9
+ *
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021 Donald-Rupin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ *  @file watchdog.cpp
+ *
+ */
+
+#include "zab/watchdog.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+#include "zab/engine.hpp"
+#include "zab/event_loop.hpp"
+#include "zab/tracing.hpp"
+
+namespace zab {
+
+    namespace {
+
+        inline std::uint64_t
+        now_ns() noexcept
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now().time_since_epoch())
+                .count();
+        }
+
+    }   // namespace
+
+    watchdog::watchdog(engine* _engine, std::chrono::nanoseconds _threshold, handler _handler)
+        : engine_(_engine), threshold_(_threshold),
+          handler_(_handler ? std::move(_handler) : handler(&watchdog::print_report))
+    { }
+
+    watchdog::~watchdog()
+    {
+        stop();
+    }
+
+    void
+    watchdog::start()
+    {
+        stop();
+
+        reported_.assign(engine_->number_of_workers(), 0);
+        thread_ = std::jthread([this](std::stop_token _stop_token) { run(_stop_token); });
+    }
+
+    void
+    watchdog::stop()
+    {
+        if (thread_.joinable())
+        {
+            thread_.request_stop();
+            thread_.join();
+        }
+    }
+
+    void
+    watchdog::print_report(const stall_report& _report)
+    {
+        std::cerr << "zab::watchdog event loop " << _report.loop_.thread_ << " stalled for "
+                  << std::chrono::duration_cast<std::chrono::microseconds>(_report.duration_)
+                         .count()
+                  << "us resuming " << _report.coroutine_ << "\n";
+    }
+
+    void
+    watchdog::run(std::stop_token _stop_token)
+    {
+        /* Sample often enough to catch a stall within a quarter of the threshold. */
+        auto interval = std::max<std::chrono::nanoseconds>(
+            threshold_ / 4,
+            std::chrono::milliseconds(1));
+
+        if constexpr (kTracing) { tracing::name_thread("zab watchdog"); }
+
+        std::unique_lock lck(mtx_);
+        while (!_stop_token.stop_requested())
+        {
+            cv_.wait_for(lck, _stop_token, interval, [] { return false; });
+            if (_stop_token.stop_requested()) { break; }
+
+            auto now = now_ns();
+            for (std::uint16_t i = 0; i < reported_.size(); ++i)
+            {
+                auto sample = engine_->get_event_loop(thread_t{i}).steps().read();
+
+                if (!sample.started_ || sample.started_ > now) { continue; }
+
+                auto running = std::chrono::nanoseconds(now - sample.started_);
+                if (running >= threshold_ && reported_[i] != sample.sequence_)
+                {
+                    reported_[i] = sample.sequence_;
+
+                    /* Shows up on the watchdog track, with the id of the stalled resume slice. */
+                    tracing::instant("stall", sample.coroutine_, running.count());
+
+                    handler_(stall_report{
+                        .loop_      = thread_t{i},
+                        .duration_  = running,
+                        .coroutine_ = sample.coroutine_});
+                }
+            }
+        }
+    }
+
+}   // namespace zab
@@ -0,0 +1,222 @@
+/*
+ *  MMM"""AMV       db      `7MM"""Yp,
+ *  M'   AMV       ;MM:       MM    Yb
+ *  '   AMV       ,V^MM.      MM    dP
+ *     AMV       ,M  `MM      MM"""bg.
+ *    AMV   ,    AbmmmqMA     MM    `Y
+ *   AMV   ,M   A'     VML    MM    ,9
+ *  AMVmmmmMM .AMA.   .AMMA..JMMmmmd9
+ *
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021 Donald-Rupin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ *  @file test-arena.cpp
+ *
+ */
+
+#include <cstddef>
+#include <memory_resource>
+#include <vector>
+
+#include "zab/arena.hpp"
+#include "zab/async_function.hpp"
+#include "zab/engine.hpp"
+#include "zab/engine_enabled.hpp"
+#include "zab/simple_future.hpp"
+
+#include "internal/macros.hpp"
+
+namespace zab::test {
+
+    int
+    test_arena_resource();
+
+    int
+    test_arena_tree();
+
+    int
+    run_test()
+    {
+        return test_arena_resource() || test_arena_tree();
+    }
+
+    int
+    test_arena_resource()
+    {
+        arena a(256);
+
+        if (expected(std::size_t{0}, a.used())) { return 1; }
+
+        {
+            std::pmr::vector<int> data(&a);
+            for (int i = 0; i < 1000; ++i)
+            {
+                data.push_back(i);
+            }
+
+            if (expected(999, data.back())) { return 1; }
+        }
+
+        if (not_expected(std::size_t{0}, a.used())) { return 1; }
+
+        a.release();
+
+        if (expected(std::size_t{0}, a.used())) { return 1; }
+
+        if (expected((std::pmr::memory_resource*) std::pmr::get_default_resource(), arena_resource()))
+        {
+            return 1;
+        }
+
+        {
+            arena_scope scope(a);
+
+            if (expected(&a, arena::current())) { return 1; }
+            if (expected((std::pmr::memory_resource*) &a, arena_resource())) { return 1; }
+        }
+
+        if (expected((arena*) nullptr, arena::current())) { return 1; }
+
+        return 0;
+    }
+
+    class test_arena_tree_class : public engine_enabled<test_arena_tree_class> {
+
+        public:
+
+            static constexpr auto kDefaultThread = 0;
+
+            void
+            initialise() noexcept
+            {
+                run();
+            }
+
+            async_function<>
+            run() noexcept
+            {
+                failed_ = !co_await root();
+
+                if (expected((arena*) nullptr, arena::current())) { failed_ = true; }
+
+                /* With no arena installed frames come from the heap... */
+                arena scratch;
+                {
+                    arena_scope scope(scratch);
+                    arena::deallocate_frame(arena::allocate_frame(64), 64);
+                }
+
+                auto used = scratch.used();
+                if (expected(true, used > 0)) { failed_ = true; }
+
+                auto* frame   = arena::allocate_frame(64);
+                auto  pending = child(nullptr);
+
+                if (expected(used, scratch.used())) { failed_ = true; }
+
+                /* ...so they outlive any arena that was installed while they were alive. */
+                {
+                    arena       transient;
+                    arena_scope scope(transient);
+                    arena::deallocate_frame(arena::allocate_frame(64), 64);
+                }
+
+                arena::deallocate_frame(frame, 64);
+                if (expected(true, co_await pending)) { failed_ = true; }
+
+                engine_->stop();
+            }
+
+            arena_future<bool>
+            root() noexcept
+            {
+                arena a;
+                co_await use_arena(a);
+
+                if (expected(&a, arena::current())) { co_return false; }
+
+                auto before = a.used();
+
+                auto first  = child(&a);
+                auto second = child(&a);
+
+                if (expected(true, a.used() > before)) { co_return false; }
+
+                if (!co_await first || !co_await second) { co_return false; }
+
+                co_await yield();
+
+                if (expected(&a, arena::current())) { co_return false; }
+
+                co_return true;
+            }
+
+            arena_future<bool>
+            child(arena* _expected) noexcept
+            {
+                if (expected(_expected, arena::current())) { co_return false; }
+
+                std::pmr::vector<std::byte> buffer(1024, arena_resource());
+
+                co_await yield();
+
+                if (expected(_expected, arena::current())) { co_return false; }
+
+                co_return true;
+            }
+
+            bool
+            failed() const noexcept
+            {
+                return failed_;
+            }
+
+        private:
+
+            bool failed_ = true;
+    };
+
+    int
+    test_arena_tree()
+    {
+        engine engine(engine::configs{
+            .threads_         = 1,
+            .opt_             = engine::configs::kExact,
+            .affinity_set_    = false,
+            .affinity_offset_ = 0});
+
+        test_arena_tree_class test;
+        test.register_engine(engine);
+
+        engine.start();
+
+        return test.failed();
+    }
+
+}   // namespace zab::test
+
+int
+main()
+{
+    return zab::test::run_test();
+}
@@ -0,0 +1,234 @@
+/*
+ *  MMM"""AMV       db      `7MM"""Yp,
+ *  M'   AMV       ;MM:       MM    Yb
+ *  '   AMV       ,V^MM.      MM    dP
+ *     AMV       ,M  `MM      MM"""bg.
+ *    AMV   ,    AbmmmqMA     MM    `Y
+ *   AMV   ,M   A'     VML    MM    ,9
+ *  AMVmmmmMM .AMA.   .AMMA..JMMmmmd9
+ *
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021 Donald-Rupin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ *  @file test-buffered_reader.cpp
+ *
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <sys/socket.h>
+#include <vector>
+
+#include "zab/async_function.hpp"
+#include "zab/buffered_reader.hpp"
+#include "zab/engine.hpp"
+#include "zab/engine_enabled.hpp"
+#include "zab/tcp_stream.hpp"
+#include "zab/yield.hpp"
+
+#include "internal/macros.hpp"
+
+namespace zab::test {
+
+    int
+    test_scan();
+
+    int
+    test_reader();
+
+    int
+    run_test()
+    {
+        return test_scan() || test_reader();
+    }
+
+    int
+    test_scan()
+    {
+        /* Mostly delimiter bytes so there are plenty of partial matches. */
+        static constexpr std::string_view kAlphabet = "\r\n\r\na-";
+
+        std::string   data(300, ' ');
+        std::uint32_t state = 1;
+        for (auto& c : data)
+        {
+            state = state * 1103515245 + 12345;
+            c     = kAlphabet[(state >> 16) % kAlphabet.size()];
+        }
+
+        for (std::string_view delimiter :
+             {"\n", "\r\n", "\r\n\r\n", "a-", "0123456789abcdefghijklmnopqrstuvwxyz-"})
+        {
+            auto needle = std::as_bytes(std::span(delimiter));
+            for (std::size_t offset = 0; offset < 4; ++offset)
+            {
+                for (std::size_t size = 0; size + offset <= data.size(); ++size)
+                {
+                    auto haystack = std::as_bytes(std::span(data).subspan(offset, size));
+
+                    if (expected(
+                            details::find_delimiter_scalar(haystack, needle),
+                            details::find_delimiter(haystack, needle)))
+                    {
+                        return 1;
+                    }
+                }
+            }
+        }
+
+        /* A match that starts in the last vector width. */
+        std::string tail(100, 'x');
+        tail.replace(95, 2, "\r\n");
+
+        return expected(
+            95ul,
+            details::find_delimiter(
+                std::as_bytes(std::span(tail)),
+                std::as_bytes(std::span(std::string_view("\r\n")))));
+    }
+
+    class test_reader_class : public engine_enabled<test_reader_class> {
+
+        public:
+
+            static constexpr auto kDefaultThread = 0;
+
+            static constexpr std::size_t kLimit = 2048;
+
+            void
+            initialise() noexcept
+            {
+                int sockets[2];
+                if (expected(0, ::socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sockets)))
+                {
+                    engine_->stop();
+                    return;
+                }
+
+                long_line_ = std::string(1000, 'x');
+
+                payload_ = "GET / HTTP/1.1\r\nHost: zab\r\n\r\n";
+                payload_ += "5\nhello";
+                payload_ += "record--end--";
+                payload_ += long_line_ + "\n";
+                payload_ += "trailing";
+
+                run_writer(tcp_stream<char>(engine_, sockets[0]));
+                run_reader(tcp_stream<char>(engine_, sockets[1]));
+            }
+
+            async_function<>
+            run_writer(tcp_stream<char> _stream)
+            {
+                /* Small pieces so frames are split across reads. */
+                static constexpr std::size_t kPiece = 7;
+
+                std::span<const char> data(payload_);
+                for (std::size_t i = 0; i < data.size(); i += kPiece)
+                {
+                    co_await _stream.write(data.subspan(i, std::min(kPiece, data.size() - i)));
+                    co_await yield();
+                }
+
+                co_await _stream.shutdown();
+                co_await _stream.close();
+            }
+
+            async_function<>
+            run_reader(tcp_stream<char> _stream)
+            {
+                /* Starts smaller than most frames so it has to grow. */
+                buffered_reader<char> reader(_stream, 8, kLimit);
+
+                auto as_string = [](const std::optional<std::span<char>>& _frame)
+                { return _frame ? std::string(_frame->begin(), _frame->end()) : "<none>"; };
+
+                auto request = as_string(co_await reader.read_line());
+                auto host    = as_string(co_await reader.read_line());
+                auto empty   = as_string(co_await reader.read_line());
+                auto length  = as_string(co_await reader.read_line());
+                auto body    = as_string(co_await reader.read_exact(std::stoul(length)));
+
+                std::string_view end_marker = "--end--";
+
+                auto record = as_string(co_await reader.read_until(end_marker));
+                auto line   = as_string(co_await reader.read_line());
+
+                auto too_large = co_await reader.read_exact(kLimit + 1);
+
+                /* The stream ends before another line does. */
+                auto missing = co_await reader.read_line();
+                auto rest    = std::string(reader.buffered().begin(), reader.buffered().end());
+
+                co_await _stream.close();
+
+                failed_ = expected(std::string("GET / HTTP/1.1"), request) ||
+                          expected(std::string("Host: zab"), host) ||
+                          expected(std::string(), empty) || expected(std::string("5"), length) ||
+                          expected(std::string("hello"), body) ||
+                          expected(std::string("record--end--"), record) ||
+                          expected(long_line_, line) || expected(false, too_large.has_value()) ||
+                          expected(false, missing.has_value()) ||
+                          expected(std::string("trailing"), rest) ||
+                          expected(true, reader.capacity() <= kLimit);
+
+                engine_->stop();
+            }
+
+            bool
+            failed()
+            {
+                return failed_;
+            }
+
+        private:
+
+            std::string payload_;
+            std::string long_line_;
+            bool        failed_ = true;
+    };
+
+    int
+    test_reader()
+    {
+        engine engine(engine::configs{.threads_ = 1});
+
+        test_reader_class test;
+
+        test.register_engine(engine);
+
+        engine.start();
+
+        return test.failed();
+    }
+
+}   // namespace zab::test
+
+int
+main()
+{
+    return zab::test::run_test();
+}
@@ -36,7 +36,9 @@
 
 #include <iostream>
 #include <ostream>
+#include <thread>
 
+#include "zab/async_function.hpp"
 #include "zab/engine.hpp"
 #include "zab/engine_enabled.hpp"
 #include "zab/event.hpp"
@@ -52,6 +54,9 @@ namespace zab::test {
     int
     test_main();
 
+    int
+    test_use_caller_thread();
+
     /**
      * @brief      run all the tests.
      *
@@ -60,7 +65,7 @@ namespace zab::test {
     int
     run_test()
     {
-        return test_initialise() || test_main();
+        return test_initialise() || test_main() || test_use_caller_thread();
     }
 
     class test_initialise_class : public engine_enabled<test_initialise_class> {
@@ -139,6 +144,58 @@ namespace zab::test {
         return test.main_count() != test_main_class::kMaxMains;
     }
 
+    class test_use_caller_thread_class : public engine_enabled<test_use_caller_thread_class> {
+
+        public:
+
+            static constexpr auto kDefaultThread = 0;
+
+            void
+            initialise() noexcept
+            {
+                run();
+            }
+
+            async_function<>
+            run() noexcept
+            {
+                co_await yield(thread_t{0});
+                first_ = std::this_thread::get_id();
+
+                co_await yield(thread_t{1});
+                second_ = std::this_thread::get_id();
+
+                engine_->stop();
+            }
+
+            std::thread::id first_;
+            std::thread::id second_;
+    };
+
+    int
+    test_use_caller_thread()
+    {
+        engine engine(engine::configs{
+            .threads_           = 2,
+            .opt_               = engine::configs::kExact,
+            .affinity_set_      = false,
+            .use_caller_thread_ = true});
+
+        test_use_caller_thread_class test;
+
+        test.register_engine(engine);
+
+        auto before = engine::current_id();
+
+        engine.start();
+
+        if (expected(std::this_thread::get_id(), test.first_)) { return 1; }
+        if (not_expected(std::this_thread::get_id(), test.second_)) { return 1; }
+        if (expected(before, engine::current_id())) { return 1; }
+
+        return 0;
+    }
+
 }   // namespace zab::test
 
 int
@@ -0,0 +1,174 @@
+/*
+ *  MMM"""AMV       db      `7MM"""Yp,
+ *  M'   AMV       ;MM:       MM    Yb
+ *  '   AMV       ,V^MM.      MM    dP
+ *     AMV       ,M  `MM      MM"""bg.
+ *    AMV   ,    AbmmmqMA     MM    `Y
+ *   AMV   ,M   A'     VML    MM    ,9
+ *  AMVmmmmMM .AMA.   .AMMA..JMMmmmd9
+ *
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021 Donald-Rupin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ *  @file test-engine_local.cpp
+ *
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "zab/async_function.hpp"
+#include "zab/async_latch.hpp"
+#include "zab/engine.hpp"
+#include "zab/engine_enabled.hpp"
+#include "zab/engine_local.hpp"
+#include "zab/hardware_interface_size.hpp"
+#include "zab/yield.hpp"
+
+#include "internal/macros.hpp"
+
+namespace zab::test {
+
+    static constexpr auto kNumberThreads = 4u;
+
+    int
+    test_engine_local();
+
+    int
+    run_test()
+    {
+        return test_engine_local();
+    }
+
+    class test_engine_local_class : public engine_enabled<test_engine_local_class> {
+
+        public:
+
+            static constexpr auto kDefaultThread = 0;
+
+            static constexpr std::size_t kRounds = 1000;
+
+            void
+            initialise() noexcept
+            {
+                run();
+            }
+
+            async_function<>
+            run() noexcept
+            {
+                locals_ = std::make_unique<engine_local<std::size_t>>(engine_);
+                latch_  = std::make_unique<async_latch>(engine_, kNumberThreads + 1);
+
+                for (std::uint16_t i = 0; i < kNumberThreads; ++i)
+                {
+                    work(thread_t{i});
+                }
+
+                co_await latch_->arrive_and_wait();
+
+                bool on_thread = true;
+                co_await locals_->for_each_worker(
+                    [&](thread_t _thread, std::size_t&)
+                    {
+                        if (engine::current_id() != _thread) { on_thread = false; }
+                    });
+
+                if (expected(true, on_thread)) { engine_->stop(); }
+                else if (expected(thread_t{kDefaultThread}, engine::current_id()))
+                {
+                    engine_->stop();
+                }
+                else
+                {
+                    auto sum = co_await locals_->reduce(
+                        std::size_t{0},
+                        [](std::size_t _sum, std::size_t& _value) { return _sum + _value; });
+
+                    failed_ = expected(kRounds * (1 + 2 + 3 + 4), sum);
+                }
+
+                engine_->stop();
+            }
+
+            async_function<>
+            work(thread_t _thread) noexcept
+            {
+                co_await yield(_thread);
+
+                auto& local = locals_->get();
+
+                if (expected(
+                        std::uintptr_t{0},
+                        reinterpret_cast<std::uintptr_t>(&local) %
+                            hardware_destructive_interference_size))
+                {
+                    engine_->stop();
+                }
+
+                for (std::size_t i = 0; i < kRounds * (_thread.thread_ + 1); ++i)
+                {
+                    ++*(*locals_);
+                }
+
+                latch_->count_down();
+            }
+
+            bool
+            failed() const noexcept
+            {
+                return failed_;
+            }
+
+        private:
+
+            std::unique_ptr<engine_local<std::size_t>> locals_;
+            std::unique_ptr<async_latch>               latch_;
+            bool                                       failed_ = true;
+    };
+
+    int
+    test_engine_local()
+    {
+        engine engine(engine::configs{
+            .threads_         = kNumberThreads,
+            .opt_             = engine::configs::kExact,
+            .affinity_set_    = false,
+            .affinity_offset_ = 0});
+
+        test_engine_local_class test;
+        test.register_engine(engine);
+
+        engine.start();
+
+        return test.failed();
+    }
+
+}   // namespace zab::test
+
+int
+main()
+{
+    return zab::test::run_test();
+}
@@ -61,10 +61,13 @@ namespace zab::test {
     int
     test_read_write();
 
+    int
+    test_positional();
+
     int
     run_test()
     {
-        return test_read() || test_write() || test_read_write();
+        return test_read() || test_write() || test_read_write() || test_positional();
     }
 
     class test_read_class : public engine_enabled<test_read_class> {
@@ -281,6 +284,80 @@ namespace zab::test {
 
         return test.failed();
     }
+
+    class test_positional_class : public engine_enabled<test_positional_class> {
+
+        public:
+
+            static constexpr auto kDefaultThread = 0;
+
+            void
+            initialise() noexcept
+            {
+                run();
+            }
+
+            async_function<>
+            run() noexcept
+            {
+                static constexpr auto kBlock = 4096;
+
+                async_file<char> file(engine_);
+
+                if (co_await file.open(file_name, file::Option::kRWTruncate))
+                {
+                    std::vector<char> first(kBlock, 'a');
+                    std::vector<char> second(kBlock, 'b');
+
+                    /* Out of order. */
+                    auto second_written = co_await file.write_at(second, kBlock);
+                    auto first_written  = co_await file.write_at(first, 0);
+
+                    std::vector<char> read(kBlock);
+                    auto              amount = co_await file.read_at(read, kBlock);
+
+                    failed_ = !second_written || *second_written != kBlock || !first_written ||
+                              *first_written != kBlock || !amount || *amount != kBlock ||
+                              read != second;
+
+                    /* Reading at the end of the file is not an error. */
+                    amount = co_await file.read_at(read, 2 * kBlock);
+                    failed_ |= !amount || *amount != 0;
+
+                    /* The cursor is untouched. */
+                    auto whole = co_await file.read_file();
+                    failed_ |= !whole || whole->size() != 2 * kBlock || (*whole)[0] != 'a';
+                }
+
+                ::remove(file_name);
+
+                engine_->stop();
+            }
+
+            bool
+            failed()
+            {
+                return failed_;
+            }
+
+        private:
+
+            bool failed_ = true;
+    };
+
+    int
+    test_positional()
+    {
+        engine engine(engine::configs{1});
+
+        test_positional_class test;
+
+        test.register_engine(engine);
+
+        engine.start();
+
+        return test.failed();
+    }
 }   // namespace zab::test
 
 int
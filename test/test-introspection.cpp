@@ -0,0 +1,238 @@
+/*
+ *  MMM"""AMV       db      `7MM"""Yp,
+ *  M'   AMV       ;MM:       MM    Yb
+ *  '   AMV       ,V^MM.      MM    dP
+ *     AMV       ,M  `MM      MM"""bg.
+ *    AMV   ,    AbmmmqMA     MM    `Y
+ *   AMV   ,M   A'     VML    MM    ,9
+ *  AMVmmmmMM .AMA.   .AMMA..JMMmmmd9
+ *
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021 Donald-Rupin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ *  @file test-introspection.cpp
+ *
+ */
+
+#include <chrono>
+#include <optional>
+#include <signal.h>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "zab/async_function.hpp"
+#include "zab/async_mutex.hpp"
+#include "zab/engine.hpp"
+#include "zab/engine_enabled.hpp"
+#include "zab/introspection.hpp"
+
+#include "internal/macros.hpp"
+
+namespace zab::test {
+
+    int
+    test_waits();
+
+    int
+    run_test()
+    {
+        return test_waits();
+    }
+
+    std::optional<introspection::wait_group>
+    find_group(std::string_view _kind, const void* _object = nullptr)
+    {
+        for (const auto& group : introspection::snapshot())
+        {
+            if (_kind == group.kind_ && group.object_ == _object) { return group; }
+        }
+
+        return std::nullopt;
+    }
+
+    class test_waits_class : public engine_enabled<test_waits_class> {
+
+        public:
+
+            static constexpr auto kDefaultThread = 0;
+
+            void
+            initialise() noexcept
+            {
+                run();
+            }
+
+            async_function<>
+            run() noexcept
+            {
+                mutex_.emplace(engine_);
+
+                if (::socketpair(AF_UNIX, SOCK_STREAM, 0, fds_))
+                {
+                    engine_->stop();
+                    co_return;
+                }
+
+                introspection::dump_on_signal(engine_, SIGUSR2, dump_);
+
+                {
+                    auto guard = co_await *mutex_;
+
+                    wait_on_mutex();
+                    wait_on_recv();
+                    wait_on_timer();
+
+                    co_await yield();
+
+                    if constexpr (introspection::kEnabled)
+                    {
+                        auto mutex = find_group("async_mutex", &*mutex_);
+                        auto recv  = find_group("recv");
+                        auto timer = find_group("timer", &engine_->get_timer());
+
+                        if (expected(true, mutex && recv && timer) ||
+                            expected(1u, mutex->count_) ||
+                            expected(1u, recv->count_) ||
+                            expected(1u, timer->count_) ||
+                            expected(0u, mutex->over_threshold_) ||
+                            expected(true, introspection::waiting() >= 3))
+                        {
+                            engine_->stop();
+                            co_return;
+                        }
+                    }
+                    else
+                    {
+                        if (expected(0u, introspection::snapshot().size()) ||
+                            expected(0u, introspection::waiting()))
+                        {
+                            engine_->stop();
+                            co_return;
+                        }
+                    }
+
+                    ::raise(SIGUSR2);
+
+                    /* Give the signal handler time to dispatch. */
+                    co_await yield(order::in_milli(100));
+
+                    if (expected(true, dump_.str().starts_with("zab::introspection")))
+                    {
+                        engine_->stop();
+                        co_return;
+                    }
+
+                    if constexpr (introspection::kEnabled)
+                    {
+                        if (expected(true, dump_.str().find("1 on recv") != std::string::npos))
+                        {
+                            engine_->stop();
+                            co_return;
+                        }
+                    }
+                }
+
+                char c = 'x';
+                if (::write(fds_[1], &c, 1) != 1)
+                {
+                    engine_->stop();
+                    co_return;
+                }
+
+                co_await yield(order::in_milli(100));
+
+                failed_ = expected(3u, resumed_) ||
+                          expected(false, find_group("async_mutex", &*mutex_).has_value()) ||
+                          expected(false, find_group("recv").has_value());
+
+                ::close(fds_[0]);
+                ::close(fds_[1]);
+
+                engine_->stop();
+            }
+
+            async_function<>
+            wait_on_mutex() noexcept
+            {
+                auto guard = co_await *mutex_;
+                ++resumed_;
+            }
+
+            async_function<>
+            wait_on_recv() noexcept
+            {
+                char c;
+                co_await engine_->get_event_loop().recv(
+                    fds_[0],
+                    std::span<std::byte>(reinterpret_cast<std::byte*>(&c), 1),
+                    0);
+                ++resumed_;
+            }
+
+            async_function<>
+            wait_on_timer() noexcept
+            {
+                co_await engine_->get_timer().wait(std::chrono::nanoseconds(
+                                                       std::chrono::milliseconds(50))
+                                                       .count());
+                ++resumed_;
+            }
+
+            bool
+            failed() const noexcept
+            {
+                return failed_;
+            }
+
+        private:
+
+            std::optional<async_mutex> mutex_;
+            int                        fds_[2]  = {-1, -1};
+            std::size_t                resumed_ = 0;
+            std::stringstream          dump_;
+            bool                       failed_ = true;
+    };
+
+    int
+    test_waits()
+    {
+        engine engine(engine::configs{.threads_ = 1, .opt_ = engine::configs::kExact});
+
+        test_waits_class test;
+        test.register_engine(engine);
+
+        engine.start();
+
+        return test.failed();
+    }
+
+}   // namespace zab::test
+
+int
+main()
+{
+    return zab::test::run_test();
+}
@@ -0,0 +1,212 @@
+/*
+ *  MMM"""AMV       db      `7MM"""Yp,
+ *  M'   AMV       ;MM:       MM    Yb
+ *  '   AMV       ,V^MM.      MM    dP
+ *     AMV       ,M  `MM      MM"""bg.
+ *    AMV   ,    AbmmmqMA     MM    `Y
+ *   AMV   ,M   A'     VML    MM    ,9
+ *  AMVmmmmMM .AMA.   .AMMA..JMMmmmd9
+ *
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021 Donald-Rupin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ *  @file test-latency_histogram.cpp
+ *
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+#include "zab/async_function.hpp"
+#include "zab/engine.hpp"
+#include "zab/engine_enabled.hpp"
+#include "zab/latency_histogram.hpp"
+
+#include "internal/macros.hpp"
+
+namespace zab::test {
+
+    int
+    test_histogram();
+
+    int
+    test_concurrent_snapshot();
+
+    int
+    test_engine_latency();
+
+    int
+    run_test()
+    {
+        return test_histogram() || test_concurrent_snapshot() || test_engine_latency();
+    }
+
+    bool
+    within(std::chrono::nanoseconds _got, std::int64_t _value)
+    {
+        /* Buckets are accurate to 1/16th. */
+        return _got.count() >= _value && _got.count() <= _value + _value / 16;
+    }
+
+    int
+    test_histogram()
+    {
+        latency_histogram histogram;
+
+        if (expected(std::uint64_t{0}, histogram.snapshot().count())) { return 1; }
+        if (expected(0, histogram.snapshot().percentile(50).count())) { return 1; }
+
+        for (std::uint64_t i = 1; i <= 1000; ++i)
+        {
+            histogram.record(i);
+        }
+
+        auto snapshot = histogram.snapshot();
+
+        if (expected(std::uint64_t{1000}, snapshot.count())) { return 1; }
+        if (expected(500, snapshot.mean().count())) { return 1; }
+        if (expected(true, within(snapshot.percentile(50), 500))) { return 1; }
+        if (expected(true, within(snapshot.percentile(99), 990))) { return 1; }
+        if (expected(true, within(snapshot.percentile(100), 1000))) { return 1; }
+        if (expected(true, within(snapshot.max(), 1000))) { return 1; }
+        if (expected(1, snapshot.percentile(0).count())) { return 1; }
+
+        latency_histogram other;
+        other.record(std::uint64_t{1} << 40);
+
+        snapshot += other.snapshot();
+
+        if (expected(std::uint64_t{1001}, snapshot.count())) { return 1; }
+        if (expected(true, within(snapshot.max(), std::int64_t{1} << 40))) { return 1; }
+
+        return 0;
+    }
+
+    int
+    test_concurrent_snapshot()
+    {
+        static constexpr std::uint64_t kValues = 100000;
+
+        latency_histogram histogram;
+
+        /* Snapshots come from a monitoring thread, even in single threaded builds. */
+        std::thread writer(
+            [&histogram]
+            {
+                for (std::uint64_t i = 1; i <= kValues; ++i)
+                {
+                    histogram.record(i);
+                }
+            });
+
+        std::uint64_t last      = 0;
+        bool          monotonic = true;
+        while (last < kValues)
+        {
+            auto count = histogram.snapshot().count();
+            monotonic &= count >= last;
+            last = count;
+        }
+
+        writer.join();
+
+        if (expected(true, monotonic)) { return 1; }
+        if (expected(kValues, histogram.snapshot().count())) { return 1; }
+
+        return 0;
+    }
+
+    class test_engine_latency_class : public engine_enabled<test_engine_latency_class> {
+
+        public:
+
+            static constexpr auto kDefaultThread = 0;
+
+            static constexpr std::uint64_t kRounds = 100;
+
+            void
+            initialise() noexcept
+            {
+                run();
+            }
+
+            async_function<>
+            run() noexcept
+            {
+                for (std::uint64_t i = 0; i < kRounds; ++i)
+                {
+                    co_await yield();
+                }
+
+                auto latency = engine_->latency();
+
+                if (tracking_)
+                {
+                    failed_ = expected(true, latency.queue_delay_.count() >= kRounds) ||
+                              expected(true, latency.completion_delay_.count() > 0);
+                }
+                else
+                {
+                    failed_ = expected(std::uint64_t{0}, latency.queue_delay_.count()) ||
+                              expected(std::uint64_t{0}, latency.completion_delay_.count());
+                }
+
+                engine_->stop();
+            }
+
+            bool tracking_ = false;
+            bool failed_   = true;
+    };
+
+    int
+    test_engine_latency()
+    {
+        for (bool tracking : {false, true})
+        {
+            engine engine(engine::configs{
+                .threads_         = 1,
+                .opt_             = engine::configs::kExact,
+                .affinity_set_    = false,
+                .affinity_offset_ = 0,
+                .track_latency_   = tracking});
+
+            test_engine_latency_class test;
+            test.tracking_ = tracking;
+            test.register_engine(engine);
+
+            engine.start();
+
+            if (test.failed_) { return 1; }
+        }
+
+        return 0;
+    }
+
+}   // namespace zab::test
+
+int
+main()
+{
+    return zab::test::run_test();
+}
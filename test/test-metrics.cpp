@@ -0,0 +1,144 @@
+/*
+ *  MMM"""AMV       db      `7MM"""Yp,
+ *  M'   AMV       ;MM:       MM    Yb
+ *  '   AMV       ,V^MM.      MM    dP
+ *     AMV       ,M  `MM      MM"""bg.
+ *    AMV   ,    AbmmmqMA     MM    `Y
+ *   AMV   ,M   A'     VML    MM    ,9
+ *  AMVmmmmMM .AMA.   .AMMA..JMMmmmd9
+ *
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021 Donald-Rupin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ *  @file test-metrics.cpp
+ *
+ */
+
+#include <cstdint>
+
+#include "zab/async_function.hpp"
+#include "zab/engine.hpp"
+#include "zab/engine_enabled.hpp"
+#include "zab/metrics.hpp"
+#include "zab/strong_types.hpp"
+
+#include "internal/macros.hpp"
+
+namespace zab::test {
+
+    int
+    test_metrics();
+
+    int
+    run_test()
+    {
+        return test_metrics();
+    }
+
+    class test_metrics_class : public engine_enabled<test_metrics_class> {
+
+        public:
+
+            static constexpr auto kDefaultThread = 0;
+
+            static constexpr std::uint64_t kRounds = 100;
+
+            void
+            initialise() noexcept
+            {
+                run();
+            }
+
+            async_function<>
+            run() noexcept
+            {
+                auto before = engine_->metrics(thread_t{1});
+
+                for (std::uint64_t i = 0; i < kRounds; ++i)
+                {
+                    co_await yield(thread_t{1});
+                    co_await yield(thread_t{0});
+                }
+
+                co_await yield(order::in_milli(1), thread_t{0});
+
+                /* Let the loop account for the last batch. */
+                co_await yield(thread_t{1});
+                co_await yield(thread_t{0});
+
+                auto after = engine_->metrics(thread_t{1});
+                auto total = engine_->metrics();
+
+                failed_ =
+                    expected(
+                        true,
+                        after.user_events_executed_ >= before.user_events_executed_ + kRounds) ||
+                    expected(true, after.cross_thread_wakes_ > before.cross_thread_wakes_) ||
+                    expected(true, total.cqes_reaped_ > 0) ||
+                    expected(true, total.sqes_submitted_ > 0) ||
+                    expected(true, total.submit_syscalls_ > 0) ||
+                    expected(true, total.wait_syscalls_ > 0) ||
+                    expected(true, total.timer_fires_ > 0) ||
+                    expected(true, total.user_events_dispatched_ >= total.user_events_executed_) ||
+                    expected(std::uint64_t{0}, total.sq_full_) ||
+                    expected(true, total.busy_time_.count() > 0) ||
+                    expected(true, total.idle_time_.count() > 0);
+
+                engine_->stop();
+            }
+
+            bool
+            failed() const noexcept
+            {
+                return failed_;
+            }
+
+        private:
+
+            bool failed_ = true;
+    };
+
+    int
+    test_metrics()
+    {
+        engine engine(engine::configs{
+            .threads_         = 2,
+            .opt_             = engine::configs::kExact,
+            .affinity_set_    = false,
+            .affinity_offset_ = 0});
+
+        test_metrics_class test;
+        test.register_engine(engine);
+
+        engine.start();
+
+        return test.failed();
+    }
+
+}   // namespace zab::test
+
+int
+main()
+{
+    return zab::test::run_test();
+}
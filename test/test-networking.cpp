@@ -36,17 +36,26 @@
 
 #include <cstdint>
 #include <cstring>
+#include <arpa/inet.h>
 #include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <optional>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string>
 #include <string_view>
 #include <sys/socket.h>
 #include <sys/types.h>
 #include <unistd.h>
+#include <vector>
 
 #include "zab/engine.hpp"
 #include "zab/engine_enabled.hpp"
+#include "zab/async_latch.hpp"
+#include "zab/send_queue.hpp"
 #include "zab/tcp_networking.hpp"
+#include "zab/write_queue.hpp"
 
 #include "internal/macros.hpp"
 
@@ -58,10 +67,26 @@ namespace zab::test {
     int
     test_stress();
 
+    int
+    test_sharded();
+
+    int
+    test_vectored();
+
+    int
+    test_write_queue();
+
+    int
+    test_options();
+
+    int
+    test_send_queue();
+
     int
     run_test()
     {
-        return test_simple() || test_stress();
+        return test_simple() || test_stress() || test_sharded() || test_vectored() ||
+               test_write_queue() || test_options() || test_send_queue();
     }
 
     class test_simple_class : public engine_enabled<test_simple_class> {
@@ -351,6 +376,662 @@ namespace zab::test {
 
         return test.failed();
     }
+
+    class test_sharded_class : public engine_enabled<test_sharded_class> {
+
+        public:
+
+            static constexpr auto kDefaultThread = 0;
+
+            static constexpr size_t kNumberOfConnections = 64;
+
+            test_sharded_class(sharded_acceptor::steering _steering)
+                : steering_(_steering), served_(0)
+            { }
+
+            void
+            initialise() noexcept
+            {
+                acceptor_.emplace(engine_);
+
+                if (!acceptor_->listen(AF_INET, 0, kNumberOfConnections, steering_))
+                {
+                    std::cerr << "sharded listen failed: " << acceptor_->last_error() << "\n";
+                    engine_->stop();
+                    return;
+                }
+
+                if (expected(engine_->number_of_workers(), acceptor_->size()) ||
+                    expected(true, acceptor_->port() != 0))
+                {
+                    engine_->stop();
+                    return;
+                }
+
+                acceptor_->serve<char>([this](tcp_stream<char> _stream) noexcept
+                                       { run_stream(std::move(_stream)); });
+
+                for (size_t i = 0; i < kNumberOfConnections; ++i)
+                {
+                    run_connector();
+                }
+            }
+
+            async_function<>
+            run_stream(tcp_stream<char> _stream)
+            {
+                auto thread = engine_->current_id();
+
+                std::vector<char> buffer(1);
+                if (co_await _stream.read(buffer) == 1)
+                {
+                    co_await _stream.write(buffer);
+
+                    /* The stream is served where it was accepted. */
+                    if (thread == engine_->current_id()) { ++served_; }
+                }
+
+                co_await _stream.shutdown();
+            }
+
+            async_function<>
+            run_connector()
+            {
+                struct sockaddr_in address;
+                ::memset(&address, 0, sizeof(address));
+                address.sin_family      = AF_INET;
+                address.sin_port        = ::htons(acceptor_->port());
+                address.sin_addr.s_addr = ::htonl(INADDR_LOOPBACK);
+
+                auto stream = co_await tcp_connect<char>(
+                    engine_,
+                    (struct sockaddr*) &address,
+                    sizeof(address));
+
+                std::vector<char> buffer{'x'};
+                if (!stream.last_error() && co_await stream.write(buffer) == 1 &&
+                    co_await stream.read(buffer) == 1 && buffer[0] == 'x')
+                {
+                    co_await stream.shutdown();
+                }
+
+                if (++connected_ == kNumberOfConnections)
+                {
+                    co_await acceptor_->close();
+
+                    failed_ = expected(kNumberOfConnections, served_.load());
+
+                    engine_->stop();
+                }
+            }
+
+            bool
+            failed()
+            {
+                return failed_;
+            }
+
+        private:
+
+            sharded_acceptor::steering      steering_;
+            std::optional<sharded_acceptor> acceptor_;
+            std::atomic<size_t>             served_;
+            size_t                          connected_ = 0;
+            bool                            failed_    = true;
+    };
+
+    int
+    test_sharded()
+    {
+        for (auto steering :
+             {sharded_acceptor::steering::kNone,
+              sharded_acceptor::steering::kIncomingCpu,
+              sharded_acceptor::steering::kCpuProgram})
+        {
+            engine engine(engine::configs{.threads_ = 2, .opt_ = engine::configs::kExact});
+
+            test_sharded_class test(steering);
+
+            test.register_engine(engine);
+
+            engine.start();
+
+            if (test.failed()) { return 1; }
+        }
+
+        return 0;
+    }
+    class test_vectored_class : public engine_enabled<test_vectored_class> {
+
+        public:
+
+            static constexpr auto kDefaultThread = 0;
+
+            /* Far more than the old 64KiB cap on a single send. */
+            static constexpr std::size_t kBodySize = 4 * 1024 * 1024;
+
+            void
+            initialise() noexcept
+            {
+                acceptor_.register_engine(engine_);
+
+                if (expected(true, acceptor_.listen(AF_INET, 0, 10)))
+                {
+                    engine_->stop();
+                    return;
+                }
+
+                run_acceptor();
+                run_connector();
+            }
+
+            async_function<>
+            run_acceptor()
+            {
+                struct sockaddr_storage address;
+                socklen_t               length = sizeof(address);
+
+                auto stream = co_await acceptor_.accept<char>((struct sockaddr*) &address, &length);
+                if (!stream)
+                {
+                    engine_->stop();
+                    co_return;
+                }
+
+                std::string       header(8, 'h');
+                std::vector<char> body(kBodySize);
+                for (std::size_t i = 0; i < body.size(); ++i)
+                {
+                    body[i] = (char) (i % 251);
+                }
+
+                std::span<const char> buffers[] = {header, {}, body};
+
+                written_ = co_await stream->write_v(buffers);
+
+                co_await stream->shutdown();
+            }
+
+            async_function<>
+            run_connector()
+            {
+                struct sockaddr_in address;
+                socklen_t          length = sizeof(address);
+                ::getsockname(acceptor_.descriptor(), (struct sockaddr*) &address, &length);
+                address.sin_addr.s_addr = ::htonl(INADDR_LOOPBACK);
+
+                auto stream = co_await tcp_connect<char>(
+                    engine_,
+                    (struct sockaddr*) &address,
+                    sizeof(address));
+
+                /* Split differently to the writer. */
+                std::vector<char> first(5);
+                std::vector<char> second(kBodySize + 3);
+
+                std::span<char> buffers[] = {first, second};
+
+                auto read = co_await stream.read_v(buffers);
+
+                bool body_matches = true;
+                for (std::size_t i = 0; i < kBodySize; ++i)
+                {
+                    body_matches &= second[i + 3] == (char) (i % 251);
+                }
+
+                std::string header(first.begin(), first.end());
+                header.append(second.data(), 3);
+
+                /* Returns once the writer has shut down, so after write_v resumed. */
+                co_await stream.shutdown();
+                co_await acceptor_.close();
+
+                failed_ = expected((long long) (kBodySize + 8), read) ||
+                          expected((long long) (kBodySize + 8), written_) ||
+                          expected(std::string(8, 'h'), header) || expected(true, body_matches);
+
+                engine_->stop();
+            }
+
+            bool
+            failed()
+            {
+                return failed_;
+            }
+
+        private:
+
+            tcp_acceptor acceptor_;
+            long long    written_ = 0;
+            bool         failed_  = true;
+    };
+
+    int
+    test_vectored()
+    {
+        engine engine(engine::configs{.threads_ = 1});
+
+        test_vectored_class test;
+
+        test.register_engine(engine);
+
+        engine.start();
+
+        return test.failed();
+    }
+
+    class test_write_queue_class : public engine_enabled<test_write_queue_class> {
+
+        public:
+
+            static constexpr auto kDefaultThread = 0;
+
+            static constexpr std::size_t kWriters = 16;
+
+            void
+            initialise() noexcept
+            {
+                acceptor_.register_engine(engine_);
+
+                if (expected(true, acceptor_.listen(AF_INET, 0, 10)))
+                {
+                    engine_->stop();
+                    return;
+                }
+
+                run_acceptor();
+                run_connector();
+            }
+
+            async_function<>
+            run_acceptor()
+            {
+                struct sockaddr_storage address;
+                socklen_t               length = sizeof(address);
+
+                auto stream = co_await acceptor_.accept<char>((struct sockaddr*) &address, &length);
+                if (!stream)
+                {
+                    engine_->stop();
+                    co_return;
+                }
+
+                write_queue<char> queue(*stream);
+                async_latch       done(engine_, kWriters + 1);
+
+                /* Every write is queued within this turn... */
+                for (std::size_t i = 0; i < kWriters; ++i)
+                {
+                    run_writer(queue, done, i);
+                }
+
+                pending_ = queue.pending();
+
+                co_await done.arrive_and_wait();
+
+                /* ...so they should all have gone out together. */
+                flushes_ = queue.flushes();
+
+                co_await stream->shutdown();
+            }
+
+            async_function<>
+            run_writer(write_queue<char>& _queue, async_latch& _done, std::size_t _index)
+            {
+                auto message = make_message(_index);
+
+                results_[_index] = co_await _queue.write(message);
+
+                _done.count_down();
+            }
+
+            async_function<>
+            run_connector()
+            {
+                struct sockaddr_in address;
+                socklen_t          length = sizeof(address);
+                ::getsockname(acceptor_.descriptor(), (struct sockaddr*) &address, &length);
+                address.sin_addr.s_addr = ::htonl(INADDR_LOOPBACK);
+
+                auto stream = co_await tcp_connect<char>(
+                    engine_,
+                    (struct sockaddr*) &address,
+                    sizeof(address));
+
+                std::string expected_data;
+                for (std::size_t i = 0; i < kWriters; ++i)
+                {
+                    expected_data += make_message(i);
+                }
+
+                std::vector<char> buffer(expected_data.size());
+                auto              read = co_await stream.read(buffer);
+
+                /* Returns once the writer has shut down, so after every write resumed. */
+                co_await stream.shutdown();
+                co_await acceptor_.close();
+
+                bool results_match = true;
+                for (std::size_t i = 0; i < kWriters; ++i)
+                {
+                    results_match &= results_[i] == (long long) make_message(i).size();
+                }
+
+                failed_ = expected((long long) expected_data.size(), read) ||
+                          expected(expected_data, std::string(buffer.begin(), buffer.end())) ||
+                          expected(kWriters, pending_) || expected(1ull, flushes_) ||
+                          expected(true, results_match);
+
+                engine_->stop();
+            }
+
+            static std::string
+            make_message(std::size_t _index)
+            {
+                return "response " + std::to_string(_index) + std::string(_index, '.') + "\n";
+            }
+
+            bool
+            failed()
+            {
+                return failed_;
+            }
+
+        private:
+
+            tcp_acceptor       acceptor_;
+            long long          results_[kWriters] = {};
+            std::size_t        pending_           = 0;
+            unsigned long long flushes_           = 0;
+            bool               failed_            = true;
+    };
+
+    int
+    test_write_queue()
+    {
+        engine engine(engine::configs{.threads_ = 1});
+
+        test_write_queue_class test;
+
+        test.register_engine(engine);
+
+        engine.start();
+
+        return test.failed();
+    }
+
+    class test_options_class : public engine_enabled<test_options_class> {
+
+        public:
+
+            static constexpr auto kDefaultThread = 0;
+
+            static constexpr int kLowWatermark = 16 * 1024;
+
+            void
+            initialise() noexcept
+            {
+                acceptor_.register_engine(engine_);
+
+                tcp_acceptor bad(engine_);
+                bad_address_ = bad.listen(AF_INET, 0, 10, {.bind_address_ = "not an address"});
+                bad_error_   = bad.last_error();
+
+                if (expected(
+                        true,
+                        acceptor_.listen(
+                            AF_INET,
+                            0,
+                            10,
+                            {.no_delay_       = true,
+                             .receive_buffer_ = 64 * 1024,
+                             .defer_accept_   = 1,
+                             .fast_open_      = 16,
+                             .not_sent_lowat_ = kLowWatermark,
+                             .bind_address_   = "127.0.0.1",
+                             .inherit_        = true})))
+                {
+                    engine_->stop();
+                    return;
+                }
+
+                run_acceptor();
+                run_connector();
+            }
+
+            static int
+            get_option(int _fd, int _level, int _name)
+            {
+                int       value  = -1;
+                socklen_t length = sizeof(value);
+                ::getsockopt(_fd, _level, _name, &value, &length);
+                return value;
+            }
+
+            async_function<>
+            run_acceptor()
+            {
+                struct sockaddr_storage address;
+                socklen_t               length = sizeof(address);
+
+                /* Deferred until the connector has sent something. */
+                auto stream = co_await acceptor_.accept<char>((struct sockaddr*) &address, &length);
+                if (!stream)
+                {
+                    engine_->stop();
+                    co_return;
+                }
+
+                accepted_no_delay_ = get_option(stream->descriptor(), IPPROTO_TCP, TCP_NODELAY);
+                accepted_lowat_ = get_option(stream->descriptor(), IPPROTO_TCP, TCP_NOTSENT_LOWAT);
+
+                std::vector<char> buffer(1);
+                co_await stream->read(buffer);
+                co_await stream->shutdown();
+            }
+
+            async_function<>
+            run_connector()
+            {
+                struct sockaddr_in address;
+                socklen_t          length = sizeof(address);
+                ::getsockname(acceptor_.descriptor(), (struct sockaddr*) &address, &length);
+
+                char bound[INET_ADDRSTRLEN] = {};
+                ::inet_ntop(AF_INET, &address.sin_addr, bound, sizeof(bound));
+
+                auto stream = co_await tcp_connect<char>(
+                    engine_,
+                    (struct sockaddr*) &address,
+                    sizeof(address));
+
+                bool set = stream.set_options({.no_delay_ = true, .quick_ack_ = true});
+                auto no_delay = get_option(stream.descriptor(), IPPROTO_TCP, TCP_NODELAY);
+
+                co_await stream.write(std::span<const char>("x", 1));
+                co_await stream.shutdown();
+                co_await acceptor_.close();
+
+                failed_ = expected(false, bad_address_) || expected(EINVAL, bad_error_) ||
+                          expected(std::string("127.0.0.1"), std::string(bound)) ||
+                          expected(1, accepted_no_delay_) ||
+                          expected(kLowWatermark, accepted_lowat_) || expected(true, set) ||
+                          expected(1, no_delay);
+
+                engine_->stop();
+            }
+
+            bool
+            failed()
+            {
+                return failed_;
+            }
+
+        private:
+
+            tcp_acceptor acceptor_;
+            int          bad_error_         = 0;
+            int          accepted_no_delay_ = 0;
+            int          accepted_lowat_    = 0;
+            bool         bad_address_       = true;
+            bool         failed_            = true;
+    };
+
+    int
+    test_options()
+    {
+        engine engine(engine::configs{.threads_ = 1});
+
+        test_options_class test;
+
+        test.register_engine(engine);
+
+        engine.start();
+
+        return test.failed();
+    }
+
+    class test_send_queue_class : public engine_enabled<test_send_queue_class> {
+
+        public:
+
+            static constexpr auto kDefaultThread = 0;
+
+            static constexpr std::size_t kHighWatermark = 64 * 1024;
+
+            static constexpr std::size_t kLowWatermark = 16 * 1024;
+
+            static constexpr std::size_t kMessageSize = 16 * 1024;
+
+            static constexpr std::size_t kMessages = 64;
+
+            void
+            initialise() noexcept
+            {
+                acceptor_.register_engine(engine_);
+
+                if (expected(true, acceptor_.listen(AF_INET, 0, 10)))
+                {
+                    engine_->stop();
+                    return;
+                }
+
+                run_acceptor();
+                run_connector();
+            }
+
+            async_function<>
+            run_acceptor()
+            {
+                struct sockaddr_storage address;
+                socklen_t               length = sizeof(address);
+
+                auto stream = co_await acceptor_.accept<char>((struct sockaddr*) &address, &length);
+                if (!stream)
+                {
+                    engine_->stop();
+                    co_return;
+                }
+
+                send_queue<char> queue(*stream, kHighWatermark, kLowWatermark);
+
+                int       lowat = -1;
+                socklen_t size  = sizeof(lowat);
+                ::getsockopt(stream->descriptor(), IPPROTO_TCP, TCP_NOTSENT_LOWAT, &lowat, &size);
+                lowat_ = lowat;
+
+                /* Pushed without yielding, so the queue fills faster than it can drain. */
+                for (std::size_t i = 0; i < kMessages; ++i)
+                {
+                    auto message = make_message(i);
+                    pushed_ += co_await queue.push(message);
+                }
+
+                flushed_ = co_await queue.flush();
+                metrics_ = queue.metrics();
+
+                co_await stream->shutdown();
+            }
+
+            async_function<>
+            run_connector()
+            {
+                struct sockaddr_in address;
+                socklen_t          length = sizeof(address);
+                ::getsockname(acceptor_.descriptor(), (struct sockaddr*) &address, &length);
+                address.sin_addr.s_addr = ::htonl(INADDR_LOOPBACK);
+
+                auto stream = co_await tcp_connect<char>(
+                    engine_,
+                    (struct sockaddr*) &address,
+                    sizeof(address));
+
+                std::string expected_data;
+                for (std::size_t i = 0; i < kMessages; ++i)
+                {
+                    expected_data += make_message(i);
+                }
+
+                std::vector<char> buffer(expected_data.size());
+                auto              read = co_await stream.read(buffer);
+
+                /* Returns once the writer has shut down, so after the queue flushed. */
+                co_await stream.shutdown();
+                co_await acceptor_.close();
+
+                failed_ = expected((long long) expected_data.size(), read) ||
+                          expected(expected_data, std::string(buffer.begin(), buffer.end())) ||
+                          expected(kMessages, pushed_) || expected(true, flushed_) ||
+                          expected((int) kLowWatermark, lowat_) ||
+                          expected((std::size_t) 0, metrics_.queued_bytes_) ||
+                          expected((std::size_t) 0, metrics_.waiting_producers_) ||
+                          expected((std::uint64_t) expected_data.size(), metrics_.bytes_sent_) ||
+                          expected(true, metrics_.producer_waits_ > 0) ||
+                          expected(true, metrics_.writes_ > 1) ||
+                          expected(
+                              true,
+                              metrics_.peak_queued_bytes_ >= kHighWatermark &&
+                                  metrics_.peak_queued_bytes_ < kHighWatermark + kMessageSize);
+
+                engine_->stop();
+            }
+
+            static std::string
+            make_message(std::size_t _index)
+            {
+                return std::string(kMessageSize, (char) ('a' + _index % 26));
+            }
+
+            bool
+            failed()
+            {
+                return failed_;
+            }
+
+        private:
+
+            tcp_acceptor       acceptor_;
+            send_queue_metrics metrics_;
+            std::size_t        pushed_  = 0;
+            int                lowat_   = -1;
+            bool               flushed_ = false;
+            bool               failed_  = true;
+    };
+
+    int
+    test_send_queue()
+    {
+        engine engine(engine::configs{.threads_ = 1});
+
+        test_send_queue_class test;
+
+        test.register_engine(engine);
+
+        engine.start();
+
+        return test.failed();
+    }
+
 }   // namespace zab::test
 
 int
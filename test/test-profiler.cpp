@@ -0,0 +1,192 @@
+/*
+ *  MMM"""AMV       db      `7MM"""Yp,
+ *  M'   AMV       ;MM:       MM    Yb
+ *  '   AMV       ,V^MM.      MM    dP
+ *     AMV       ,M  `MM      MM"""bg.
+ *    AMV   ,    AbmmmqMA     MM    `Y
+ *   AMV   ,M   A'     VML    MM    ,9
+ *  AMVmmmmMM .AMA.   .AMMA..JMMmmmd9
+ *
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021 Donald-Rupin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ *  @file test-profiler.cpp
+ *
+ */
+
+#include <chrono>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <string_view>
+
+#include "zab/async_function.hpp"
+#include "zab/async_mutex.hpp"
+#include "zab/engine.hpp"
+#include "zab/engine_enabled.hpp"
+#include "zab/profiler.hpp"
+#include "zab/simple_future.hpp"
+
+#include "internal/macros.hpp"
+
+namespace zab::test {
+
+    int
+    test_sites();
+
+    int
+    run_test()
+    {
+        return test_sites();
+    }
+
+    std::optional<profiler::site_profile>
+    find_site(std::string_view _kind, std::string_view _function)
+    {
+        for (const auto& site : profiler::merge())
+        {
+            if (_kind == site.kind_ && site.function_.find(_function) != std::string::npos &&
+                std::string_view(site.file_).ends_with("test-profiler.cpp"))
+            {
+                return site;
+            }
+        }
+
+        return std::nullopt;
+    }
+
+    class test_sites_class : public engine_enabled<test_sites_class> {
+
+        public:
+
+            static constexpr auto kDefaultThread = 0;
+
+            static constexpr auto kSleep = std::chrono::milliseconds(5);
+
+            void
+            initialise() noexcept
+            {
+                run();
+            }
+
+            async_function<>
+            run() noexcept
+            {
+                mutex_.emplace(engine_);
+
+                {
+                    auto guard = co_await mutex_->lock();
+
+                    contend();
+
+                    co_await sleeper();
+                }
+
+                co_await yield();
+
+                if constexpr (kProfiling)
+                {
+                    auto timer = find_site("timer", "sleeper");
+                    auto mutex = find_site("async_mutex", "contend");
+
+                    if (expected(true, timer && mutex) || expected(3u, timer->suspended_.count()) ||
+                        expected(true, timer->total() >= 3 * kSleep) ||
+                        expected(1u, mutex->suspended_.count()) ||
+                        expected(true, mutex->total() >= 3 * kSleep))
+                    {
+                        engine_->stop();
+                        co_return;
+                    }
+
+                    std::stringstream ss;
+                    profiler::print(ss);
+                    if (expected(true, ss.str().find("sleeper") != std::string::npos))
+                    {
+                        engine_->stop();
+                        co_return;
+                    }
+                }
+                else
+                {
+                    if (expected(0u, profiler::merge().size()))
+                    {
+                        engine_->stop();
+                        co_return;
+                    }
+                }
+
+                profiler::reset();
+                failed_ = expected(0u, profiler::merge().size());
+
+                engine_->stop();
+            }
+
+            simple_future<>
+            sleeper() noexcept
+            {
+                for (int i = 0; i < 3; ++i)
+                {
+                    co_await engine_->get_timer().wait(
+                        std::chrono::duration_cast<std::chrono::nanoseconds>(kSleep).count());
+                }
+
+            }
+
+            async_function<>
+            contend() noexcept
+            {
+                auto guard = co_await mutex_->lock();
+            }
+
+            bool
+            failed() const noexcept
+            {
+                return failed_;
+            }
+
+        private:
+
+            std::optional<async_mutex> mutex_;
+            bool                       failed_ = true;
+    };
+
+    int
+    test_sites()
+    {
+        engine engine(engine::configs{.threads_ = 1, .opt_ = engine::configs::kExact});
+
+        test_sites_class test;
+        test.register_engine(engine);
+
+        engine.start();
+
+        return test.failed();
+    }
+
+}   // namespace zab::test
+
+int
+main()
+{
+    return zab::test::run_test();
+}
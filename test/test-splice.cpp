@@ -0,0 +1,536 @@
+/*
+ *  MMM"""AMV       db      `7MM"""Yp,
+ *  M'   AMV       ;MM:       MM    Yb
+ *  '   AMV       ,V^MM.      MM    dP
+ *     AMV       ,M  `MM      MM"""bg.
+ *    AMV   ,    AbmmmqMA     MM    `Y
+ *   AMV   ,M   A'     VML    MM    ,9
+ *  AMVmmmmMM .AMA.   .AMMA..JMMmmmd9
+ *
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021 Donald-Rupin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ *  @file test-splice.cpp
+ *
+ */
+
+#include <cstddef>
+#include <cstdlib>
+#include <netinet/in.h>
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+#include "zab/async_file.hpp"
+#include "zab/async_function.hpp"
+#include "zab/engine.hpp"
+#include "zab/engine_enabled.hpp"
+#include "zab/splice.hpp"
+#include "zab/tcp_networking.hpp"
+#include "zab/tcp_stream.hpp"
+
+#include "internal/macros.hpp"
+
+namespace zab::test {
+
+    int
+    test_relay();
+
+    int
+    test_relay_error();
+
+    int
+    test_relay_reset();
+
+    int
+    test_send_file();
+
+    int
+    run_test()
+    {
+        return test_relay() || test_relay_error() || test_relay_reset() || test_send_file();
+    }
+
+    class test_relay_class : public engine_enabled<test_relay_class> {
+
+        public:
+
+            static constexpr auto kDefaultThread = 0;
+
+            /* Many times the pipe so it takes a lot of splices. */
+            static constexpr std::size_t kRequestSize  = 1024 * 1024;
+            static constexpr std::size_t kResponseSize = 100 * 1000;
+            static constexpr std::size_t kPipeSize     = 4096;
+
+            void
+            initialise() noexcept
+            {
+                int client[2];
+                int server[2];
+                if (expected(0, ::socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, client)) ||
+                    expected(0, ::socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, server)))
+                {
+                    engine_->stop();
+                    return;
+                }
+
+                run_client(tcp_stream<char>(engine_, client[0]));
+                run_relay(
+                    tcp_stream<char>(engine_, client[1]),
+                    tcp_stream<char>(engine_, server[0]));
+                run_server(tcp_stream<char>(engine_, server[1]));
+            }
+
+            static std::vector<char>
+            make_data(std::size_t _size, std::size_t _seed)
+            {
+                std::vector<char> data(_size);
+                for (std::size_t i = 0; i < _size; ++i)
+                {
+                    data[i] = (char) ((i + _seed) % 251);
+                }
+
+                return data;
+            }
+
+            async_function<>
+            run_client(tcp_stream<char> _stream)
+            {
+                auto request = make_data(kRequestSize, 1);
+                co_await _stream.write(request);
+
+                /* Half close, the response should still arrive. */
+                ::shutdown(_stream.descriptor(), SHUT_WR);
+
+                std::vector<char> response(kResponseSize + 1);
+                response_ok_ = co_await _stream.read(response) == (long long) kResponseSize;
+
+                response.resize(kResponseSize);
+                response_ok_ = response_ok_ && response == make_data(kResponseSize, 2);
+
+                co_await _stream.close();
+                finish();
+            }
+
+            async_function<>
+            run_server(tcp_stream<char> _stream)
+            {
+                /* Everything up to the client's half close. */
+                std::vector<char> request(kRequestSize + 1);
+                request_ok_ = co_await _stream.read(request) == (long long) kRequestSize;
+
+                request.resize(kRequestSize);
+                request_ok_ = request_ok_ && request == make_data(kRequestSize, 1);
+
+                co_await _stream.write(make_data(kResponseSize, 2));
+                ::shutdown(_stream.descriptor(), SHUT_WR);
+
+                co_await _stream.close();
+                finish();
+            }
+
+            async_function<>
+            run_relay(tcp_stream<char> _client, tcp_stream<char> _server)
+            {
+                result_       = co_await splice(_client, _server, kPipeSize);
+                relay_errors_ = _client.last_error() || _server.last_error();
+
+                co_await _client.close();
+                co_await _server.close();
+                finish();
+            }
+
+            void
+            finish()
+            {
+                if (++finished_ < 3) { return; }
+
+                failed_ = expected(true, request_ok_) || expected(true, response_ok_) ||
+                          expected((long long) kRequestSize, result_.to_second_) ||
+                          expected((long long) kResponseSize, result_.to_first_) ||
+                          expected(0, result_.error_) || expected(false, relay_errors_);
+
+                engine_->stop();
+            }
+
+            bool
+            failed()
+            {
+                return failed_;
+            }
+
+        private:
+
+            splice_result result_;
+            std::size_t   finished_     = 0;
+            bool          request_ok_   = false;
+            bool          response_ok_  = false;
+            bool          relay_errors_ = true;
+            bool          failed_       = true;
+    };
+
+    int
+    test_relay()
+    {
+        engine engine(engine::configs{.threads_ = 1});
+
+        test_relay_class test;
+
+        test.register_engine(engine);
+
+        engine.start();
+
+        return test.failed();
+    }
+
+    class test_relay_error_class : public engine_enabled<test_relay_error_class> {
+
+        public:
+
+            static constexpr auto kDefaultThread = 0;
+
+            void
+            initialise() noexcept
+            {
+                if (expected(0, ::socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sockets_)))
+                {
+                    engine_->stop();
+                    return;
+                }
+
+                run_relay();
+            }
+
+            async_function<>
+            run_relay()
+            {
+                tcp_stream<char> good(engine_, sockets_[0]);
+                tcp_stream<char> closed(engine_, network_operation::kNoDescriptor);
+
+                /* Reading `closed` fails, which shuts `good` down and ends the other way too. */
+                auto result = co_await splice(good, closed);
+
+                failed_ = expected(EBADF, result.error_) || expected(0, good.last_error()) ||
+                          expected(EBADF, closed.last_error());
+
+                co_await good.close();
+                ::close(sockets_[1]);
+
+                engine_->stop();
+            }
+
+            bool
+            failed()
+            {
+                return failed_;
+            }
+
+        private:
+
+            int  sockets_[2] = {-1, -1};
+            bool failed_     = true;
+    };
+
+    int
+    test_relay_error()
+    {
+        engine engine(engine::configs{.threads_ = 1});
+
+        test_relay_error_class test;
+
+        test.register_engine(engine);
+
+        engine.start();
+
+        return test.failed();
+    }
+
+    class test_relay_reset_class : public engine_enabled<test_relay_reset_class> {
+
+        public:
+
+            static constexpr auto kDefaultThread = 0;
+
+            /* Far more than the socket buffers, so the relay is still writing at the reset. */
+            static constexpr std::size_t kRequestSize = 16 * 1024 * 1024;
+            static constexpr std::size_t kBeforeReset = 64 * 1024;
+
+            void
+            initialise() noexcept
+            {
+                acceptor_.register_engine(engine_);
+
+                if (expected(0, ::socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, client_)) ||
+                    expected(true, acceptor_.listen(AF_INET, 0, 10)))
+                {
+                    engine_->stop();
+                    return;
+                }
+
+                run_client(tcp_stream<char>(engine_, client_[0]));
+                run_server();
+                run_relay(tcp_stream<char>(engine_, client_[1]));
+            }
+
+            async_function<>
+            run_client(tcp_stream<char> _stream)
+            {
+                std::vector<char> request(kRequestSize, 'r');
+                co_await _stream.write(request);
+
+                co_await _stream.close();
+                finish();
+            }
+
+            async_function<>
+            run_server()
+            {
+                struct sockaddr_storage address;
+                socklen_t               length = sizeof(address);
+
+                auto stream = co_await acceptor_.accept<char>((struct sockaddr*) &address, &length);
+                if (stream)
+                {
+                    std::vector<char> some(kBeforeReset);
+                    co_await stream->read(some);
+
+                    /* Close with a RST rather than a FIN. */
+                    struct linger reset = {.l_onoff = 1, .l_linger = 0};
+                    ::setsockopt(
+                        stream->descriptor(),
+                        SOL_SOCKET,
+                        SO_LINGER,
+                        &reset,
+                        sizeof(reset));
+                    co_await stream->close();
+                }
+
+                finish();
+            }
+
+            async_function<>
+            run_relay(tcp_stream<char> _client)
+            {
+                struct sockaddr_in address;
+                socklen_t          length = sizeof(address);
+                ::getsockname(acceptor_.descriptor(), (struct sockaddr*) &address, &length);
+                address.sin_addr.s_addr = ::htonl(INADDR_LOOPBACK);
+
+                auto server = co_await tcp_connect<char>(
+                    engine_,
+                    (struct sockaddr*) &address,
+                    sizeof(address));
+
+                /* Fails with EPIPE or ECONNRESET, never by raising SIGPIPE. */
+                auto result   = co_await splice(_client, server);
+                error_        = result.error_;
+                server_error_ = server.last_error();
+
+                /* The relay shut the socket down. Writing to it from the worker raises SIGPIPE
+                 * right here, which would kill the process if the worker had not blocked it. */
+                write_result_ = ::write(server.descriptor(), "x", 1);
+
+                co_await _client.close();
+                co_await server.close();
+                finish();
+            }
+
+            async_function<>
+            finish()
+            {
+                if (++finished_ < 3) { co_return; }
+
+                failed_ = expected(true, error_ == EPIPE || error_ == ECONNRESET) ||
+                          expected(error_, server_error_) || expected(-1l, write_result_);
+
+                co_await acceptor_.close();
+                engine_->stop();
+            }
+
+            bool
+            failed()
+            {
+                return failed_;
+            }
+
+        private:
+
+            tcp_acceptor acceptor_;
+            int          client_[2]    = {-1, -1};
+            int          error_        = 0;
+            int          server_error_ = 0;
+            ssize_t      write_result_ = 0;
+            std::size_t  finished_     = 0;
+            bool         failed_       = true;
+    };
+
+    int
+    test_relay_reset()
+    {
+        engine engine(engine::configs{.threads_ = 1});
+
+        test_relay_reset_class test;
+
+        test.register_engine(engine);
+
+        engine.start();
+
+        return test.failed();
+    }
+
+    class test_send_file_class : public engine_enabled<test_send_file_class> {
+
+        public:
+
+            static constexpr auto kDefaultThread = 0;
+
+            static constexpr std::size_t kFileSize = 3 * 1024 * 1024 + 17;
+            static constexpr std::size_t kOffset   = 1000;
+            static constexpr std::size_t kLength   = 2 * 1024 * 1024 + 123;
+            static constexpr std::size_t kTailSize = 100;
+            static constexpr std::size_t kPipeSize = 16 * 1024;
+
+            void
+            initialise() noexcept
+            {
+                char path[] = "/tmp/zab-test-send_file-XXXXXX";
+                int  fd     = ::mkstemp(path);
+                if (expected(true, fd >= 0))
+                {
+                    engine_->stop();
+                    return;
+                }
+
+                path_ = path;
+
+                contents_.resize(kFileSize);
+                for (std::size_t i = 0; i < kFileSize; ++i)
+                {
+                    contents_[i] = (char) (i % 253);
+                }
+
+                auto written = ::write(fd, contents_.data(), contents_.size());
+                ::close(fd);
+
+                int sockets[2];
+                if (expected((ssize_t) kFileSize, written) ||
+                    expected(0, ::socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sockets)))
+                {
+                    engine_->stop();
+                    return;
+                }
+
+                run_sender(tcp_stream<char>(engine_, sockets[0]));
+                run_receiver(tcp_stream<char>(engine_, sockets[1]));
+            }
+
+            async_function<>
+            run_sender(tcp_stream<char> _stream)
+            {
+                async_file<char> file(engine_);
+                if (co_await file.open(path_, file::Option::kRead))
+                {
+                    sent_ = co_await send_file(file, _stream, kOffset, kLength, kPipeSize);
+
+                    /* Asks for more than is left. */
+                    tail_sent_ =
+                        co_await send_file(file, _stream, kFileSize - kTailSize, 2 * kTailSize);
+                    stream_error_ = _stream.last_error();
+
+                    /* Fails writing, so nothing is sent and the reason is on the stream. */
+                    tcp_stream<char> closed(engine_, network_operation::kNoDescriptor);
+                    closed_sent_  = co_await send_file(file, closed, 0, kTailSize);
+                    closed_error_ = closed.last_error();
+
+                    co_await file.close();
+                }
+
+                ::unlink(path_.c_str());
+
+                ::shutdown(_stream.descriptor(), SHUT_WR);
+                co_await _stream.close();
+            }
+
+            async_function<>
+            run_receiver(tcp_stream<char> _stream)
+            {
+                std::vector<char> received(kLength + kTailSize + 1);
+                auto              read = co_await _stream.read(received);
+                received.resize(kLength + kTailSize);
+
+                std::vector<char> wanted(
+                    contents_.begin() + kOffset,
+                    contents_.begin() + kOffset + kLength);
+                wanted.insert(wanted.end(), contents_.end() - kTailSize, contents_.end());
+
+                co_await _stream.close();
+
+                failed_ = expected((long long) (kLength + kTailSize), read) ||
+                          expected((long long) kLength, sent_) ||
+                          expected((long long) kTailSize, tail_sent_) ||
+                          expected(true, received == wanted) || expected(0, stream_error_) ||
+                          expected(-1ll, closed_sent_) || expected(EBADF, closed_error_);
+
+                engine_->stop();
+            }
+
+            bool
+            failed()
+            {
+                return failed_;
+            }
+
+        private:
+
+            std::string       path_;
+            std::vector<char> contents_;
+            long long         sent_         = 0;
+            long long         tail_sent_    = 0;
+            long long         closed_sent_  = 0;
+            int               stream_error_ = -1;
+            int               closed_error_ = 0;
+            bool              failed_       = true;
+    };
+
+    int
+    test_send_file()
+    {
+        engine engine(engine::configs{.threads_ = 1});
+
+        test_send_file_class test;
+
+        test.register_engine(engine);
+
+        engine.start();
+
+        return test.failed();
+    }
+
+}   // namespace zab::test
+
+int
+main()
+{
+    return zab::test::run_test();
+}
@@ -0,0 +1,195 @@
+/*
+ *  MMM"""AMV       db      `7MM"""Yp,
+ *  M'   AMV       ;MM:       MM    Yb
+ *  '   AMV       ,V^MM.      MM    dP
+ *     AMV       ,M  `MM      MM"""bg.
+ *    AMV   ,    AbmmmqMA     MM    `Y
+ *   AMV   ,M   A'     VML    MM    ,9
+ *  AMVmmmmMM .AMA.   .AMMA..JMMmmmd9
+ *
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021 Donald-Rupin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ *  @file test-timer_service.cpp
+ *
+ */
+
+#include <chrono>
+#include <cstdint>
+
+#include "zab/async_function.hpp"
+#include "zab/engine.hpp"
+#include "zab/engine_enabled.hpp"
+#include "zab/timer_service.hpp"
+
+#include "internal/macros.hpp"
+
+namespace zab::test {
+
+    int
+    test_wait();
+
+    int
+    test_wait_zero();
+
+    int
+    run_test()
+    {
+        return test_wait() || test_wait_zero();
+    }
+
+    class test_wait_class : public engine_enabled<test_wait_class> {
+
+        public:
+
+            static constexpr auto kDefaultThread = 0;
+
+            static constexpr std::uint64_t kWait = 20'000'000;
+
+            void
+            initialise() noexcept
+            {
+                run();
+            }
+
+            async_function<>
+            run() noexcept
+            {
+                auto start = std::chrono::steady_clock::now();
+                co_await engine_->get_timer().wait(kWait);
+                auto same_thread = elapsed(start);
+                auto same_id     = engine_->current_id();
+
+                start = std::chrono::steady_clock::now();
+                co_await engine_->get_timer().wait(kWait, thread_t{1});
+                auto other_thread = elapsed(start);
+                auto other_id     = engine_->current_id();
+
+                failed_ = expected(true, same_thread >= kWait) ||
+                          expected(kDefaultThread, same_id.thread_) ||
+                          expected(true, other_thread >= kWait) || expected(1, other_id.thread_);
+
+                engine_->stop();
+            }
+
+            std::uint64_t
+            elapsed(std::chrono::steady_clock::time_point _start) const noexcept
+            {
+                return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                           std::chrono::steady_clock::now() - _start)
+                    .count();
+            }
+
+            bool
+            failed()
+            {
+                return failed_;
+            }
+
+        private:
+
+            bool failed_ = true;
+    };
+
+    int
+    test_wait()
+    {
+        engine engine(engine::configs{2, engine::configs::kExact});
+
+        test_wait_class test;
+
+        test.register_engine(engine);
+
+        engine.start();
+
+        return test.failed();
+    }
+
+    class test_wait_zero_class : public engine_enabled<test_wait_zero_class> {
+
+        public:
+
+            static constexpr auto kDefaultThread = 0;
+
+            void
+            initialise() noexcept
+            {
+                run();
+            }
+
+            async_function<>
+            run() noexcept
+            {
+                /* Anything that suspends lets the yielded marker run first. */
+                marker();
+                co_await engine_->get_timer().wait(0);
+                auto suspended = ran_;
+
+                co_await engine_->get_timer().wait(0, thread_t{kDefaultThread});
+                suspended = suspended || ran_;
+
+                failed_ = expected(false, suspended);
+
+                engine_->stop();
+            }
+
+            async_function<>
+            marker() noexcept
+            {
+                co_await yield();
+                ran_ = true;
+            }
+
+            bool
+            failed()
+            {
+                return failed_;
+            }
+
+        private:
+
+            bool ran_    = false;
+            bool failed_ = true;
+    };
+
+    int
+    test_wait_zero()
+    {
+        engine engine(engine::configs{1, engine::configs::kExact});
+
+        test_wait_zero_class test;
+
+        test.register_engine(engine);
+
+        engine.start();
+
+        return test.failed();
+    }
+
+}   // namespace zab::test
+
+int
+main()
+{
+    return zab::test::run_test();
+}
@@ -0,0 +1,218 @@
+/*
+ *  MMM"""AMV       db      `7MM"""Yp,
+ *  M'   AMV       ;MM:       MM    Yb
+ *  '   AMV       ,V^MM.      MM    dP
+ *     AMV       ,M  `MM      MM"""bg.
+ *    AMV   ,    AbmmmqMA     MM    `Y
+ *   AMV   ,M   A'     VML    MM    ,9
+ *  AMVmmmmMM .AMA.   .AMMA..JMMmmmd9
+ *
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021 Donald-Rupin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ *  @file test-topology.cpp
+ *
+ */
+
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <linux/mempolicy.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <vector>
+
+#include "zab/engine.hpp"
+#include "zab/topology.hpp"
+
+#include "internal/macros.hpp"
+
+namespace zab::test {
+
+    int
+    test_parse_cpu_list();
+
+    int
+    test_placement();
+
+    int
+    test_discover();
+
+    int
+    test_engine_placement();
+
+    int
+    test_numa_scope();
+
+    int
+    run_test()
+    {
+        return test_parse_cpu_list() || test_placement() || test_discover() ||
+               test_engine_placement() || test_numa_scope();
+    }
+
+    int
+    test_parse_cpu_list()
+    {
+        using list = std::vector<std::uint16_t>;
+
+        if (expected(list{0}, topology::parse_cpu_list("0\n"))) { return 1; }
+        if (expected(list({0, 1, 2, 3, 8, 10, 11}), topology::parse_cpu_list("0-3,8,10-11")))
+        {
+            return 1;
+        }
+        if (expected(list{}, topology::parse_cpu_list(""))) { return 1; }
+        if (expected(list{}, topology::parse_cpu_list("3-1"))) { return 1; }
+        if (expected(list{}, topology::parse_cpu_list("a"))) { return 1; }
+        if (expected(list{}, topology::parse_cpu_list("1,2-"))) { return 1; }
+
+        return 0;
+    }
+
+    int
+    test_placement()
+    {
+        /* 2 nodes, 2 cores each with 2 hardware threads. Siblings are numbered last. */
+        std::vector<cpu_info> cpus;
+        for (std::uint16_t cpu = 0; cpu < 8; ++cpu)
+        {
+            cpus.push_back(cpu_info{
+                .cpu_     = cpu,
+                .core_    = static_cast<std::uint16_t>(cpu % 4),
+                .package_ = static_cast<std::uint16_t>((cpu % 4) / 2),
+                .node_    = static_cast<std::uint16_t>((cpu % 4) / 2),
+                .smt_     = 0});
+        }
+
+        topology topo(cpus);
+
+        if (expected(2, topo.number_of_nodes())) { return 1; }
+
+        auto sibling = topo.find(7);
+        if (expected(true, sibling.has_value())) { return 1; }
+        if (expected(1, sibling->smt_)) { return 1; }
+        if (expected(1, sibling->node_)) { return 1; }
+
+        if (expected(false, topo.find(8).has_value())) { return 1; }
+
+        if (expected(std::vector<std::uint16_t>({0, 1, 2, 3, 4, 5, 6, 7}), topo.placement()))
+        {
+            return 1;
+        }
+
+        return 0;
+    }
+
+    int
+    test_discover()
+    {
+        auto topo = topology::discover();
+
+        if (expected(true, !topo.cpus().empty())) { return 1; }
+        if (expected(true, topo.number_of_nodes() > 0)) { return 1; }
+
+        cpu_set_t allowed;
+        CPU_ZERO(&allowed);
+        if (expected(0, ::sched_getaffinity(0, sizeof(allowed), &allowed))) { return 1; }
+
+        for (const auto& info : topo.cpus())
+        {
+            if (expected(true, topo.find(info.cpu_).has_value())) { return 1; }
+            if (expected(true, (bool) CPU_ISSET(info.cpu_, &allowed))) { return 1; }
+        }
+
+        if (expected(topo.cpus().size(), topo.placement().size())) { return 1; }
+
+        static constexpr std::size_t kSize = 1 << 16;
+        auto*                        ptr   = numa_allocate(kSize, topo.cpus().front().node_);
+        if (expected(true, ptr != nullptr)) { return 1; }
+
+        ::memset(ptr, 1, kSize);
+        numa_deallocate(ptr, kSize);
+
+        return 0;
+    }
+
+    int
+    test_engine_placement()
+    {
+        auto first = topology::discover().cpus().front().cpu_;
+
+        engine engine(engine::configs{
+            .threads_         = 2,
+            .opt_             = engine::configs::kExact,
+            .affinity_set_    = false,
+            .affinity_offset_ = 1,
+            .cpus_            = {first}});
+
+        if (expected(first, engine.worker_cpu(thread_t{0}))) { return 1; }
+        if (expected(first, engine.worker_cpu(thread_t{1}))) { return 1; }
+
+        if (expected(
+                engine.get_topology().find(first)->node_,
+                engine.worker_node(thread_t{1})))
+        {
+            return 1;
+        }
+
+        return 0;
+    }
+
+    int
+    test_numa_scope()
+    {
+        unsigned long mask = 1;
+        int           mode = MPOL_DEFAULT;
+
+        /* Stand in for `numactl --interleave`, skipping kernels without NUMA support. */
+        if (::syscall(SYS_set_mempolicy, MPOL_INTERLEAVE, &mask, sizeof(mask) * CHAR_BIT + 1))
+        {
+            return 0;
+        }
+
+        {
+            /* Claim two nodes so the scope applies its own policy. */
+            numa_scope scope(0, 2);
+        }
+
+        mask = 0;
+        auto failed =
+            ::syscall(SYS_get_mempolicy, &mode, &mask, sizeof(mask) * CHAR_BIT, nullptr, 0);
+
+        ::syscall(SYS_set_mempolicy, MPOL_DEFAULT, nullptr, 0);
+
+        if (expected(0l, failed)) { return 1; }
+        if (expected(MPOL_INTERLEAVE, mode)) { return 1; }
+        if (expected(1ul, mask)) { return 1; }
+
+        return 0;
+    }
+
+}   // namespace zab::test
+
+int
+main()
+{
+    return zab::test::run_test();
+}
@@ -0,0 +1,273 @@
+/*
+ *  MMM"""AMV       db      `7MM"""Yp,
+ *  M'   AMV       ;MM:       MM    Yb
+ *  '   AMV       ,V^MM.      MM    dP
+ *     AMV       ,M  `MM      MM"""bg.
+ *    AMV   ,    AbmmmqMA     MM    `Y
+ *   AMV   ,M   A'     VML    MM    ,9
+ *  AMVmmmmMM .AMA.   .AMMA..JMMmmmd9
+ *
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021 Donald-Rupin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ *  @file test-tracing.cpp
+ *
+ */
+
+#include <sstream>
+#include <string>
+
+#include "zab/async_function.hpp"
+#include "zab/engine.hpp"
+#include "zab/engine_enabled.hpp"
+#include "zab/simple_future.hpp"
+#include "zab/tracing.hpp"
+
+#include "internal/macros.hpp"
+
+namespace zab::test {
+
+    int
+    test_api();
+
+    int
+    test_engine_trace();
+
+    int
+    test_cross_loop_wake();
+
+    int
+    run_test()
+    {
+        return test_api() || test_engine_trace() || test_cross_loop_wake();
+    }
+
+    std::string
+    dump_string()
+    {
+        std::stringstream ss;
+        tracing::dump(ss);
+        return ss.str();
+    }
+
+    bool
+    contains(const std::string& _haystack, const std::string& _needle)
+    {
+        return _haystack.find(_needle) != std::string::npos;
+    }
+
+    int
+    test_api()
+    {
+        int id = 0;
+
+        /* Nothing is recorded until enabled. */
+        tracing::begin("before", &id);
+        tracing::end(&id);
+
+        tracing::enable(16);
+
+        tracing::begin("slice", &id);
+        tracing::instant("point", &id, 42);
+        tracing::end(&id);
+
+        tracing::disable();
+
+        tracing::instant("after", &id);
+
+        auto trace = dump_string();
+
+        if (expected(false, contains(trace, "before") || contains(trace, "after"))) { return 1; }
+
+        if constexpr (kTracing)
+        {
+            if (expected(true, contains(trace, "\"ph\":\"B\"")) ||
+                expected(true, contains(trace, "\"ph\":\"E\"")) ||
+                expected(true, contains(trace, "\"name\":\"slice\"")) ||
+                expected(true, contains(trace, "\"value\":42")))
+            {
+                return 1;
+            }
+
+            /* The ring keeps the newest entries. */
+            tracing::enable(16);
+            for (int i = 0; i < 100; ++i)
+            {
+                tracing::instant("wrap", &id, i);
+            }
+            tracing::disable();
+
+            trace = dump_string();
+            if (expected(false, contains(trace, "\"value\":42")) ||
+                expected(true, contains(trace, "\"value\":99")))
+            {
+                return 1;
+            }
+        }
+        else
+        {
+            if (expected(false, contains(trace, "\"ph\""))) { return 1; }
+        }
+
+        tracing::clear();
+
+        if (expected(false, contains(dump_string(), "\"ph\""))) { return 1; }
+
+        return 0;
+    }
+
+    class test_engine_trace_class : public engine_enabled<test_engine_trace_class> {
+
+        public:
+
+            static constexpr auto kDefaultThread = 0;
+
+            void
+            initialise() noexcept
+            {
+                run();
+            }
+
+            async_function<>
+            run() noexcept
+            {
+                co_await yield(thread_t{1});
+                co_await child();
+                co_await yield(thread_t{0});
+
+                engine_->stop();
+            }
+
+            simple_future<int>
+            child() noexcept
+            {
+                co_await yield(thread_t{0});
+                co_return 1;
+            }
+    };
+
+    int
+    test_engine_trace()
+    {
+        tracing::enable();
+
+        engine engine(engine::configs{
+            .threads_         = 2,
+            .opt_             = engine::configs::kExact,
+            .affinity_set_    = false,
+            .affinity_offset_ = 0});
+
+        test_engine_trace_class test;
+        test.register_engine(engine);
+
+        engine.start();
+
+        tracing::disable();
+
+        auto trace = dump_string();
+
+        if constexpr (kTracing)
+        {
+            if (expected(true, contains(trace, "\"name\":\"resume\"")) ||
+                expected(true, contains(trace, "\"name\":\"hop\"")) ||
+                expected(true, contains(trace, "\"name\":\"simple_promise\"")) ||
+                expected(true, contains(trace, "\"name\":\"async_function\"")) ||
+                expected(true, contains(trace, "\"name\":\"read\"")) ||
+                expected(true, contains(trace, "\"name\":\"complete\"")) ||
+                expected(true, contains(trace, "\"name\":\"zab worker 1\"")))
+            {
+                return 1;
+            }
+        }
+        else
+        {
+            if (expected(false, contains(trace, "\"ph\""))) { return 1; }
+        }
+
+        return 0;
+    }
+
+    class test_cross_loop_wake_class : public engine_enabled<test_cross_loop_wake_class> {
+
+        public:
+
+            static constexpr auto kDefaultThread = 0;
+
+            static constexpr auto kWakes = 8;
+
+            void
+            initialise() noexcept
+            {
+                run();
+            }
+
+            async_function<>
+            run() noexcept
+            {
+                auto& from = engine_->get_event_loop();
+                for (int i = 0; i < kWakes; ++i)
+                {
+                    engine_->get_event_loop(thread_t{1}).wake(from);
+                }
+
+                /* The writes complete on this loop, make sure they have. */
+                co_await yield(thread_t{1});
+                co_await yield(thread_t{0});
+
+                engine_->stop();
+            }
+    };
+
+    int
+    test_cross_loop_wake()
+    {
+        tracing::enable();
+
+        engine engine(engine::configs{
+            .threads_         = 2,
+            .opt_             = engine::configs::kExact,
+            .affinity_set_    = false,
+            .affinity_offset_ = 0});
+
+        test_cross_loop_wake_class test;
+        test.register_engine(engine);
+
+        engine.start();
+
+        tracing::disable();
+
+        if constexpr (kTracing)
+        {
+            if (expected(true, contains(dump_string(), "\"name\":\"wake\""))) { return 1; }
+        }
+
+        return 0;
+    }
+
+}   // namespace zab::test
+
+int
+main()
+{
+    return zab::test::run_test();
+}
@@ -0,0 +1,526 @@
+/*
+ *  MMM"""AMV       db      `7MM"""Yp,
+ *  M'   AMV       ;MM:       MM    Yb
+ *  '   AMV       ,V^MM.      MM    dP
+ *     AMV       ,M  `MM      MM"""bg.
+ *    AMV   ,    AbmmmqMA     MM    `Y
+ *   AMV   ,M   A'     VML    MM    ,9
+ *  AMVmmmmMM .AMA.   .AMMA..JMMmmmd9
+ *
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021 Donald-Rupin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ *  @file test-udp_networking.cpp
+ *
+ */
+
+#include <cstdint>
+#include <cstring>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <vector>
+
+#include "zab/engine.hpp"
+#include "zab/engine_enabled.hpp"
+#include "zab/udp_networking.hpp"
+
+#include "internal/macros.hpp"
+
+namespace zab::test {
+
+    int
+    test_message();
+
+    int
+    test_multishot();
+
+    int
+    test_cancel_in_handler();
+
+    int
+    test_recycle_sq_full();
+
+    int
+    run_test()
+    {
+        return test_message() || test_multishot() || test_cancel_in_handler() ||
+               test_recycle_sq_full();
+    }
+
+    struct sockaddr_in
+    loopback(std::uint16_t _port)
+    {
+        struct sockaddr_in address;
+        ::memset(&address, 0, sizeof(address));
+        address.sin_family      = AF_INET;
+        address.sin_port        = ::htons(_port);
+        address.sin_addr.s_addr = ::htonl(INADDR_LOOPBACK);
+        return address;
+    }
+
+    class test_message_class : public engine_enabled<test_message_class> {
+
+        public:
+
+            static constexpr auto kDefaultThread = 0;
+
+            void
+            initialise() noexcept
+            {
+                run();
+            }
+
+            async_function<>
+            run()
+            {
+                udp_socket sender(engine_);
+                udp_socket receiver(engine_);
+
+                if (expected(true, sender.bind(AF_INET, 0)) ||
+                    expected(true, receiver.bind(AF_INET, 0)))
+                {
+                    engine_->stop();
+                    co_return;
+                }
+
+                auto to = loopback(receiver.port());
+
+                std::vector<std::byte> payload(5, std::byte{'z'});
+                auto                   sent =
+                    co_await sender.send_to(payload, (struct sockaddr*) &to, sizeof(to));
+
+                std::vector<std::byte>  buffer(64);
+                struct sockaddr_storage from;
+                struct iovec            vector{.iov_base = buffer.data(), .iov_len = buffer.size()};
+                struct msghdr           message;
+                ::memset(&message, 0, sizeof(message));
+                message.msg_name    = &from;
+                message.msg_namelen = sizeof(from);
+                message.msg_iov     = &vector;
+                message.msg_iovlen  = 1;
+
+                auto received = co_await receiver.recv_msg(&message);
+
+                if (expected(5, sent) || expected(5, received) ||
+                    expected(sender.port(), ::ntohs(((struct sockaddr_in*) &from)->sin_port)) ||
+                    expected(std::byte{'z'}, buffer[4]))
+                {
+                    engine_->stop();
+                    co_return;
+                }
+
+                /* A connected socket needs no destination. */
+                auto back = loopback(sender.port());
+                if (expected(true, receiver.connect((struct sockaddr*) &back, sizeof(back))))
+                {
+                    engine_->stop();
+                    co_return;
+                }
+
+                sent = co_await receiver.send_to(payload);
+
+                message.msg_namelen = sizeof(from);
+                received            = co_await sender.recv_msg(&message);
+
+                failed_ = expected(5, sent) || expected(5, received);
+
+                co_await sender.close();
+                co_await receiver.close();
+
+                engine_->stop();
+            }
+
+            bool
+            failed()
+            {
+                return failed_;
+            }
+
+        private:
+
+            bool failed_ = true;
+    };
+
+    int
+    test_message()
+    {
+        engine engine(engine::configs{.threads_ = 1});
+
+        test_message_class test;
+
+        test.register_engine(engine);
+
+        engine.start();
+
+        return test.failed();
+    }
+
+    class test_multishot_class : public engine_enabled<test_multishot_class> {
+
+        public:
+
+            static constexpr auto kDefaultThread = 0;
+
+            /* More datagrams than buffers, so the receive has to be rearmed. */
+            static constexpr std::size_t kDatagrams = 64;
+
+            static constexpr std::size_t kSize = 100;
+
+            static constexpr std::uint16_t kBuffers = 8;
+
+            test_multishot_class(bool _gro) : gro_(_gro) { }
+
+            void
+            initialise() noexcept
+            {
+                run();
+            }
+
+            async_function<>
+            run()
+            {
+                udp_socket   sender(engine_);
+                udp_socket   receiver(engine_);
+                buffer_group buffers(engine_, kBuffers, udp_socket::kReceiveOverhead + 64 * 1024);
+
+                if (expected(true, sender.bind(AF_INET, 0)) ||
+                    expected(true, receiver.bind(AF_INET, 0)) ||
+                    expected(true, receiver.set_gro(gro_)) ||
+                    expected(true, co_await buffers.provide()))
+                {
+                    engine_->stop();
+                    co_return;
+                }
+
+                send(sender, receiver.port());
+
+                std::size_t datagrams = 0;
+                std::size_t bytes     = 0;
+                bool        truncated = false;
+
+                auto error = co_await receiver.receive(
+                    buffers,
+                    [&](const datagram& _datagram) noexcept
+                    {
+                        auto size = _datagram.data_.size();
+                        bytes += size;
+                        truncated |= _datagram.truncated_;
+                        datagrams += _datagram.segment_size_
+                                         ? (size + _datagram.segment_size_ - 1) /
+                                               _datagram.segment_size_
+                                         : 1;
+
+                        if (datagrams == kDatagrams) { stop(receiver); }
+                    });
+
+                co_await buffers.release();
+
+                failed_ = expected(ECANCELED, error) || expected(kDatagrams, datagrams) ||
+                          expected(kDatagrams * kSize, bytes) || expected(false, truncated);
+
+                co_await sender.close();
+                co_await receiver.close();
+
+                engine_->stop();
+            }
+
+            async_function<>
+            send(udp_socket& _sender, std::uint16_t _port)
+            {
+                auto to = loopback(_port);
+
+                /* Half of them in one UDP_SEGMENT send, the rest one at a time. */
+                std::vector<std::byte> payload(kDatagrams / 2 * kSize, std::byte{'u'});
+                co_await _sender.send_to(payload, (struct sockaddr*) &to, sizeof(to), kSize);
+
+                for (std::size_t i = 0; i < kDatagrams / 2; ++i)
+                {
+                    co_await _sender.send_to(
+                        std::span<const std::byte>(payload).first(kSize),
+                        (struct sockaddr*) &to,
+                        sizeof(to));
+                }
+            }
+
+            async_function<>
+            stop(udp_socket& _receiver)
+            {
+                /* Runs inside the handler, which may be between multishot operations. */
+                co_await _receiver.cancel();
+            }
+
+            bool
+            failed()
+            {
+                return failed_;
+            }
+
+        private:
+
+            bool gro_;
+            bool failed_ = true;
+    };
+
+    int
+    test_multishot()
+    {
+        for (auto gro : {false, true})
+        {
+            engine engine(engine::configs{.threads_ = 1});
+
+            test_multishot_class test(gro);
+
+            test.register_engine(engine);
+
+            engine.start();
+
+            if (test.failed()) { return 1; }
+        }
+
+        return 0;
+    }
+
+    class test_cancel_in_handler_class : public engine_enabled<test_cancel_in_handler_class> {
+
+        public:
+
+            static constexpr auto kDefaultThread = 0;
+
+            static constexpr std::uint16_t kBuffers = 4;
+
+            /* Twice the buffers, so the multishot has already ended with ENOBUFS by the time the
+             * handler sees the last buffer. */
+            static constexpr std::size_t kDatagrams = 2 * kBuffers;
+
+            void
+            initialise() noexcept
+            {
+                run();
+            }
+
+            async_function<>
+            run()
+            {
+                udp_socket   sender(engine_);
+                udp_socket   receiver(engine_);
+                buffer_group buffers(engine_, kBuffers, udp_socket::kReceiveOverhead + 1024);
+
+                if (expected(true, sender.bind(AF_INET, 0)) ||
+                    expected(true, receiver.bind(AF_INET, 0)) ||
+                    expected(true, co_await buffers.provide()))
+                {
+                    engine_->stop();
+                    co_return;
+                }
+
+                auto                   to = loopback(receiver.port());
+                std::vector<std::byte> payload(64, std::byte{'c'});
+                for (std::size_t i = 0; i < kDatagrams; ++i)
+                {
+                    co_await sender.send_to(payload, (struct sockaddr*) &to, sizeof(to));
+                }
+
+                std::size_t datagrams = 0;
+
+                auto error = co_await receiver.receive(
+                    buffers,
+                    [&](const datagram&) noexcept
+                    {
+                        if (++datagrams >= kBuffers) { stop(receiver); }
+                    });
+
+                co_await buffers.release();
+
+                failed_ = expected(ECANCELED, error) ||
+                          expected(ECANCELED, receiver.last_error()) ||
+                          expected((std::size_t) kBuffers, datagrams);
+
+                co_await sender.close();
+                co_await receiver.close();
+
+                engine_->stop();
+            }
+
+            async_function<>
+            stop(udp_socket& _receiver)
+            {
+                co_await _receiver.cancel();
+            }
+
+            bool
+            failed()
+            {
+                return failed_;
+            }
+
+        private:
+
+            bool failed_ = true;
+    };
+
+    int
+    test_cancel_in_handler()
+    {
+        engine engine(engine::configs{.threads_ = 1});
+
+        test_cancel_in_handler_class test;
+
+        test.register_engine(engine);
+
+        engine.start();
+
+        return test.failed();
+    }
+
+    class test_recycle_sq_full_class : public engine_enabled<test_recycle_sq_full_class> {
+
+        public:
+
+            static constexpr auto kDefaultThread = 0;
+
+            static constexpr std::uint16_t kBuffers = 2;
+
+            /* Every other recycle fails, so the group runs dry unless failed recycles are
+             * retried. */
+            static constexpr std::size_t kDatagrams = 4 * kBuffers;
+
+            void
+            initialise() noexcept
+            {
+                run();
+            }
+
+            async_function<>
+            run()
+            {
+                udp_socket   sender(engine_);
+                udp_socket   receiver(engine_);
+                buffer_group buffers(engine_, kBuffers, udp_socket::kReceiveOverhead + 1024);
+
+                if (expected(true, sender.bind(AF_INET, 0)) ||
+                    expected(true, receiver.bind(AF_INET, 0)) ||
+                    expected(true, co_await buffers.provide()))
+                {
+                    engine_->stop();
+                    co_return;
+                }
+
+                auto                   to = loopback(receiver.port());
+                std::vector<std::byte> payload(64, std::byte{'f'});
+                co_await sender.send_to(payload, (struct sockaddr*) &to, sizeof(to));
+
+                auto&       loop      = engine_->get_event_loop();
+                auto        before    = loop.metrics().sq_full_;
+                std::size_t datagrams = 0;
+
+                auto error = co_await receiver.receive(
+                    buffers,
+                    [&](const datagram&) noexcept
+                    {
+                        if (++datagrams == kDatagrams)
+                        {
+                            stop(receiver);
+                            return;
+                        }
+
+                        /* Leave no room for the recycle that follows the handler. */
+                        if (datagrams % 2) { fill(loop); }
+
+                        (void) ::sendto(
+                            sender.descriptor(),
+                            payload.data(),
+                            payload.size(),
+                            0,
+                            (struct sockaddr*) &to,
+                            sizeof(to));
+                    });
+
+                auto full = loop.metrics().sq_full_ - before;
+
+                co_await buffers.release();
+
+                failed_ = expected(ECANCELED, error) || expected(kDatagrams, datagrams) ||
+                          expected(true, full >= kDatagrams / 2);
+
+                co_await sender.close();
+                co_await receiver.close();
+
+                engine_->stop();
+            }
+
+            void
+            fill(event_loop& _loop)
+            {
+                auto full = _loop.metrics().sq_full_;
+                while (_loop.metrics().sq_full_ == full)
+                {
+                    _loop.write(&filler_, -1, std::span<const std::byte>{}, 0);
+                }
+            }
+
+            async_function<>
+            stop(udp_socket& _receiver)
+            {
+                co_await _receiver.cancel();
+            }
+
+            bool
+            failed()
+            {
+                return failed_;
+            }
+
+        private:
+
+            static void
+            ignore(void*) noexcept
+            { }
+
+            event_loop::io_event filler_{
+                .handle_ = event<>{.cb_ = &ignore, .context_ = nullptr},
+                .result_ = 0};
+
+            bool failed_ = true;
+    };
+
+    int
+    test_recycle_sq_full()
+    {
+        engine engine(engine::configs{.threads_ = 1});
+
+        test_recycle_sq_full_class test;
+
+        test.register_engine(engine);
+
+        engine.start();
+
+        return test.failed();
+    }
+
+}   // namespace zab::test
+
+int
+main()
+{
+    return zab::test::run_test();
+}
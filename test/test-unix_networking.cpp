@@ -0,0 +1,290 @@
+/*
+ *  MMM"""AMV       db      `7MM"""Yp,
+ *  M'   AMV       ;MM:       MM    Yb
+ *  '   AMV       ,V^MM.      MM    dP
+ *     AMV       ,M  `MM      MM"""bg.
+ *    AMV   ,    AbmmmqMA     MM    `Y
+ *   AMV   ,M   A'     VML    MM    ,9
+ *  AMVmmmmMM .AMA.   .AMMA..JMMmmmd9
+ *
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021 Donald-Rupin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ *  @file test-unix_networking.cpp
+ *
+ */
+
+#include <cstring>
+#include <fcntl.h>
+#include <string>
+#include <string_view>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+#include "zab/engine.hpp"
+#include "zab/engine_enabled.hpp"
+#include "zab/unix_networking.hpp"
+
+#include "internal/macros.hpp"
+
+namespace zab::test {
+
+    int
+    test_stream();
+
+    int
+    test_seqpacket();
+
+    int
+    test_descriptors();
+
+    int
+    run_test()
+    {
+        return test_stream() || test_seqpacket() || test_descriptors();
+    }
+
+    /* Abstract names need no cleaning up. */
+    std::string
+    abstract_path(std::string_view _name)
+    {
+        std::string path(1, '\0');
+        path += "zab-test-";
+        path += _name;
+        path += std::to_string(::getpid());
+        return path;
+    }
+
+    class test_stream_class : public engine_enabled<test_stream_class> {
+
+        public:
+
+            static constexpr auto kDefaultThread = 0;
+
+            static constexpr std::string_view kMessage = "01234";
+
+            test_stream_class(int _type) : type_(_type), path_(abstract_path("stream")) { }
+
+            void
+            initialise() noexcept
+            {
+                acceptor_.register_engine(engine_);
+
+                if (expected(true, acceptor_.listen(path_, 10, type_)))
+                {
+                    engine_->stop();
+                    return;
+                }
+
+                run_acceptor();
+                run_connector();
+            }
+
+            async_function<>
+            run_acceptor()
+            {
+                auto stream = co_await acceptor_.accept<char>();
+                if (!stream)
+                {
+                    engine_->stop();
+                    co_return;
+                }
+
+                /* Two messages, which a seqpacket socket keeps apart. */
+                co_await stream->write(std::span<const char>(kMessage));
+                co_await stream->write(std::span<const char>(kMessage));
+
+                std::vector<char> buffer(1);
+                co_await stream->read_some(buffer);
+                co_await stream->close();
+            }
+
+            async_function<>
+            run_connector()
+            {
+                auto stream = co_await unix_connect<char>(engine_, path_, type_);
+                if (expected(0, stream.last_error()))
+                {
+                    engine_->stop();
+                    co_return;
+                }
+
+                std::vector<char> buffer(kMessage.size() * 2);
+                if (type_ == SOCK_SEQPACKET)
+                {
+                    auto first  = co_await stream.read_some(buffer);
+                    auto second = co_await stream.read_some(buffer, first);
+
+                    failed_ = expected((int) kMessage.size(), first) ||
+                              expected((int) kMessage.size(), second);
+                }
+                else
+                {
+                    auto amount = co_await stream.read(buffer);
+                    failed_     = expected((long long) buffer.size(), amount);
+                }
+
+                failed_ = failed_ || expected(kMessage, std::string_view(buffer.data(), 5));
+
+                co_await stream.write(std::span<const char>(kMessage).first(1));
+                co_await stream.close();
+                co_await acceptor_.close();
+
+                engine_->stop();
+            }
+
+            bool
+            failed()
+            {
+                return failed_;
+            }
+
+        private:
+
+            int           type_;
+            std::string   path_;
+            unix_acceptor acceptor_;
+            bool          failed_ = true;
+    };
+
+    int
+    run_stream_test(int _type)
+    {
+        engine engine(engine::configs{.threads_ = 1});
+
+        test_stream_class test(_type);
+
+        test.register_engine(engine);
+
+        engine.start();
+
+        return test.failed();
+    }
+
+    int
+    test_stream()
+    {
+        return run_stream_test(SOCK_STREAM);
+    }
+
+    int
+    test_seqpacket()
+    {
+        return run_stream_test(SOCK_SEQPACKET);
+    }
+
+    class test_descriptors_class : public engine_enabled<test_descriptors_class> {
+
+        public:
+
+            static constexpr auto kDefaultThread = 0;
+
+            void
+            initialise() noexcept
+            {
+                run();
+            }
+
+            async_function<>
+            run()
+            {
+                int pair[2];
+                int pipe[2];
+                if (::socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, pair) ||
+                    ::pipe2(pipe, O_CLOEXEC))
+                {
+                    engine_->stop();
+                    co_return;
+                }
+
+                unix_stream<char> sender(engine_, pair[0]);
+                unix_stream<char> receiver(engine_, pair[1]);
+
+                /* Hand over the write end of the pipe. */
+                char tag  = 'p';
+                auto sent = co_await send_descriptors(
+                    sender,
+                    std::span<const char>(&tag, 1),
+                    std::span<const int>(&pipe[1], 1));
+
+                ::close(pipe[1]);
+
+                char data = 0;
+                int  fds[1];
+                auto received =
+                    co_await receive_descriptors(receiver, std::span<char>(&data, 1), fds);
+
+                if (expected(1, sent) || expected(1, received.bytes_) ||
+                    expected((std::size_t) 1, received.count_) || expected('p', data))
+                {
+                    engine_->stop();
+                    co_return;
+                }
+
+                /* The passed descriptor writes to the same pipe. */
+                char out = 'x';
+                char in  = 0;
+                if (::write(fds[0], &out, 1) == 1) { ::close(fds[0]); }
+
+                failed_ = expected(1, (int) ::read(pipe[0], &in, 1)) || expected('x', in);
+                ::close(pipe[0]);
+
+                co_await sender.close();
+                co_await receiver.close();
+
+                engine_->stop();
+            }
+
+            bool
+            failed()
+            {
+                return failed_;
+            }
+
+        private:
+
+            bool failed_ = true;
+    };
+
+    int
+    test_descriptors()
+    {
+        engine engine(engine::configs{.threads_ = 1});
+
+        test_descriptors_class test;
+
+        test.register_engine(engine);
+
+        engine.start();
+
+        return test.failed();
+    }
+
+}   // namespace zab::test
+
+int
+main()
+{
+    return zab::test::run_test();
+}
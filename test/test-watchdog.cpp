@@ -0,0 +1,181 @@
+/*
+ *  MMM"""AMV       db      `7MM"""Yp,
+ *  M'   AMV       ;MM:       MM    Yb
+ *  '   AMV       ,V^MM.      MM    dP
+ *     AMV       ,M  `MM      MM"""bg.
+ *    AMV   ,    AbmmmqMA     MM    `Y
+ *   AMV   ,M   A'     VML    MM    ,9
+ *  AMVmmmmMM .AMA.   .AMMA..JMMmmmd9
+ *
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021 Donald-Rupin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ *  @file test-watchdog.cpp
+ *
+ */
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "zab/async_function.hpp"
+#include "zab/engine.hpp"
+#include "zab/engine_enabled.hpp"
+#include "zab/watchdog.hpp"
+
+#include "internal/macros.hpp"
+
+namespace zab::test {
+
+    int
+    test_step_monitor();
+
+    int
+    test_stall();
+
+    int
+    run_test()
+    {
+        return test_step_monitor() || test_stall();
+    }
+
+    int
+    test_step_monitor()
+    {
+        static constexpr std::uint64_t kSteps = 1000000;
+
+        details::step_monitor monitor;
+
+        auto first = monitor.read();
+        if (expected(std::uint64_t{0}, first.started_)) { return 1; }
+
+        /* Each step is tagged with its start time, so a torn read pairs mismatched values. */
+        std::atomic<bool> done = false;
+        std::thread       loop(
+            [&monitor, &done]
+            {
+                for (std::uint64_t i = 1; i <= kSteps; ++i)
+                {
+                    monitor.begin(reinterpret_cast<const void*>(i), i);
+                    monitor.end();
+                }
+
+                done = true;
+            });
+
+        bool consistent = true;
+        while (!done)
+        {
+            auto sample = monitor.read();
+            if (!sample.started_) { continue; }
+
+            consistent &= sample.coroutine_ == reinterpret_cast<const void*>(sample.started_);
+            consistent &= sample.sequence_ % 2 == 0;
+        }
+
+        loop.join();
+
+        if (expected(true, consistent)) { return 1; }
+        if (expected(std::uint64_t{0}, monitor.read().started_)) { return 1; }
+
+        return 0;
+    }
+
+    class test_stall_class : public engine_enabled<test_stall_class> {
+
+        public:
+
+            static constexpr auto kDefaultThread = 0;
+
+            void
+            initialise() noexcept
+            {
+                run();
+            }
+
+            async_function<>
+            run() noexcept
+            {
+                /* Quick steps are never reported. */
+                for (int i = 0; i < 10; ++i)
+                {
+                    co_await yield();
+                }
+
+                /* Block the loop. */
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+                co_await yield();
+
+                engine_->stop();
+            }
+    };
+
+    int
+    test_stall()
+    {
+        static constexpr auto kThreshold = std::chrono::milliseconds(20);
+
+        std::mutex                mtx;
+        std::vector<stall_report> reports;
+
+        engine engine(engine::configs{
+            .threads_         = 1,
+            .opt_             = engine::configs::kExact,
+            .affinity_set_    = false,
+            .affinity_offset_ = 0,
+            .stall_threshold_ = kThreshold,
+            .stall_handler_ =
+                [&](const stall_report& _report)
+            {
+                std::scoped_lock lck(mtx);
+                reports.push_back(_report);
+            }});
+
+        test_stall_class test;
+        test.register_engine(engine);
+
+        engine.start();
+
+        std::scoped_lock lck(mtx);
+        if (expected(1u, reports.size())) { return 1; }
+
+        if (expected(0u, (unsigned) reports[0].loop_.thread_) ||
+            expected(true, reports[0].duration_ >= kThreshold) ||
+            expected(true, reports[0].coroutine_ != nullptr))
+        {
+            return 1;
+        }
+
+        return 0;
+    }
+
+}   // namespace zab::test
+
+int
+main()
+{
+    return zab::test::run_test();
+}